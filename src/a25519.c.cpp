@@ -61,6 +61,112 @@ int a25519_sig_verify(
 	return a25519::sig::verify(algotype,pbuffer, plen, mbuffer, mlen, obuffer, olen);
 }
 
+struct a25519_sigsess *a25519_sig_sign_init(
+	unsigned int algotype,
+	unsigned char *sbuffer, size_t slen
+){
+	return a25519::sig::sign_init(algotype, sbuffer, slen);
+}
+
+struct a25519_sigsess *a25519_sig_verify_init(
+	unsigned int algotype,
+	unsigned char *pbuffer, size_t plen
+){
+	return a25519::sig::verify_init(algotype, pbuffer, plen);
+}
+
+void a25519_sig_update(
+	struct a25519_sigsess *sess,
+	const unsigned char *mbuffer, size_t mlen
+){
+	a25519::sig::update(sess, mbuffer, mlen);
+}
+
+int a25519_sig_sign_final(
+	struct a25519_sigsess *sess,
+	unsigned char **obuffer, size_t *olen
+){
+	return a25519::sig::sign_final(sess, obuffer, olen);
+}
+
+int a25519_sig_verify_final(
+	struct a25519_sigsess *sess,
+	unsigned char *obuffer, size_t olen
+){
+	return a25519::sig::verify_final(sess, obuffer, olen);
+}
+
+void a25519_sig_free(struct a25519_sigsess *sess){
+	a25519::sig::sfree(sess);
+}
+
+int a25519_sig_sign_fd(
+	unsigned int algotype,
+	unsigned char *sbuffer, size_t slen,
+	int fd,
+	unsigned char **obuffer, size_t *olen
+){
+	return a25519::sig::sign_fd(algotype, sbuffer, slen, fd, obuffer, olen);
+}
+
+int a25519_sig_verify_fd(
+	unsigned int algotype,
+	unsigned char *pbuffer, size_t plen,
+	int fd,
+	unsigned char *obuffer, size_t olen
+){
+	return a25519::sig::verify_fd(algotype, pbuffer, plen, fd, obuffer, olen);
+}
+
+int a25519_sig_sign_batch(
+	unsigned int algotype,
+	unsigned char *sbuffer, size_t slen,
+	size_t count,
+	unsigned char **mbuffer, size_t *mlen,
+	unsigned char **obuffer, size_t *olen
+){
+	return a25519::sig::sign_batch(algotype, sbuffer, slen, count, mbuffer, mlen, obuffer, olen);
+}
+
+int a25519_sig_verify_batch(
+	unsigned int algotype,
+	unsigned char *pbuffer, size_t plen,
+	size_t count,
+	unsigned char **mbuffer, size_t *mlen,
+	unsigned char **obuffer, size_t *olen,
+	int *rc
+){
+	return a25519::sig::verify_batch(algotype, pbuffer, plen, count, mbuffer, mlen, obuffer, olen, rc);
+}
+
+int a25519_sig_sign_store(
+	unsigned int algotype,
+	unsigned char *sbuffer, size_t slen,
+	size_t count,
+	unsigned char **mbuffer, size_t *mlen,
+	size_t idmax, const char *path
+){
+	return a25519::sig::sign_store(algotype, sbuffer, slen, count, mbuffer, mlen, idmax, path);
+}
+
+int a25519_ibi_prove(
+	unsigned int algotype,
+	unsigned char *mbuffer, size_t mlen,
+	unsigned char *obuffer, size_t olen,
+	int csock
+){
+	return a25519::ibi::prove(algotype,mbuffer, mlen, obuffer, olen, csock);
+}
+
+int a25519_ibi_verify(
+	unsigned int algotype,
+	unsigned char *pbuffer, size_t plen,
+	unsigned char **mbuffer, size_t *mlen,
+	int csock
+){
+	return a25519::ibi::verify(algotype,pbuffer, plen, mbuffer, mlen, csock);
+}
+
 int a25519_ibi_oclient(
 	unsigned int algotype,
 	unsigned char *mbuffer, size_t mlen,
@@ -99,6 +205,125 @@ void a25519_ibi_server(
 	a25519::ibi::server(algotype,pbuffer, plen, port, timeout, maxcq, callback);
 }
 
+void a25519_ibi_srvopt_init(struct a25519_srvopt *opt){
+	a25519::ibi::srvopt_init(opt);
+}
+
+void a25519_ibi_pserver(
+	unsigned int algotype,
+	unsigned char *pbuffer, size_t plen,
+	int port, const struct a25519_srvopt *opt,
+	void (*callback)(int, int, const unsigned char *, size_t)
+){
+	a25519::ibi::pserver(algotype,pbuffer, plen, port, opt, callback);
+}
+
+int a25519_ibi_poolstat(struct a25519_poolstat *out){
+	return a25519::ibi::poolstat(out);
+}
+
+void a25519_ibi_metrics(struct a25519_metrics *out){
+	a25519::ibi::metrics(out);
+}
+
+unsigned long long a25519_ibi_metrics_bound(unsigned int bucket){
+	return a25519::ibi::metrics_bound(bucket);
+}
+
+unsigned long long a25519_ibi_metrics_pct(const struct a25519_mhist *h, double p){
+	return a25519::ibi::metrics_pct(h, p);
+}
+
+int a25519_trace(int on){
+	return a25519::trace(on);
+}
+
+size_t a25519_trace_dump(struct a25519_opevent *out, size_t max){
+	return a25519::trace_dump(out, max);
+}
+
+const char *a25519_trace_opname(unsigned int op){
+	return a25519::trace_opname(op);
+}
+
+int a25519_alloc_count(struct a25519_allocstat *out, int reset){
+	return a25519::alloc_count(out, reset);
+}
+
+int a25519_vcache(size_t bytes){
+	return a25519::vcache(bytes);
+}
+
+void a25519_vcache_stat(struct a25519_vcstat *out){
+	a25519::vcache_stat(out);
+}
+
+int a25519_nonce(int mode){
+	return a25519::nonce(mode);
+}
+
+int a25519_rng(int mode){
+	return a25519::rng(mode);
+}
+
+void a25519_randombytes(unsigned char *out, size_t len){
+	a25519::randombytes(out, len);
+}
+
+struct a25519_nbsess *a25519_ibi_nbprove(
+	unsigned int algotype,
+	unsigned char *mbuffer, size_t mlen,
+	unsigned char *obuffer, size_t olen,
+	int csock
+){
+	return a25519::ibi::nbprove(algotype, mbuffer, mlen, obuffer, olen, csock);
+}
+
+struct a25519_nbsess *a25519_ibi_nbverify(
+	unsigned int algotype,
+	unsigned char *pbuffer, size_t plen,
+	int csock
+){
+	return a25519::ibi::nbverify(algotype, pbuffer, plen, csock);
+}
+
+int a25519_ibi_nbstep(struct a25519_nbsess *sess){
+	return a25519::ibi::nbstep(sess);
+}
+
+int a25519_ibi_nbresult(
+	struct a25519_nbsess *sess,
+	const unsigned char **mbuffer, size_t *mlen
+){
+	return a25519::ibi::nbresult(sess, mbuffer, mlen);
+}
+
+void a25519_ibi_nbfree(struct a25519_nbsess *sess){
+	a25519::ibi::nbfree(sess);
+}
+
+struct a25519_cpool *a25519_ibi_cpool_new(
+	unsigned int algotype,
+	unsigned char *mbuffer, size_t mlen,
+	unsigned char *obuffer, size_t olen,
+	const char *srv, int port, int timeout,
+	size_t size, unsigned int maxage
+){
+	return a25519::ibi::cpool_new(algotype, mbuffer, mlen, obuffer, olen, srv, port, timeout, size, maxage);
+}
+
+int a25519_ibi_cpool_get(struct a25519_cpool *pool, unsigned int wait){
+	return a25519::ibi::cpool_get(pool, wait);
+}
+
+size_t a25519_ibi_cpool_ready(struct a25519_cpool *pool){
+	return a25519::ibi::cpool_ready(pool);
+}
+
+void a25519_ibi_cpool_free(struct a25519_cpool *pool){
+	a25519::ibi::cpool_free(pool);
+}
+
 int a25519_test_offline(
 	unsigned int algotype,
 	unsigned char *pbuffer, size_t plen,
@@ -128,3 +353,57 @@ void a25519_test_server(
 ){
 	a25519::test::server(algotype,pbuffer,plen,port,count);
 }
+
+//benchmark
+void a25519_test_benchopt_init(struct a25519_benchopt *opt){
+	a25519::test::benchopt_init(opt);
+}
+
+int a25519_test_bprove(
+	unsigned int algotype,
+	unsigned char *mbuffer, size_t mlen,
+	unsigned char *obuffer, size_t olen,
+	const char *srv, int port,
+	const struct a25519_benchopt *opt
+){
+	return a25519::test::bprove(algotype,mbuffer,mlen,obuffer,olen,srv,port,opt);
+}
+
+int a25519_test_bverify(
+	unsigned int algotype,
+	unsigned char *pbuffer, size_t plen,
+	int port,
+	const struct a25519_benchopt *opt
+){
+	return a25519::test::bverify(algotype,pbuffer,plen,port,opt);
+}
+
+int a25519_test_microbench(unsigned int count, int json,
+	unsigned long long (*allocs)(void)){
+	return a25519::test::microbench(count, json, allocs);
+}
+
+int a25519_test_inproc(unsigned int count, int json,
+	unsigned long long (*allocs)(void)){
+	return a25519::test::inproc(count, json, allocs);
+}
+
+int a25519_test_rtt(unsigned int count, int json,
+	const struct a25519_linkopt *lo){
+	return a25519::test::rtt(count, json, lo);
+}
+
+//load generator
+void a25519_test_loadopt_init(struct a25519_loadopt *opt){
+	a25519::test::loadopt_init(opt);
+}
+
+int a25519_test_loadgen(
+	unsigned int algotype,
+	unsigned char *mbuffer, size_t mlen,
+	unsigned char *obuffer, size_t olen,
+	const char *srv, int port,
+	const struct a25519_loadopt *opt
+){
+	return a25519::test::loadgen(algotype,mbuffer,mlen,obuffer,olen,srv,port,opt);
+}
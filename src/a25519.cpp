@@ -37,22 +37,60 @@
 #include "utils/debug.h"
 #include "utils/bufhelp.h"
 #include "utils/simplesock.h"
+#include "utils/mclock.h"
+#include "utils/hdrhist.h"
+#include "utils/usdt.h"
+#include "utils/alloccount.h"
+#include "utils/kstore.h"
 
 //internals
 #include "internals/proto.hpp"
 #include "internals/ifcall.hpp"
+#include "internals/evserver.hpp"
+#include "internals/nbsess.hpp"
+#include "internals/cpool.hpp"
+#include "internals/bench.hpp"
+#include "internals/loadgen.hpp"
+#include "internals/metrics.hpp"
+#include "internals/optrace.hpp"
+#include "internals/vcache.hpp"
+#include "internals/nonce.hpp"
+#include "internals/rng.hpp"
+
+#include <sodium.h>
 
 // standard lib
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <string>
 #include <time.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <cerrno>
 
 using namespace std;
 
+#define KS_CHUNK 1024	//keys extracted at once into a keystore
+#define SG_CHUNK 65536	//bytes of an ID read from a descriptor at once
+
+//non-blocking session handle, owns the parsed key
+struct a25519_nbsess{
+	struct nbsess::sess *s;
+	void *key;
+};
+
+//streamed signing or verification, the secret key (signing) or a copy of
+//the public key viewed in place (verification) and the ID absorbed so far
+struct a25519_sigsess{
+	unsigned int a;
+	void *key;
+	struct kview par;
+	struct sigstream ss;
+	unsigned char pbuf[];
+};
+
 namespace a25519
 {
 	//standard signatures
@@ -84,6 +122,51 @@ printf("pbuffer %lu: ",*plen); ucbprint(*pbuffer, *plen); printf("\n");
 		return 0;
 	}
 
+	//operation tracing
+	int trace(int on){
+		return optrace::enable(on);
+	}
+
+	size_t trace_dump(struct a25519_opevent *out, size_t max){
+		return optrace::drain(out, max);
+	}
+
+	const char *trace_opname(unsigned int op){
+		return optrace::opname(op);
+	}
+
+	int alloc_count(struct a25519_allocstat *out, int reset){
+		struct acount c;
+		int rc = ac_read(&c, reset);
+		if(out != NULL){
+			out->calls = c.calls;
+			out->bytes = c.bytes;
+			out->sodium_calls = c.scalls;
+			out->sodium_bytes = c.sbytes;
+		}
+		return rc;
+	}
+
+	int vcache(size_t bytes){
+		return vcache::resize(bytes);
+	}
+
+	void vcache_stat(struct a25519_vcstat *out){
+		vcache::stats(out);
+	}
+
+	int nonce(int mode){
+		return nonce::mode(mode);
+	}
+
+	int rng(int mode){
+		return rng::mode(mode);
+	}
+
+	void randombytes(unsigned char *out, size_t len){
+		rng::bytes(out, len);
+	}
+
 namespace sig{
 
 	int sign(
@@ -124,19 +207,272 @@ printf("obuffer %lu: ",*olen); ucbprint(*obuffer, *olen); printf("\n");
 		unsigned char *mbuffer, size_t mlen,
 		unsigned char *obuffer, size_t olen
 	){
-		int rc;
-		//obtain paramter (public key) and signature from serialize string
-		void *par;
-		void *sig;
-		iftable[a]->pubstruct(pbuffer, plen, &par);
-		iftable[a]->sigstruct(obuffer, olen, &sig);
+		//paramter (public key) and signature, parsed in place
+		struct kview par, sig;
+		if( iftable[a]->pubview(pbuffer, plen, &par) != 0 ||
+			iftable[a]->sigview(obuffer, olen, &sig) != 0 ){
+			lerror("Malformed public key or signature\n");
+			return 1;
+		}
+		return iftable[a]->signatchk(par.b, sig.b, mbuffer, mlen);
+	}
 
-		rc = iftable[a]->signatchk(par, sig, mbuffer, mlen);
+	struct a25519_sigsess *sign_init(
+		unsigned int a,
+		unsigned char *sbuffer, size_t slen
+	){
+		struct a25519_sigsess *out;
+		if(iftable[a]->signatini == NULL){
+			lerror("Streamed signing not supported (algo %u)\n", a);
+			return NULL;
+		}
+		out = (struct a25519_sigsess *)malloc(sizeof(struct a25519_sigsess));
+		if(out == NULL) return NULL;
+		out->a = a;
+		iftable[a]->secstruct(sbuffer, slen, &out->key);
+		if(out->key == NULL){
+			free(out); return NULL;
+		}
+		iftable[a]->signatini(out->key, &out->ss);
+		return out;
+	}
 
+	struct a25519_sigsess *verify_init(
+		unsigned int a,
+		unsigned char *pbuffer, size_t plen
+	){
+		struct a25519_sigsess *out;
+		if(iftable[a]->signatchkp == NULL){
+			lerror("Streamed verification not supported (algo %u)\n", a);
+			return NULL;
+		}
+		out = (struct a25519_sigsess *)malloc(sizeof(struct a25519_sigsess) + plen);
+		if(out == NULL) return NULL;
+		out->a = a;
+		out->key = NULL;
+		//the key is the caller's only until init returns
+		memcpy(out->pbuf, pbuffer, plen);
+		if( iftable[a]->pubview(out->pbuf, plen, &out->par) != 0 ){
+			lerror("Malformed public key\n");
+			free(out); return NULL;
+		}
+		crypto_hash_sha512_init(&out->ss.pre);
+		nonce::init(&out->ss.nc, 0, NULL, 0);
+		return out;
+	}
+
+	void update(struct a25519_sigsess *sess, const unsigned char *mbuffer, size_t mlen){
+		sigabsorb(&sess->ss, mbuffer, mlen);
+	}
+
+	int sign_final(
+		struct a25519_sigsess *sess,
+		unsigned char **obuffer, size_t *olen
+	){
+		unsigned int a = sess->a;
+		void *sig;
+		iftable[a]->signatfin(sess->key, &sess->ss, &sig);
+		sfree(sess);
+		if(sig == NULL){
+			*obuffer = NULL; *olen = 0;
+			return 1;
+		}
+		iftable[a]->sigserial(sig, obuffer, olen);
 		iftable[a]->sigdestroy(sig);
-		iftable[a]->pubdestroy(par);
+		return 0;
+	}
+
+	int verify_final(
+		struct a25519_sigsess *sess,
+		unsigned char *obuffer, size_t olen
+	){
+		struct kview sig;
+		int rc;
+		if( iftable[sess->a]->sigview(obuffer, olen, &sig) != 0 ){
+			lerror("Malformed signature\n");
+			rc = 1;
+		}else{
+			rc = iftable[sess->a]->signatchkp(sess->par.b, sig.b, &sess->ss);
+		}
+		sfree(sess);
 		return rc;
 	}
+
+	void sfree(struct a25519_sigsess *sess){
+		if(sess == NULL) return;
+		if(sess->key != NULL) iftable[sess->a]->secdestroy(sess->key);
+		//the nonce streams are keyed with the secret
+		sodium_memzero(&sess->ss, sizeof(sess->ss));
+		free(sess);
+	}
+
+	//the rest of fd through the session, 0 at its end, 1 on a read error
+	static int absorbfd(struct a25519_sigsess *sess, int fd){
+		unsigned char *buf = (unsigned char *)malloc(SG_CHUNK);
+		ssize_t n;
+		if(buf == NULL) return 1;
+		for(;;){
+			n = read(fd, buf, SG_CHUNK);
+			if(n < 0 && errno == EINTR) continue;
+			if(n <= 0) break;
+			sigabsorb(&sess->ss, buf, (size_t)n);
+		}
+		free(buf);
+		if(n < 0){
+			lerror("Unable to read the ID: %s\n", strerror(errno));
+			return 1;
+		}
+		return 0;
+	}
+
+	int sign_fd(
+		unsigned int a,
+		unsigned char *sbuffer, size_t slen,
+		int fd,
+		unsigned char **obuffer, size_t *olen
+	){
+		struct a25519_sigsess *sess = sign_init(a, sbuffer, slen);
+		if(sess == NULL) return 1;
+		if(absorbfd(sess, fd) != 0){
+			sfree(sess); return 1;
+		}
+		return sign_final(sess, obuffer, olen);
+	}
+
+	int verify_fd(
+		unsigned int a,
+		unsigned char *pbuffer, size_t plen,
+		int fd,
+		unsigned char *obuffer, size_t olen
+	){
+		struct a25519_sigsess *sess = verify_init(a, pbuffer, plen);
+		if(sess == NULL) return 1;
+		if(absorbfd(sess, fd) != 0){
+			sfree(sess); return 1;
+		}
+		return verify_final(sess, obuffer, olen);
+	}
+
+	int sign_batch(
+		unsigned int a,
+		unsigned char *sbuffer, size_t slen,
+		size_t count,
+		unsigned char **mbuffer, size_t *mlen,
+		unsigned char **obuffer, size_t *olen
+	){
+		void *key;
+		void **sig;
+		size_t i;
+		int rc = 0;
+
+		sig = (void **)malloc(count * sizeof(void *));
+		if(sig == NULL) return 1;
+		iftable[a]->secstruct(sbuffer, slen, &key);
+		//schemes without a batched path sign one by one
+		if(iftable[a]->signatgenv != NULL){
+			iftable[a]->signatgenv(key, count, (const unsigned char *const *)mbuffer, mlen, sig);
+		}else{
+			for(i = 0; i < count; i++) iftable[a]->signatgen(key, mbuffer[i], mlen[i], &sig[i]);
+		}
+		iftable[a]->secdestroy(key);
+
+		for(i = 0; i < count; i++){
+			if(sig[i] == NULL){
+				obuffer[i] = NULL; olen[i] = 0;
+				rc = 1; continue;
+			}
+			iftable[a]->sigserial(sig[i], &obuffer[i], &olen[i]);
+			iftable[a]->sigdestroy(sig[i]);
+		}
+		free(sig);
+		return rc;
+	}
+
+	int verify_batch(
+		unsigned int a,
+		unsigned char *pbuffer, size_t plen,
+		size_t count,
+		unsigned char **mbuffer, size_t *mlen,
+		unsigned char **obuffer, size_t *olen,
+		int *rc
+	){
+		struct kview par, *sv;
+		void **sig;
+		int *res = rc;
+		size_t i;
+		int bad = 0, whole = 1;
+
+		sv = (struct kview *)malloc(count * sizeof(struct kview));
+		sig = (void **)malloc(count * sizeof(void *));
+		if(res == NULL) res = (int *)malloc(count * sizeof(int));
+		if(sv == NULL || sig == NULL || res == NULL ||
+			iftable[a]->pubview(pbuffer, plen, &par) != 0){
+			if(res != NULL) for(i = 0; i < count; i++) res[i] = 1;
+			free(sv); free(sig);
+			if(res != rc) free(res);
+			return (int)count;
+		}
+		//all parsed in place, a signature of the wrong length fails alone
+		for(i = 0; i < count; i++){
+			sig[i] = sv[i].b;
+			if( iftable[a]->sigview(obuffer[i], olen[i], &sv[i]) != 0 ){
+				sig[i] = NULL;
+				whole = 0;
+			}
+		}
+
+		if(whole && iftable[a]->signatchkv != NULL){
+			iftable[a]->signatchkv(par.b, count, sig, (const unsigned char *const *)mbuffer, mlen, res);
+		}else{
+			for(i = 0; i < count; i++)
+				res[i] = sig[i] == NULL ? 1 : iftable[a]->signatchk(par.b, sig[i], mbuffer[i], mlen[i]);
+		}
+
+		for(i = 0; i < count; i++) if(res[i] != 0) bad++;
+		free(sv);
+		free(sig);
+		if(res != rc) free(res);
+		return bad;
+	}
+
+	int sign_store(
+		unsigned int a,
+		unsigned char *sbuffer, size_t slen,
+		size_t count,
+		unsigned char **mbuffer, size_t *mlen,
+		size_t idmax, const char *path
+	){
+		unsigned char *obuffer[KS_CHUNK];
+		size_t olen[KS_CHUNK];
+		struct kstore_writer *w = NULL;
+		size_t i, j, n;
+		int rc = 0;
+
+		//a chunk at a time, the store is sized from the first key
+		for(i = 0; i < count && rc == 0; i += n){
+			n = count - i < KS_CHUNK ? count - i : KS_CHUNK;
+			rc = sign_batch(a, sbuffer, slen, n, mbuffer + i, mlen + i, obuffer, olen);
+			if(rc == 0 && w == NULL){
+				w = kstore_create(path, a, olen[0], idmax, count);
+				if(w == NULL) rc = 1;
+			}
+			for(j = 0; j < n; j++){
+				if(rc == 0 && kstore_add(w, mbuffer[i+j], mlen[i+j], obuffer[j]) != 0){
+					lerror("ID %zu too long or given twice\n", i + j);
+					rc = 1;
+				}
+				if(obuffer[j] != NULL) sodium_memzero(obuffer[j], olen[j]);
+				free(obuffer[j]);
+			}
+		}
+		if(w == NULL) return 1;
+		//a store short of any key is not left behind to be served
+		if(rc != 0){
+			kstore_abort(w);
+			return rc;
+		}
+		return kstore_finish(w);
+	}
 }
 
 namespace ibi{
@@ -157,15 +493,25 @@ namespace ibi{
 		void *usk;
 		iftable[a]->sigstruct(obuffer, olen, &usk);
 
+		probe_session_start(a, csock, USDT_PROVER);
 		debug("Sending ID string %s\n",mbuffer);
 		rc = general::client::establish( csock, mbuffer, mlen );
+		if(rc == 3){
+			lerror("Verifier busy, rejected before the protocol\n");
+			probe_session_done(a, csock, USDT_PROVER, 1);
+			iftable[a]->sigdestroy(usk);
+			return 1;
+		}
 		if(rc != 0){
 			lerror("Failed to recv go-ahead (0x5a) byte\n");
+			probe_session_done(a, csock, USDT_PROVER, 1);
+			iftable[a]->sigdestroy(usk);
 			return 1;
 		}
 		debug("Go-Ahead received (0x5a), Starting PROVE protocol\n");
 
 		rc = iftable[a]->signatprv( csock, usk, mbuffer, mlen);
+		probe_session_done(a, csock, USDT_PROVER, rc);
 
 		//free up the usk
 		iftable[a]->sigdestroy(usk);
@@ -184,20 +530,32 @@ namespace ibi{
 		}
 
 		int rc;
-		//parse the params (public key)
-		void *par;
-		iftable[a]->pubstruct(pbuffer, plen, &par);
+		uint64_t t0, t1;
+		//parse the params (public key) in place
+		struct kview par;
+		if( iftable[a]->pubview(pbuffer, plen, &par) != 0 ){
+			lerror("Malformed public key\n");
+			return 1;
+		}
 
+		metrics::started(a);
+		probe_session_start(a, csock, USDT_VERIFIER);
+		t0 = mclock_ns();
 		rc = general::server::establish( csock, mbuffer, mlen );
 		if(rc != 0){
 			lerror("Failed to recv ID from prover\n");
+			probe_session_done(a, csock, USDT_VERIFIER, 1);
+			metrics::ended(a, 1, A25519_MR_IO);
 			return 1;
 		}
+		t1 = mclock_ns();
+		metrics::phase(a, A25519_MP_ID, t1 - t0);
 		debug("Go-Ahead sent (0x5a), Starting VERIFY protocol\n");
-		rc = iftable[a]->signatvrf( csock, par, *mbuffer, *mlen);
-
-		//free up
-		iftable[a]->pubdestroy(par);
+		rc = iftable[a]->signatvrf( csock, par.b, *mbuffer, *mlen);
+		//the blocking protocol has no phase boundaries past the ID
+		metrics::phase(a, A25519_MP_TOTAL, mclock_ns() - t0);
+		metrics::ended(a, rc, A25519_MR_REJECT);
+		probe_session_done(a, csock, USDT_VERIFIER, rc);
 		return rc;
 	}
 
@@ -291,49 +649,165 @@ namespace ibi{
 	}
 
 
-	//TODO: implement this with 'select'
+	//serves through the pooled event loop (see pserver)
 	void server(
 		unsigned int a,
 		unsigned char *pbuffer, size_t plen,
 		int port, int timeout, int maxcq,
 		void (*callback)(int, int, const unsigned char *, size_t)
 	){
-		struct sockaddr_in cli; int rc;
-		int cli_len = sizeof(struct sockaddr_in);
-		struct in_addr ipaddr;
-		char ipastr[INET_ADDRSTRLEN];
-		int ssock,csock; //server socket and client socket
-		unsigned char *mbuffer; size_t mlen;
-
-		//Create socket (timeout, rebind, nonblock)
-		//Force a minimum timeout (since misprogrammed client could jam the server)
-		if(timeout <= 30 || timeout > 300) timeout = 30;
+		struct a25519_srvopt opt;
+		srvopt_init(&opt);
+		//the protocol itself runs under the phase deadlines of srvopt_init,
+		//timeout only bounds the callback's socket
+		if(timeout <= 0 || timeout > 300) timeout = 30;
 		//ensure maxcq >= 0
 		if(maxcq < 0) maxcq = 0;
-		ssock = sockgen(timeout, 1, 0);
-		if(ssock == -1){lerror("Socket creation failed\n");return;}
-		//bind the socket
-		if(sockbind(ssock,port) < 0){lerror("Port bind failed\n");return;}
+		opt.timeout = timeout;
+		opt.maxcq = maxcq;
+		pserver(a, pbuffer, plen, port, &opt, callback);
+	}
 
-		//listen for incoming conn
-		debug("Listening for verification attempts on port %d\n",port);
-		listen(ssock, maxcq);
+	void srvopt_init(struct a25519_srvopt *opt){
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		opt->timeout = 30;
+		opt->maxcq = 16;
+		opt->workers = n > 0 ? (int)n : 1;
+		opt->qdepth = 1024;
+		//a prover on the local network answers in well under these
+		opt->id_ms = 1000;
+		opt->commit_ms = 1000;
+		opt->response_ms = 1000;
+		opt->maxsess = 1024;
+		opt->shedq = opt->qdepth / 2;
+		opt->rate = 100;
+		opt->burst = 200;
+		opt->metrics_port = 0;
+		opt->vcache_bytes = 0;
+	}
+
+	void pserver(
+		unsigned int a,
+		unsigned char *pbuffer, size_t plen,
+		int port, const struct a25519_srvopt *opt,
+		void (*callback)(int, int, const unsigned char *, size_t)
+	){
+		if( evserver::run(a, pbuffer, plen, port, opt, callback) != 0 ){
+			lerror("Pooled server failed to start\n");
+		}
+	}
+
+	int poolstat(struct a25519_poolstat *out){
+		return evserver::poolstat(out);
+	}
+
+	void metrics(struct a25519_metrics *out){
+		::metrics::snapshot(out);
+	}
+
+	unsigned long long metrics_bound(unsigned int bucket){
+		return ::metrics::bound(bucket);
+	}
+
+	unsigned long long metrics_pct(const struct a25519_mhist *h, double p){
+		return ::metrics::pct(h, p);
+	}
+
+	struct a25519_nbsess *nbprove(
+		unsigned int a,
+		unsigned char *mbuffer, size_t mlen,
+		unsigned char *obuffer, size_t olen,
+		int csock
+	){
+		struct a25519_nbsess *out;
+		if(csock == -1){
+			lerror("Invalid socket\n");
+			return NULL;
+		}
+		out = (struct a25519_nbsess *)malloc(sizeof(struct a25519_nbsess));
+		if(out == NULL) return NULL;
+		iftable[a]->sigstruct(obuffer, olen, &out->key);
+		out->s = nbsess::prover(a, csock, out->key, mbuffer, mlen);
+		if(out->s == NULL){
+			lerror("Failed to start PROVE session\n");
+			iftable[a]->sigdestroy(out->key);
+			free(out); return NULL;
+		}
+		return out;
+	}
+
+	struct a25519_nbsess *nbverify(
+		unsigned int a,
+		unsigned char *pbuffer, size_t plen,
+		int csock
+	){
+		struct a25519_nbsess *out;
+		if(csock == -1){
+			lerror("Invalid socket\n");
+			return NULL;
+		}
+		out = (struct a25519_nbsess *)malloc(sizeof(struct a25519_nbsess));
+		if(out == NULL) return NULL;
+		iftable[a]->pubstruct(pbuffer, plen, &out->key);
+		out->s = nbsess::verifier(a, csock, out->key);
+		if(out->s == NULL){
+			lerror("Failed to start VERIFY session\n");
+			iftable[a]->pubdestroy(out->key);
+			free(out); return NULL;
+		}
+		return out;
+	}
 
-		while(1){
-			csock = accept( ssock, (struct sockaddr *)&cli, (socklen_t*)&cli_len);
-			if(csock < 0){
-				//lerror("Connection failed to establish with %s\n",ipastr);
-				continue;
+	int nbstep(struct a25519_nbsess *sess){
+		for(;;){
+			switch( nbsess::pump(sess->s) ){
+			case NB_WANTRD: return A25519_NB_WANTRD;
+			case NB_WANTWR: return A25519_NB_WANTWR;
+			case NB_STEP: nbsess::step(sess->s); break;
+			case NB_DONE: return A25519_NB_DONE;
+			default: return A25519_NB_ERROR;
 			}
-			ipaddr = cli.sin_addr;
-			inet_ntop( AF_INET, &ipaddr, ipastr, INET_ADDRSTRLEN );
-			debug("Connection established with %s\n",ipastr);
-			rc = verify(a, pbuffer, plen, &mbuffer, &mlen, csock );
-			callback(rc, csock, mbuffer, mlen ); //runs the callback func
-			close(csock);
 		}
 	}
 
+	int nbresult(
+		struct a25519_nbsess *sess,
+		const unsigned char **mbuffer, size_t *mlen
+	){
+		if(mbuffer != NULL) *mbuffer = sess->s->mbuffer;
+		if(mlen != NULL) *mlen = sess->s->mlen;
+		return sess->s->stage == NS_DONE ? sess->s->rc : 1;
+	}
+
+	void nbfree(struct a25519_nbsess *sess){
+		if(sess == NULL) return;
+		if(sess->s->role == NS_PROVER) iftable[sess->s->a]->sigdestroy(sess->key);
+		else iftable[sess->s->a]->pubdestroy(sess->key);
+		nbsess::destroy(sess->s);
+		free(sess);
+	}
+
+	struct a25519_cpool *cpool_new(
+		unsigned int a,
+		unsigned char *mbuffer, size_t mlen,
+		unsigned char *obuffer, size_t olen,
+		const char *srv, int port, int timeout,
+		size_t size, unsigned int maxage
+	){
+		return cpool::create(a, mbuffer, mlen, obuffer, olen, srv, port, timeout, size, maxage);
+	}
+
+	int cpool_get(struct a25519_cpool *pool, unsigned int wait){
+		return cpool::get(pool, wait);
+	}
+
+	size_t cpool_ready(struct a25519_cpool *pool){
+		return cpool::ready(pool);
+	}
+
+	void cpool_free(struct a25519_cpool *pool){
+		cpool::destroy(pool);
+	}
 
 }
 
@@ -345,116 +819,217 @@ namespace test{
 		unsigned char *mbuffer, size_t mlen,
 		unsigned char *obuffer, size_t olen
 	){
-		int rc;
-		void *par;
-		void *usk;
-		iftable[a]->pubstruct(pbuffer, plen, &par);
-		iftable[a]->sigstruct(obuffer, olen, &usk);
+		//both parsed in place, the usk is not copied anywhere
+		struct kview par, usk;
+		if( iftable[a]->pubview(pbuffer, plen, &par) != 0 ||
+			iftable[a]->sigview(obuffer, olen, &usk) != 0 ){
+			lerror("Malformed public key or user key\n");
+			return 1;
+		}
 
 		//run test
-		rc = iftable[a]->prototest(par, usk, mbuffer, mlen);
+		return iftable[a]->prototest(par.b, usk.b, mbuffer, mlen);
+	}
 
-		//clear out
-		iftable[a]->pubdestroy(par);
-		iftable[a]->sigdestroy(usk);
 
-		return rc;
+	void benchopt_init(struct a25519_benchopt *opt){
+		opt->count = 0;
+		opt->duration = 5;
+		opt->warmup = 100;
+		opt->json = 0;
 	}
 
-
-	void client(
+	//repeated PROVE runs over a single connection, timed on the wall clock
+	int bprove(
 		unsigned int a,
 		unsigned char *mbuffer, size_t mlen,
 		unsigned char *obuffer, size_t olen,
 		const char *srv, int port,
-		unsigned int count
+		const struct a25519_benchopt *opt
 	){
-		int tsock;
-		int rc;
-		clock_t start, end; unsigned int i;
-		double cpu_time_use = 0;
+		struct hdrhist *lat;
+		struct bench::result res;
+		uint64_t t0, t1, tstart, tend;
+		unsigned int i, tries;
+		int tsock, rc;
+		void *usk;
 
 		//Create socket
 		tsock = sockgen(60, 1, 0);
-		if(tsock == -1){lerror("Socket creation failed\n");return;}
+		if(tsock == -1){lerror("Socket creation failed\n");return 1;}
 
-		//Attempt to connect
+		//the verifier may still be starting up
 		debug("Attempting to connect to %s:%d\n",srv,port);
-		if( sockconn(tsock, srv, port) < 0){
-			lerror("Failed to connect to verifier\n");
-			return;
+		for(tries = 0; sockconn(tsock, srv, port) < 0; tries++){
+			close(tsock);
+			if(tries == 50){
+				lerror("Failed to connect to verifier\n");
+				return 1;
+			}
+			usleep(50000);
+			tsock = sockgen(60, 1, 0);
+			if(tsock == -1){lerror("Socket creation failed\n");return 1;}
 		}
 		debug("Connection established with %s:%d, begin prove tests\n",srv,port);
 
-		start = clock();
-		for(i=0; i<count;i++){
-			rc = ibi::prove(a, mbuffer, mlen, obuffer, olen, tsock );
-			if(rc!=0){
-				lerror("Invalid run:%u, rc=%d\n",i,rc);
+		lat = (struct hdrhist *)malloc(sizeof(struct hdrhist));
+		hh_reset(lat);
+		res.role = "prove"; res.algo = a;
+		res.ok = 0; res.fail = 0;
+		iftable[a]->sigstruct(obuffer, olen, &usk);
+
+		tstart = 0;
+		tend = opt->count == 0 ? (uint64_t)opt->duration * 1000000000ULL : 0;
+		for(i = 0; ; i++){
+			if(i == opt->warmup) tstart = mclock_ns();
+			if(i >= opt->warmup){
+				if(opt->count > 0 && i - opt->warmup >= opt->count) break;
+				if(opt->count == 0 && mclock_ns() - tstart >= tend) break;
+			}
+
+			//a failed go-ahead means the verifier is gone
+			if( general::client::establish( tsock, mbuffer, mlen ) != 0 ){
+				lerror("Verifier stopped responding on run %u\n",i);
 				break;
 			}
+			//the protocol alone, as bverify times it
+			t0 = mclock_ns();
+			rc = iftable[a]->signatprv( tsock, usk, mbuffer, mlen);
+			t1 = mclock_ns();
+
+			if(i < opt->warmup) continue;
+			hh_record(lat, t1 - t0);
+			if(rc == 0) res.ok++;
+			else res.fail++;
 		}
-		end = clock();
-		cpu_time_use = (((double) (end - start)) / CLOCKS_PER_SEC) * 1000; //record time
-		printf("%d proves took total %.4f ms, ", count, cpu_time_use);
-		cpu_time_use = cpu_time_use / count; //average it
-		printf("average: %.4f ms\n", cpu_time_use);
-		if(i==count) printf("All runs OK\n");
+		res.wall = res.ok + res.fail > 0 ? mclock_ns() - tstart : 0;
+		res.lat = lat;
+		bench::report(&res, opt->json);
+
+		iftable[a]->sigdestroy(usk);
+		free(lat);
 		close(tsock);
+		return res.fail == 0 && res.ok > 0 ? 0 : 1;
 	}
 
-	//similar to server,
-	//but records average time and expect 100 authentication attempts
-	//FOR testing purposes
-	void server(
+	//repeated VERIFY runs on a single connection, until the prover leaves
+	//(or count runs after the warmup)
+	int bverify(
 		unsigned int a,
 		unsigned char *pbuffer, size_t plen,
-		int port, unsigned int count
+		int port,
+		const struct a25519_benchopt *opt
 	){
-		struct sockaddr_in cli; int rc;
+		struct sockaddr_in cli;
 		int cli_len = sizeof(struct sockaddr_in);
-		struct in_addr ipaddr;
-		char ipastr[INET_ADDRSTRLEN];
-		int ssock,csock; //server socket and client socket
-		clock_t start, end; unsigned int i;
-		double cpu_time_use = 0;
+		struct hdrhist *lat;
+		struct bench::result res;
+		uint64_t t0, t1, tstart;
 		unsigned char *mbuffer; size_t mlen;
+		unsigned int i;
+		int ssock, csock, rc;
+		void *par;
 
 		ssock = sockgen(60, 1, 0);
-		if(ssock == -1){lerror("Socket creation failed\n");return;}
+		if(ssock == -1){lerror("Socket creation failed\n");return 1;}
 		//bind the socket
-		if(sockbind(ssock,port) < 0){lerror("Port bind failed\n");return;}
+		if(sockbind(ssock,port) < 0){lerror("Port bind failed\n");close(ssock);return 1;}
 
 		//listen for incoming conn
 		debug("Testing for verification attempts on port %d\n",port);
 		listen(ssock, 0);
 
 		csock = accept( ssock, (struct sockaddr *)&cli, (socklen_t*)&cli_len);
-		ipaddr = cli.sin_addr;
-		inet_ntop( AF_INET, &ipaddr, ipastr, INET_ADDRSTRLEN );
-		if(csock < 0){lerror("Connection failed to establish with %s\n",ipastr);}
-		debug("Connection established with %s, begin verification tests\n",ipastr);
+		close(ssock);
+		if(csock < 0){lerror("Connection failed to establish\n");return 1;}
 
-		//record
-		start = clock();
-		for(i = 0; i < count; i++){
-			rc = ibi::verify(a, pbuffer, plen, &mbuffer, &mlen, csock );
-			if(rc!=0){
-				lerror("Invalid run:%u, rc=%d\n",i,rc);
-				break;
-			}
-			//callback(rc, csock, mbuffer, mlen ); //runs the callback func
-		}
-		end = clock();
+		lat = (struct hdrhist *)malloc(sizeof(struct hdrhist));
+		hh_reset(lat);
+		res.role = "verify"; res.algo = a;
+		res.ok = 0; res.fail = 0;
+		iftable[a]->pubstruct(pbuffer, plen, &par);
 
-		//calculation
-		cpu_time_use = (((double) (end - start)) / CLOCKS_PER_SEC) * 1000; //record time
-		printf("%d verifications took total %.4f ms, ", count, cpu_time_use);
-		cpu_time_use = cpu_time_use / count; //average it
-		printf("average: %.4f ms\n", cpu_time_use);
-		if(i==count) printf("All runs OK\n");
+		tstart = 0;
+		for(i = 0; opt->count == 0 || i < opt->warmup + opt->count; i++){
+			if(i == opt->warmup) tstart = mclock_ns();
+			//the ID arrives when the prover starts the run
+			if( general::server::establish( csock, &mbuffer, &mlen ) != 0 ) break;
+			t0 = mclock_ns();
+			rc = iftable[a]->signatvrf( csock, par, mbuffer, mlen);
+			t1 = mclock_ns();
+			free(mbuffer);
+
+			if(i < opt->warmup) continue;
+			hh_record(lat, t1 - t0);
+			if(rc == 0) res.ok++;
+			else res.fail++;
+		}
+		res.wall = res.ok + res.fail > 0 ? mclock_ns() - tstart : 0;
+		res.lat = lat;
+		bench::report(&res, opt->json);
 
+		iftable[a]->pubdestroy(par);
+		free(lat);
 		close(csock);
+		return res.fail == 0 && res.ok > 0 ? 0 : 1;
+	}
+
+	int microbench(unsigned int count, int json, unsigned long long (*allocs)(void)){
+		return bench::micro(count, json, allocs);
+	}
+
+	int inproc(unsigned int count, int json, unsigned long long (*allocs)(void)){
+		return bench::inproc(count, json, allocs);
+	}
+
+	int rtt(unsigned int count, int json, const struct a25519_linkopt *lo){
+		return bench::rtt(count, json, lo);
+	}
+
+	void loadopt_init(struct a25519_loadopt *opt){
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		opt->rate = 1000;
+		opt->duration = 10;
+		opt->maxconn = 4096;
+		opt->threads = n > 0 ? (unsigned int)n : 1;
+		opt->timeout = 5000;
+		opt->json = 0;
+	}
+
+	int loadgen(
+		unsigned int a,
+		unsigned char *mbuffer, size_t mlen,
+		unsigned char *obuffer, size_t olen,
+		const char *srv, int port,
+		const struct a25519_loadopt *opt
+	){
+		return ::loadgen::run(a, mbuffer, mlen, obuffer, olen, srv, port, opt);
+	}
+
+	void client(
+		unsigned int a,
+		unsigned char *mbuffer, size_t mlen,
+		unsigned char *obuffer, size_t olen,
+		const char *srv, int port,
+		unsigned int count
+	){
+		struct a25519_benchopt opt;
+		benchopt_init(&opt);
+		opt.count = count;
+		opt.warmup = 0;
+		bprove(a, mbuffer, mlen, obuffer, olen, srv, port, &opt);
+	}
+
+	void server(
+		unsigned int a,
+		unsigned char *pbuffer, size_t plen,
+		int port, unsigned int count
+	){
+		struct a25519_benchopt opt;
+		benchopt_init(&opt);
+		opt.count = count;
+		opt.warmup = 0;
+		bverify(a, pbuffer, plen, port, &opt);
 	}
 
 }
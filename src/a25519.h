@@ -37,6 +37,71 @@
 
 #include <stddef.h>
 
+//a25519_ibi_nbstep results
+#define A25519_NB_ERROR		-1
+#define A25519_NB_WANTRD	0	//wait for the socket to be readable
+#define A25519_NB_WANTWR	1	//wait for the socket to be writable
+#define A25519_NB_DONE		3
+
+//identification outcomes (a25519_ident.fail)
+#define A25519_MR_REJECT	0	//the proof did not verify
+#define A25519_MR_TIMEOUT	1	//a phase deadline passed
+#define A25519_MR_IO		2	//the prover went away or a socket error
+#define A25519_MR_BUSY		3	//turned away by admission control
+#define A25519_MR_COUNT		4
+
+//latency histograms (a25519_ident.lat), time spent in each phase
+#define A25519_MP_ID		0	//accept until the ID string is in
+#define A25519_MP_COMMIT	1	//go-ahead until the first move is in
+#define A25519_MP_RESPONSE	2	//first move until the result
+#define A25519_MP_TOTAL		3	//accept until the result
+#define A25519_MP_COUNT		4
+
+//histogram buckets, 4 per power of 2 from 1us to 68s and an overflow
+#define A25519_MH_BUCKETS	105
+
+//traced operations (a25519_opevent.op), the scheme table entries
+#define A25519_OP_RANDKEYGEN	0
+#define A25519_OP_SIGNATGEN	1
+#define A25519_OP_SIGNATCHK	2
+#define A25519_OP_SECSERIAL	3
+#define A25519_OP_PUBSERIAL	4
+#define A25519_OP_SIGSERIAL	5
+#define A25519_OP_SECSTRUCT	6
+#define A25519_OP_PUBSTRUCT	7
+#define A25519_OP_SIGSTRUCT	8
+#define A25519_OP_SECDESTROY	9
+#define A25519_OP_PUBDESTROY	10
+#define A25519_OP_SIGDESTROY	11
+#define A25519_OP_SECPRINT	12
+#define A25519_OP_PUBPRINT	13
+#define A25519_OP_SIGPRINT	14
+#define A25519_OP_SIGNATPRV	15
+#define A25519_OP_SIGNATVRF	16
+#define A25519_OP_PROTOTEST	17
+#define A25519_OP_VRFINIT	18
+#define A25519_OP_VRFSTEP	19
+#define A25519_OP_VRFFREE	20
+#define A25519_OP_PRVINIT	21
+#define A25519_OP_PRVSTEP	22
+#define A25519_OP_PRVFREE	23
+#define A25519_OP_SIGNATGENV	24
+#define A25519_OP_SIGNATCHKV	25
+#define A25519_OP_PUBVIEW	26
+#define A25519_OP_SIGVIEW	27
+#define A25519_OP_SIGNATINI	28
+#define A25519_OP_SIGNATFIN	29
+#define A25519_OP_SIGNATCHKP	30
+#define A25519_OP_COUNT		31
+
+//signature nonces (a25519_nonce)
+#define A25519_NONCE_RANDOM		0
+#define A25519_NONCE_DETERMINISTIC	1
+
+//randomness of nonces, commitments and challenges (a25519_rng)
+#define A25519_RNG_SYSTEM	0
+#define A25519_RNG_BUFFERED	1
+
 //TS - tight signature
 //TI - tight identity based identification
 
@@ -44,6 +109,130 @@
 extern "C"{
 #endif
 
+	//options for the pooled identification server
+	//obtain the defaults with a25519_ibi_srvopt_init
+	struct a25519_srvopt{
+		int timeout;	//socket timeout (seconds) once handed to the callback
+		int maxcq;	//listen backlog
+		int workers;	//crypto/callback worker threads, 0 runs all on the I/O thread
+		int qdepth;	//worker queue capacity (rounded up to a power of 2, 0 or less - 1024)
+		//per-phase deadlines (ms), a session that overruns one is evicted
+		//and the callback receives a failure. 0 or less takes the default
+		//of a25519_ibi_srvopt_init (1000)
+		int id_ms;	//accept until the ID string is in
+		int commit_ms;	//go-ahead until the prover's first move is in
+		int response_ms;	//first move until the protocol completes
+		//admission control, sessions over a limit get SIG_BUSY instead
+		//of the go-ahead (before any scalar multiplication) and never
+		//reach the callback
+		int maxsess;	//sessions in flight (0 or less - 1024)
+		int shedq;	//worker queue depth that sheds new sessions (0 - never)
+		int rate;	//new sessions per second per source address (0 - unlimited)
+		int burst;	//per source address burst
+		//plain-text metrics page (Prometheus format) on GET /metrics,
+		//served on 127.0.0.1:metrics_port by its own thread (0 - off).
+		//GET /trace/on, /trace/off toggle a25519_trace, /trace dumps it
+		int metrics_port;
+		//verifier cache (a25519_vcache) size in bytes set up before
+		//serving, 0 leaves it as it is
+		size_t vcache_bytes;
+	};
+
+	//worker pool statistics of a running pooled server
+	struct a25519_poolstat{
+		unsigned int workers;
+		size_t qcap;			//queue capacity
+		size_t qdepth;			//jobs currently queued
+		size_t qdepth_max;		//high watermark of qdepth
+		size_t backlog;			//jobs held back by the I/O thread (queue full)
+		unsigned long long jobs;	//jobs completed
+		unsigned long long wait_ns;	//total time jobs spent queued
+		unsigned long long wait_ns_max;	//longest time a job spent queued
+		unsigned long long run_ns;	//total time spent running jobs
+		size_t sessions;		//admitted sessions in flight
+		unsigned long long shed_cap;	//rejected, maxsess reached
+		unsigned long long shed_queue;	//rejected, worker queue too deep
+		unsigned long long shed_rate;	//rejected, source address over rate
+	};
+
+	//options for the benchmark runs (a25519_test_bprove/bverify)
+	//obtain the defaults with a25519_test_benchopt_init
+	struct a25519_benchopt{
+		unsigned int count;	//timed runs, 0 runs for duration seconds instead
+		unsigned int duration;	//seconds to run when count is 0
+		unsigned int warmup;	//untimed runs before measuring
+		int json;		//report as a single JSON line
+	};
+
+	//a simulated link for the round trip benchmark (a25519_test_rtt)
+	struct a25519_linkopt{
+		unsigned int delay_us;		//one-way latency
+		unsigned int jitter_us;		//uniform +/- on the latency (order is kept)
+		unsigned long long bandwidth;	//bit/s each way, 0 - unlimited
+	};
+
+	//options for the load generator (a25519_test_loadgen)
+	//obtain the defaults with a25519_test_loadopt_init
+	struct a25519_loadopt{
+		unsigned int rate;	//identifications started per second (open loop)
+		unsigned int duration;	//seconds of arrivals
+		unsigned int maxconn;	//connections open at once, later arrivals wait
+		unsigned int threads;	//event loops (the prover side crypto runs on them)
+		int timeout;		//ms before an identification counts as timed out
+		int json;		//report as a single JSON line
+	};
+
+	//latency histogram, see a25519_ibi_metrics_bound for the buckets
+	struct a25519_mhist{
+		unsigned long long n;		//values recorded
+		unsigned long long sum_ns;
+		unsigned long long bucket[A25519_MH_BUCKETS];
+	};
+
+	//identification metrics of a scheme (verifier side)
+	struct a25519_ident{
+		unsigned long long started;	//sessions accepted
+		unsigned long long ok;		//identifications accepted
+		unsigned long long fail[A25519_MR_COUNT];	//by reason
+		unsigned long long active;	//sessions in flight
+		unsigned long long bytes_in, bytes_out;	//protocol bytes (pooled server)
+		struct a25519_mhist lat[A25519_MP_COUNT];
+	};
+
+	//snapshot of all metrics, indexed by algotype
+	struct a25519_metrics{
+		struct a25519_ident algo[10];
+	};
+
+	//allocations made by the library (./configure --enable-alloccount)
+	struct a25519_allocstat{
+		unsigned long long calls;	//malloc, calloc, realloc, new
+		unsigned long long bytes;
+		unsigned long long sodium_calls;	//sodium_malloc, sodium_allocarray
+		unsigned long long sodium_bytes;
+	};
+
+	//verifier cache statistics
+	struct a25519_vcstat{
+		unsigned long long hits;
+		unsigned long long misses;
+		unsigned long long inserts;
+		unsigned long long evictions;	//entries replaced to make room
+		size_t entries;			//entries in use
+		size_t capacity;		//entries the cache holds
+		size_t bytes;			//memory held by the cache
+	};
+
+	//a traced scheme operation
+	struct a25519_opevent{
+		unsigned long long start_ns;	//monotonic clock
+		unsigned long long dur_ns;
+		unsigned int ring;		//per-thread log it came from
+		unsigned int lost;		//events of the ring overwritten before this one
+		unsigned char algo;		//algotype
+		unsigned char op;		//A25519_OP_*
+	};
+
 	int a25519_keygen(
 		unsigned int algotype,
 		unsigned char **pbuffer, size_t *plen,
@@ -64,6 +253,104 @@ extern "C"{
 		unsigned char *obuffer, size_t olen
 	);
 
+	/*
+	 * signing and verification of an ID too large to hold at once: it is
+	 * hashed piece by piece between init and final, in constant memory,
+	 * into the signature a25519_sig_sign gives for the whole ID (the same
+	 * bytes with deterministic nonces). a final call ends the session,
+	 * a25519_sig_free abandons it. the _fd calls read the ID from fd up
+	 * to its end, a file or a pipe alike
+	 */
+	struct a25519_sigsess;
+
+	//start signing with sbuffer, return NULL on fail
+	struct a25519_sigsess *a25519_sig_sign_init(
+		unsigned int algotype,
+		unsigned char *sbuffer, size_t slen
+	);
+
+	//start verifying against pbuffer, return NULL on fail
+	struct a25519_sigsess *a25519_sig_verify_init(
+		unsigned int algotype,
+		unsigned char *pbuffer, size_t plen
+	);
+
+	//the next mlen bytes of the ID
+	void a25519_sig_update(
+		struct a25519_sigsess *sess,
+		const unsigned char *mbuffer, size_t mlen
+	);
+
+	//the signature as a25519_sig_sign makes it, return 0 on success
+	int a25519_sig_sign_final(
+		struct a25519_sigsess *sess,
+		unsigned char **obuffer, size_t *olen
+	);
+
+	//return 0 iff obuffer is a valid signature of the ID
+	int a25519_sig_verify_final(
+		struct a25519_sigsess *sess,
+		unsigned char *obuffer, size_t olen
+	);
+
+	void a25519_sig_free(struct a25519_sigsess *sess);
+
+	int a25519_sig_sign_fd(
+		unsigned int algotype,
+		unsigned char *sbuffer, size_t slen,
+		int fd,
+		unsigned char **obuffer, size_t *olen
+	);
+
+	int a25519_sig_verify_fd(
+		unsigned int algotype,
+		unsigned char *pbuffer, size_t plen,
+		int fd,
+		unsigned char *obuffer, size_t olen
+	);
+
+	/*
+	 * bulk extraction and batch verification: count IDs signed or
+	 * checked under one master key, the challenge hashes of up to 8 at
+	 * a time computed together (multi-buffer SHA-512, AVX2/AVX-512
+	 * where the cpu has them). sign_batch fills obuffer/olen[i] like
+	 * a25519_sig_sign, NULL/0 where signing failed, and returns 1 if
+	 * any did. verify_batch returns how many signatures failed, rc (if
+	 * not NULL) gets each one's a25519_sig_verify result
+	 */
+	int a25519_sig_sign_batch(
+		unsigned int algotype,
+		unsigned char *sbuffer, size_t slen,
+		size_t count,
+		unsigned char **mbuffer, size_t *mlen,
+		unsigned char **obuffer, size_t *olen
+	);
+
+	int a25519_sig_verify_batch(
+		unsigned int algotype,
+		unsigned char *pbuffer, size_t plen,
+		size_t count,
+		unsigned char **mbuffer, size_t *mlen,
+		unsigned char **obuffer, size_t *olen,
+		int *rc
+	);
+
+	/*
+	 * bulk extraction into a keystore (utils/kstore.h): the keys of count
+	 * IDs, extracted as sign_batch does, written to a new binary store at
+	 * path. kstore_open maps it read-only and kstore_find hands out a key
+	 * by ID in constant time, as obuffer/olen (kstore_recsz) for
+	 * a25519_ibi_prove and the like without a copy. IDs over idmax bytes
+	 * or given twice fail the build, return 0 if the store is complete
+	 */
+	int a25519_sig_sign_store(
+		unsigned int algotype,
+		unsigned char *sbuffer, size_t slen,
+		size_t count,
+		unsigned char **mbuffer, size_t *mlen,
+		size_t idmax, const char *path
+	);
+
 	int a25519_ibi_prove(
 		unsigned int algotype,
 		unsigned char *mbuffer, size_t mlen,
@@ -118,6 +405,162 @@ extern "C"{
 		void (*callback)(int, int, const unsigned char *, size_t)
 	);
 
+	//fill opt with the defaults (one worker per online cpu)
+	void a25519_ibi_srvopt_init(struct a25519_srvopt *opt);
+
+	/*
+	 * pooled server, socket I/O runs on a single event loop thread while
+	 * scalar multiplications and the callbacks run on opt->workers threads.
+	 * callbacks may run concurrently, the socket is blocking (with timeout)
+	 * when handed over and is closed once the callback returns.
+	 * mbuffer is NULL if the client never sent an ID
+	 */
+	void a25519_ibi_pserver(
+		unsigned int algotype,
+		unsigned char *pbuffer, size_t plen,
+		int port, const struct a25519_srvopt *opt,
+		void (*callback)(int, int, const unsigned char *, size_t)
+	);
+
+	//read the pool and admission statistics of the running pooled server
+	//return 0 on success, 1 if none is running
+	int a25519_ibi_poolstat(struct a25519_poolstat *out);
+
+	/*
+	 * non-blocking identification, drive a session from an event loop:
+	 * call a25519_ibi_nbstep whenever csock is ready, it returns which
+	 * readiness to wait for next, until A25519_NB_DONE or A25519_NB_ERROR.
+	 * csock must be non-blocking and is not closed by the session
+	 */
+	struct a25519_nbsess;
+
+	//start proving on a connected socket, return NULL on fail
+	struct a25519_nbsess *a25519_ibi_nbprove(
+		unsigned int algotype,
+		unsigned char *mbuffer, size_t mlen,
+		unsigned char *obuffer, size_t olen,
+		int csock
+	);
+
+	//start verifying on an accepted socket, return NULL on fail
+	struct a25519_nbsess *a25519_ibi_nbverify(
+		unsigned int algotype,
+		unsigned char *pbuffer, size_t plen,
+		int csock
+	);
+
+	//advance the session as far as the socket allows
+	int a25519_ibi_nbstep(struct a25519_nbsess *sess);
+
+	//result of a finished session, 0 iff the usk is valid for the ID
+	//mbuffer (if not NULL) points to the ID until a25519_ibi_nbfree
+	int a25519_ibi_nbresult(
+		struct a25519_nbsess *sess,
+		const unsigned char **mbuffer, size_t *mlen
+	);
+
+	void a25519_ibi_nbfree(struct a25519_nbsess *sess);
+
+	/*
+	 * prover connection pool, keeps up to size channels to srv:port
+	 * identified ahead of demand. a background thread refills the pool
+	 * and retires channels older than maxage ms or closed by the verifier
+	 * (keep maxage below the verifier's idle timeout).
+	 */
+	struct a25519_cpool;
+
+	//return NULL on fail
+	struct a25519_cpool *a25519_ibi_cpool_new(
+		unsigned int algotype,
+		unsigned char *mbuffer, size_t mlen,
+		unsigned char *obuffer, size_t olen,
+		const char *srv, int port, int timeout,
+		size_t size, unsigned int maxage
+	);
+
+	//take an authenticated socket (as a25519_ibi_client, close it yourself)
+	//waits up to wait ms for the pool, then dials inline. return -1 on fail
+	int a25519_ibi_cpool_get(struct a25519_cpool *pool, unsigned int wait);
+
+	//number of channels ready to be handed out
+	size_t a25519_ibi_cpool_ready(struct a25519_cpool *pool);
+
+	void a25519_ibi_cpool_free(struct a25519_cpool *pool);
+
+	//snapshot the identification metrics (counted since the library loaded)
+	//recording is always on and costs a few uncontended stores per event
+	void a25519_ibi_metrics(struct a25519_metrics *out);
+
+	//upper bound (ns) of a histogram bucket, ~0ULL for the overflow bucket
+	unsigned long long a25519_ibi_metrics_bound(unsigned int bucket);
+
+	//estimate the value at percentile p (0-100) of a histogram, 0 if empty
+	unsigned long long a25519_ibi_metrics_pct(const struct a25519_mhist *h, double p);
+
+	/*
+	 * operation tracing: while on, every call into a scheme (signatgen,
+	 * vrfstep, pubstruct, ...) is timed into a log of the calling thread
+	 * that keeps its last 4096 events. off costs nothing, the scheme
+	 * tables are only swapped for timed copies while tracing is on
+	 */
+	//turn tracing on (on != 0) or off, return whether it was on
+	int a25519_trace(int on);
+
+	//move up to max logged events into out, return how many were written
+	size_t a25519_trace_dump(struct a25519_opevent *out, size_t max);
+
+	//name of an A25519_OP_* operation, NULL if out of range
+	const char *a25519_trace_opname(unsigned int op);
+
+	/*
+	 * allocation accounting: with --enable-alloccount every allocation the
+	 * library makes is counted against the calling thread, so resetting
+	 * before a call and reading after gives that call's allocations
+	 */
+	//read the calling thread's counts, reset (reset != 0) them afterwards
+	//return 1 if accounting is not compiled in (out is zeroed)
+	int a25519_alloc_count(struct a25519_allocstat *out, int reset);
+
+	/*
+	 * verifier cache: for TNC and Schnorr IBI, keep x = H(ID, U, V) and
+	 * U +/- xP1 of identities that identified successfully, keyed by
+	 * (master key, ID, U, V), so their next identification skips a hash
+	 * and a variable-base scalar multiplication. the cache is off until
+	 * sized, sets of 4 entries are replaced least recently used first
+	 * and IDs over 128 bytes are never cached
+	 */
+	//hold at most bytes (at least one set), 0 turns it off; what is cached
+	//is dropped. may be called while identifications are being verified
+	//return 1 if the memory could not be had (the cache is left as it was)
+	int a25519_vcache(size_t bytes);
+
+	//counters since start and the current size, see a25519_vcstat
+	void a25519_vcache_stat(struct a25519_vcstat *out);
+
+	/*
+	 * signature nonces, random by default. deterministic nonces are
+	 * derived from the signing key and the ID (RFC 6979 style): the same
+	 * key and ID always sign to the same bytes, which makes extraction
+	 * reproducible and spares it the system randomness per key. the
+	 * interactive protocols always commit to fresh randomness
+	 */
+	//set the mode (A25519_NONCE_*) for every signature made from now on,
+	//on all threads; a negative mode only reads it. return the mode before
+	int a25519_nonce(int mode);
+
+	/*
+	 * randomness of nonces, commitments and challenges. buffered (the
+	 * default) draws from a ChaCha20 stream per thread, seeded from the
+	 * system, reseeded every 16 MiB and in a forked child; system asks
+	 * libsodium on every draw. keys always come from the system
+	 */
+	//set the mode (A25519_RNG_*) on all threads, a negative mode only
+	//reads it. return the mode before
+	int a25519_rng(int mode);
+
+	//len bytes from the generator in use
+	void a25519_randombytes(unsigned char *out, size_t len);
+
 
 	int a25519_test_offline(
 		unsigned int algotype,
@@ -142,6 +585,64 @@ extern "C"{
 		int port, unsigned int count
 	);
 
+	//wall-clock benchmark, reports throughput and latency percentiles
+	//both sides time each run's protocol (not the ID exchange before it)
+	//and start the wall clock on the first run after the warmup
+	//the prover retries the connection while the verifier starts up
+	//the verifier serves until the prover leaves (count 0) or warmup+count runs
+	//return 0 if every timed run succeeded
+	void a25519_test_benchopt_init(struct a25519_benchopt *opt);
+	int a25519_test_bprove(
+		unsigned int algotype,
+		unsigned char *mbuffer, size_t mlen,
+		unsigned char *obuffer, size_t olen,
+		const char *srv, int port,
+		const struct a25519_benchopt *opt
+	);
+	int a25519_test_bverify(
+		unsigned int algotype,
+		unsigned char *pbuffer, size_t plen,
+		int port,
+		const struct a25519_benchopt *opt
+	);
+
+	//times every scheme operation (keygen, sign, check, (de)serialize,
+	//destroy, prototest) count times and reports ns/op, cycles/op and
+	//allocations/op. allocs returns a running allocation count, supply
+	//it from a malloc interposer (NULL leaves allocations unreported)
+	//return 0 if every prototest passed
+	int a25519_test_microbench(unsigned int count, int json,
+		unsigned long long (*allocs)(void));
+
+	//runs count complete identifications of every scheme in process,
+	//over a socketpair through signatprv/signatvrf and over memory through
+	//the step functions alone, reporting ns/id of both paths (their
+	//difference is the transport), and per move costs and sizes
+	//return 0 if every identification was accepted
+	int a25519_test_inproc(unsigned int count, int json,
+		unsigned long long (*allocs)(void));
+
+	//runs count identifications of every scheme in process through a
+	//relay that delays each direction as described by lo (no root or
+	//netem needed), reporting end-to-end latency and message flights
+	//return 0 if every identification was accepted
+	int a25519_test_rtt(unsigned int count, int json,
+		const struct a25519_linkopt *lo);
+
+	//open-loop load against a verifier server: starts opt->rate
+	//identifications per second regardless of completions, and reports
+	//ok/busy/timeout/error counts and latency measured from each
+	//identification's intended start (time spent waiting on maxconn included)
+	//return 0 if every identification completed
+	void a25519_test_loadopt_init(struct a25519_loadopt *opt);
+	int a25519_test_loadgen(
+		unsigned int algotype,
+		unsigned char *mbuffer, size_t mlen,
+		unsigned char *obuffer, size_t olen,
+		const char *srv, int port,
+		const struct a25519_loadopt *opt
+	);
+
 
 #ifdef __cplusplus
 }
@@ -35,6 +35,7 @@
 #define _A25519_HPP_
 
 #include <stddef.h>
+#include "a25519.h"
 
 namespace a25519 {
 
@@ -44,6 +45,25 @@ namespace a25519 {
 		unsigned char **sbuffer, size_t *slen
 	);
 
+	//operation tracing, see a25519_trace
+	int trace(int on);
+	size_t trace_dump(struct a25519_opevent *out, size_t max);
+	const char *trace_opname(unsigned int op);
+
+	//allocation accounting, see a25519_alloc_count
+	int alloc_count(struct a25519_allocstat *out, int reset);
+
+	//verifier cache, see a25519_vcache
+	int vcache(size_t bytes);
+	void vcache_stat(struct a25519_vcstat *out);
+
+	//signature nonces, see a25519_nonce
+	int nonce(int mode);
+
+	//nonce and challenge randomness, see a25519_rng
+	int rng(int mode);
+	void randombytes(unsigned char *out, size_t len);
+
 	namespace sig{
 		int sign(
 			unsigned int algotype,
@@ -59,6 +79,64 @@ namespace a25519 {
 			unsigned char *obuffer, size_t olen
 		);
 
+		//sign/verify an ID given piece by piece, see a25519_sig_sign_init
+		struct a25519_sigsess *sign_init(
+			unsigned int algotype,
+			unsigned char *sbuffer, size_t slen
+		);
+		struct a25519_sigsess *verify_init(
+			unsigned int algotype,
+			unsigned char *pbuffer, size_t plen
+		);
+		void update(struct a25519_sigsess *sess, const unsigned char *mbuffer, size_t mlen);
+		int sign_final(
+			struct a25519_sigsess *sess,
+			unsigned char **obuffer, size_t *olen
+		);
+		int verify_final(
+			struct a25519_sigsess *sess,
+			unsigned char *obuffer, size_t olen
+		);
+		void sfree(struct a25519_sigsess *sess);
+		int sign_fd(
+			unsigned int algotype,
+			unsigned char *sbuffer, size_t slen,
+			int fd,
+			unsigned char **obuffer, size_t *olen
+		);
+		int verify_fd(
+			unsigned int algotype,
+			unsigned char *pbuffer, size_t plen,
+			int fd,
+			unsigned char *obuffer, size_t olen
+		);
+
+		//sign/verify many IDs under one master key, see a25519.h
+		int sign_batch(
+			unsigned int algotype,
+			unsigned char *sbuffer, size_t slen,
+			size_t count,
+			unsigned char **mbuffer, size_t *mlen,
+			unsigned char **obuffer, size_t *olen
+		);
+
+		int verify_batch(
+			unsigned int algotype,
+			unsigned char *pbuffer, size_t plen,
+			size_t count,
+			unsigned char **mbuffer, size_t *mlen,
+			unsigned char **obuffer, size_t *olen,
+			int *rc
+		);
+
+		int sign_store(
+			unsigned int algotype,
+			unsigned char *sbuffer, size_t slen,
+			size_t count,
+			unsigned char **mbuffer, size_t *mlen,
+			size_t idmax, const char *path
+		);
+
 		//TODO: implement the following methods
 		//following 2 are for certificateless schemes
 		//compute user secret value and upk1
@@ -143,6 +221,65 @@ namespace a25519 {
 			int port, int timeout, int maxcq,
 			void (*callback)(int, int, const unsigned char *, size_t)
 		);
+
+		//defaults for pserver
+		void srvopt_init(struct a25519_srvopt *opt);
+
+		//pooled server, callbacks may run concurrently on the workers
+		//see a25519_ibi_pserver
+		void pserver(
+			unsigned int algotype,
+			unsigned char *pbuffer, size_t plen,
+			int port, const struct a25519_srvopt *opt,
+			void (*callback)(int, int, const unsigned char *, size_t)
+		);
+
+		//return 0 on success, 1 if no pooled server is running
+		int poolstat(struct a25519_poolstat *out);
+
+		//identification metrics, see a25519_ibi_metrics
+		void metrics(struct a25519_metrics *out);
+		unsigned long long metrics_bound(unsigned int bucket);
+		unsigned long long metrics_pct(const struct a25519_mhist *h, double p);
+
+		//non-blocking sessions, see a25519_ibi_nbstep
+		//(coroutine wrappers in a25519co.hpp)
+		struct a25519_nbsess *nbprove(
+			unsigned int algotype,
+			unsigned char *mbuffer, size_t mlen,
+			unsigned char *obuffer, size_t olen,
+			int csock
+		);
+
+		struct a25519_nbsess *nbverify(
+			unsigned int algotype,
+			unsigned char *pbuffer, size_t plen,
+			int csock
+		);
+
+		int nbstep(struct a25519_nbsess *sess);
+
+		int nbresult(
+			struct a25519_nbsess *sess,
+			const unsigned char **mbuffer, size_t *mlen
+		);
+
+		void nbfree(struct a25519_nbsess *sess);
+
+		//pre-identified channels, see a25519_ibi_cpool_new
+		struct a25519_cpool *cpool_new(
+			unsigned int algotype,
+			unsigned char *mbuffer, size_t mlen,
+			unsigned char *obuffer, size_t olen,
+			const char *srv, int port, int timeout,
+			size_t size, unsigned int maxage
+		);
+
+		int cpool_get(struct a25519_cpool *pool, unsigned int wait);
+
+		size_t cpool_ready(struct a25519_cpool *pool);
+
+		void cpool_free(struct a25519_cpool *pool);
 	}
 
 	namespace test{
@@ -169,6 +306,41 @@ namespace a25519 {
 			unsigned char *pbuffer, size_t plen,
 			int port, unsigned int count
 		);
+
+		//wall-clock benchmark with latency percentiles
+		void benchopt_init(struct a25519_benchopt *opt);
+		int bprove(
+			unsigned int algotype,
+			unsigned char *mbuffer, size_t mlen,
+			unsigned char *obuffer, size_t olen,
+			const char *srv, int port,
+			const struct a25519_benchopt *opt
+		);
+		int bverify(
+			unsigned int algotype,
+			unsigned char *pbuffer, size_t plen,
+			int port,
+			const struct a25519_benchopt *opt
+		);
+
+		//per-operation timing of every scheme
+		int microbench(unsigned int count, int json, unsigned long long (*allocs)(void));
+
+		//full protocol timing in process (socketpair and memory)
+		int inproc(unsigned int count, int json, unsigned long long (*allocs)(void));
+
+		//identification latency over a simulated link
+		int rtt(unsigned int count, int json, const struct a25519_linkopt *lo);
+
+		//open-loop multi-connection load generator
+		void loadopt_init(struct a25519_loadopt *opt);
+		int loadgen(
+			unsigned int algotype,
+			unsigned char *mbuffer, size_t mlen,
+			unsigned char *obuffer, size_t olen,
+			const char *srv, int port,
+			const struct a25519_loadopt *opt
+		);
 	}
 
 }
@@ -0,0 +1,142 @@
+/*
+ * a25519co.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * File: a25519co.hpp (C++20 coroutine wrappers for the IBI protocols)
+ * co_await-able prove and verify built on the non-blocking sessions
+ * (a25519_ibi_nbstep), so one event loop thread may hold many
+ * identifications in flight. Empty unless compiled as C++20.
+ * chia_jason96@live.com
+*/
+#ifndef _A25519CO_HPP_
+#define _A25519CO_HPP_
+
+#include "a25519.h"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+
+#include <coroutine>
+#include <string>
+
+namespace a25519 {
+namespace ibi {
+
+	/*
+	 * executor hook, ties the awaitables to the caller's event loop
+	 * watch must call cb(arg) exactly once, from the thread resuming the
+	 * coroutine, after fd becomes readable (wr == 0) or writable (wr == 1)
+	 */
+	struct executor{
+		void *ctx;
+		void (*watch)(void *ctx, int fd, int wr, void (*cb)(void *), void *arg);
+	};
+
+	//result of an awaited identification
+	struct idresult{
+		int rc;		//0 iff the usk is valid for the ID
+		std::string id;	//ID string of the prover
+	};
+
+	//awaitable over a non-blocking session, frees the session when destroyed
+	class nbawait{
+	public:
+		nbawait(const executor &ex, struct a25519_nbsess *sess, int csock)
+			: ex(ex), sess(sess), csock(csock), st(A25519_NB_ERROR) {}
+		nbawait(const nbawait &) = delete;
+		nbawait &operator=(const nbawait &) = delete;
+		~nbawait(){ a25519_ibi_nbfree(sess); }
+
+		bool await_ready(){
+			if(sess == NULL) return true;
+			st = a25519_ibi_nbstep(sess);
+			return !pending();
+		}
+
+		void await_suspend(std::coroutine_handle<> h){
+			co = h;
+			ex.watch(ex.ctx, csock, st == A25519_NB_WANTWR, &ready, this);
+		}
+
+		struct idresult await_resume(){
+			struct idresult r;
+			const unsigned char *m = NULL; size_t mlen = 0;
+			r.rc = 1;
+			if(sess != NULL && st == A25519_NB_DONE){
+				r.rc = a25519_ibi_nbresult(sess, &m, &mlen);
+				if(m != NULL) r.id.assign((const char *)m, mlen);
+			}
+			return r;
+		}
+
+	private:
+		bool pending() const {
+			return st == A25519_NB_WANTRD || st == A25519_NB_WANTWR;
+		}
+
+		static void ready(void *arg){
+			nbawait *self = (nbawait *)arg;
+			self->st = a25519_ibi_nbstep(self->sess);
+			if(self->pending()){
+				self->ex.watch(self->ex.ctx, self->csock, self->st == A25519_NB_WANTWR, &ready, self);
+				return;
+			}
+			self->co.resume();
+		}
+
+		executor ex;
+		struct a25519_nbsess *sess;
+		int csock;
+		int st;
+		std::coroutine_handle<> co;
+	};
+
+	//co_await async_prove(...) on a connected non-blocking socket
+	inline nbawait async_prove(
+		const executor &ex,
+		unsigned int algotype,
+		unsigned char *mbuffer, size_t mlen,
+		unsigned char *obuffer, size_t olen,
+		int csock
+	){
+		return nbawait(ex, a25519_ibi_nbprove(algotype, mbuffer, mlen, obuffer, olen, csock), csock);
+	}
+
+	//co_await async_verify(...) on an accepted non-blocking socket
+	inline nbawait async_verify(
+		const executor &ex,
+		unsigned int algotype,
+		unsigned char *pbuffer, size_t plen,
+		int csock
+	){
+		return nbawait(ex, a25519_ibi_nbverify(algotype, pbuffer, plen, csock), csock);
+	}
+}
+}
+
+#endif
+#endif
+
+#endif
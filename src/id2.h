@@ -44,6 +44,8 @@
 #include "utils/debug.h"
 #include "utils/jbase64.h"
 #include "utils/futil.h"
+#include "utils/kstore.h"
+#include "utils/kconv.h"
 #include "utils/asn1util.h"
 
 #ifdef __cplusplus
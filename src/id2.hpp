@@ -26,6 +26,7 @@
 #ifndef _ID2_HPP_
 #define _ID2_HPP_
 #include "a25519.hpp"
+#include "a25519co.hpp"
 
 //auxiliary helpers
 #include "utils/debug.h"
@@ -0,0 +1,619 @@
+/*
+ * internals/bench.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Benchmark reporting and the per-operation microbenchmark
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "bench.hpp"
+#include "ifcall.hpp"
+#include "proto.hpp"
+#include "dlink.hpp"
+#include "../utils/debug.h"
+#include "../utils/hdrhist.h"
+#include "../utils/mclock.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+#include <sys/socket.h>
+
+//operations in the order they are reported
+enum { OP_KEYGEN, OP_SECSER, OP_PUBSER, OP_SIGSER, OP_SECST, OP_PUBST, OP_SIGST,
+	OP_PUBVW, OP_SIGVW, OP_SIGN, OP_CHECK, OP_SIGNV, OP_CHECKV, OP_PROTO,
+	OP_SECDS, OP_PUBDS, OP_SIGDS, OP_COUNT };
+static const char *opname[OP_COUNT] = {
+	"randkeygen", "secserial", "pubserial", "sigserial",
+	"secstruct", "pubstruct", "sigstruct", "pubview", "sigview",
+	"signatgen", "signatchk", "signatgenv", "signatchkv", "prototest",
+	"secdestroy", "pubdestroy", "sigdestroy",
+};
+
+#define MB_BATCH 8	//signatures per signatgenv/signatchkv call
+#define IP_MAXSTEP 8	//protocol moves tracked per side
+#define IP_QSZ (4*TS_MAXSZ)
+
+//time a single call of op into acc[op]
+#define MB_TIME(op, call) do{ \
+	unsigned long long a0 = allocs != NULL ? allocs() : 0; \
+	uint64_t c0 = mclock_cycles(), t0 = mclock_ns(); \
+	call; \
+	uint64_t t1 = mclock_ns(), c1 = mclock_cycles(); \
+	if(allocs != NULL) acc[op].al += allocs() - a0; \
+	acc[op].cyc += c1 - c0; \
+	hh_record(&acc[op].lat, t1 - t0); \
+}while(0)
+
+//time a call that does n of op, recorded per one
+#define MB_TIMEN(op, n, call) do{ \
+	unsigned long long a0 = allocs != NULL ? allocs() : 0; \
+	uint64_t c0 = mclock_cycles(), t0 = mclock_ns(); \
+	call; \
+	uint64_t t1 = mclock_ns(), c1 = mclock_cycles(); \
+	if(allocs != NULL) acc[op].al += (allocs() - a0) / (n); \
+	acc[op].cyc += (c1 - c0) / (n); \
+	hh_record(&acc[op].lat, (t1 - t0) / (n)); \
+}while(0)
+
+namespace bench{
+
+	void report(const struct result *r, int json){
+		const struct hdrhist *h = r->lat;
+		double secs = (double)r->wall * 1e-9;
+		double rate = secs > 0 ? (double)(r->ok + r->fail) / secs : 0;
+		unsigned long long lmin = h->n ? (unsigned long long)h->min : 0ULL;
+
+		if(json){
+			printf("{\"role\":\"%s\",\"algo\":%u,\"ok\":%lu,\"fail\":%lu,"
+				"\"wall_s\":%.6f,\"ops_per_s\":%.2f,\"lat_ns\":{"
+				"\"min\":%llu,\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,"
+				"\"p999\":%llu,\"max\":%llu,\"mean\":%.1f}}\n",
+				r->role, r->algo, r->ok, r->fail, secs, rate,
+				lmin,
+				(unsigned long long)hh_pct(h, 50.0),
+				(unsigned long long)hh_pct(h, 90.0),
+				(unsigned long long)hh_pct(h, 99.0),
+				(unsigned long long)hh_pct(h, 99.9),
+				(unsigned long long)h->max,
+				hh_mean(h));
+		}else{
+			printf("%s (algo %u): %lu ok, %lu failed in %.3f s, %.1f ops/s\n",
+				r->role, r->algo, r->ok, r->fail, secs, rate);
+			printf("latency us: min %.1f p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f max %.1f mean %.1f\n",
+				lmin * 1e-3,
+				hh_pct(h, 50.0) * 1e-3,
+				hh_pct(h, 90.0) * 1e-3,
+				hh_pct(h, 99.0) * 1e-3,
+				hh_pct(h, 99.9) * 1e-3,
+				h->max * 1e-3,
+				hh_mean(h) * 1e-3);
+		}
+		fflush(stdout);
+	}
+
+	struct opacc{
+		struct hdrhist lat;
+		uint64_t cyc;
+		unsigned long long al;
+	};
+
+	static void mreport(unsigned int a, unsigned int count, int json,
+		const struct opacc *acc, int hasal){
+		const struct opacc *o;
+		int i;
+
+		if(!json){
+			printf("%s (algo %u), %u iterations\n", ifname[a], a, count);
+			printf("  %-12s %12s %12s %12s %10s\n",
+				"op", "ns/op", "p50 ns", "cycles/op", "allocs/op");
+		}
+		for(i = 0; i < OP_COUNT; i++){
+			o = &acc[i];
+			if(json){
+				printf("{\"algo\":%u,\"scheme\":\"%s\",\"op\":\"%s\",\"n\":%u,"
+					"\"ns_per_op\":%.1f,\"p50_ns\":%llu,\"cycles_per_op\":",
+					a, ifname[a], opname[i], count,
+					hh_mean(&o->lat), (unsigned long long)hh_pct(&o->lat, 50.0));
+#ifdef MCLOCK_HAVE_CYCLES
+				printf("%.1f", (double)o->cyc / count);
+#else
+				printf("null");
+#endif
+				printf(",\"allocs_per_op\":");
+				if(hasal) printf("%.2f}\n", (double)o->al / count);
+				else printf("null}\n");
+			}else{
+				printf("  %-12s %12.1f %12llu ", opname[i],
+					hh_mean(&o->lat), (unsigned long long)hh_pct(&o->lat, 50.0));
+#ifdef MCLOCK_HAVE_CYCLES
+				printf("%12.1f ", (double)o->cyc / count);
+#else
+				printf("%12s ", "-");
+#endif
+				if(hasal) printf("%10.2f\n", (double)o->al / count);
+				else printf("%10s\n", "-");
+			}
+		}
+		fflush(stdout);
+	}
+
+	int micro(unsigned int count, int json, unsigned long long (*allocs)(void)){
+		const unsigned char m[] = "alice@example.com";
+		const size_t mlen = sizeof(m) - 1;
+		const struct ialgostr *f;
+		struct opacc *acc;
+		void *sk, *par, *sig, *tmp;
+		struct kview kv;
+		unsigned char *sbuf, *pbuf, *obuf, *bout;
+		size_t slen, plen, olen, lout;
+		const unsigned char *bm[MB_BATCH];
+		size_t bl[MB_BATCH];
+		void *bsig[MB_BATCH], *vsig[MB_BATCH];
+		int brc[MB_BATCH];
+		unsigned int a, i, k;
+		int rc = 0;
+
+		if(count == 0) return 1;
+		acc = (struct opacc *)malloc(OP_COUNT * sizeof(struct opacc));
+		if(acc == NULL) return 1;
+
+		for(a = 0; a < sizeof(iftable)/sizeof(iftable[0]); a++){
+			f = iftable[a];
+			if(f == NULL) continue;
+			memset(acc, 0, OP_COUNT * sizeof(struct opacc));
+			for(i = 0; i < OP_COUNT; i++) hh_reset(&acc[i].lat);
+
+			//fixtures, outside of the measurement
+			f->randkeygen(&sk);
+			f->secserial(sk, &sbuf, &slen);
+			f->pubserial(sk, &pbuf, &plen);
+			f->pubstruct(pbuf, plen, &par);
+			f->signatgen(sk, m, mlen, &sig);
+			f->sigserial(sig, &obuf, &olen);
+			for(k = 0; k < MB_BATCH; k++){
+				bm[k] = m; bl[k] = mlen; vsig[k] = sig;
+			}
+
+			for(i = 0; i < count; i++){
+				MB_TIME(OP_KEYGEN, f->randkeygen(&tmp));
+				f->secdestroy(tmp);
+
+				MB_TIME(OP_SECSER, f->secserial(sk, &bout, &lout));
+				free(bout);
+				MB_TIME(OP_PUBSER, f->pubserial(sk, &bout, &lout));
+				free(bout);
+				MB_TIME(OP_SIGSER, f->sigserial(sig, &bout, &lout));
+				free(bout);
+
+				//each destroy takes what its struct just built
+				MB_TIME(OP_SECST, f->secstruct(sbuf, slen, &tmp));
+				MB_TIME(OP_SECDS, f->secdestroy(tmp));
+				MB_TIME(OP_PUBST, f->pubstruct(pbuf, plen, &tmp));
+				MB_TIME(OP_PUBDS, f->pubdestroy(tmp));
+				MB_TIME(OP_SIGST, f->sigstruct(obuf, olen, &tmp));
+				MB_TIME(OP_SIGDS, f->sigdestroy(tmp));
+				//in place, nothing to destroy
+				MB_TIME(OP_PUBVW, f->pubview(pbuf, plen, &kv));
+				MB_TIME(OP_SIGVW, f->sigview(obuf, olen, &kv));
+
+				MB_TIME(OP_SIGN, f->signatgen(sk, m, mlen, &tmp));
+				f->sigdestroy(tmp);
+				//twn/rss/rtw have no signatchk (always 1), only timed
+				MB_TIME(OP_CHECK, f->signatchk(par, sig, m, mlen));
+				//batched, per signature; without signatchkv, one by one
+				MB_TIMEN(OP_SIGNV, MB_BATCH, f->signatgenv(sk, MB_BATCH, bm, bl, bsig));
+				for(k = 0; k < MB_BATCH; k++) if(bsig[k] != NULL) f->sigdestroy(bsig[k]);
+				if(f->signatchkv != NULL){
+					MB_TIMEN(OP_CHECKV, MB_BATCH, f->signatchkv(par, MB_BATCH, vsig, bm, bl, brc));
+				}else{
+					MB_TIMEN(OP_CHECKV, MB_BATCH,
+						for(k = 0; k < MB_BATCH; k++) brc[k] = f->signatchk(par, sig, m, mlen));
+				}
+				MB_TIME(OP_PROTO, rc |= f->prototest(par, sig, m, mlen));
+			}
+
+			mreport(a, count, json, acc, allocs != NULL);
+
+			f->sigdestroy(sig);
+			f->pubdestroy(par);
+			f->secdestroy(sk);
+			free(sbuf); free(pbuf); free(obuf);
+		}
+
+		free(acc);
+		return rc != 0;
+	}
+
+	//one direction of the in-memory channel
+	struct mq{
+		unsigned char buf[IP_QSZ];
+		size_t r, w;
+	};
+
+	//one side of an in-memory identification, follows nbsess
+	struct mside{
+		const struct ialgostr *f;
+		int prover;
+		void *ctx;
+		struct pstep ps;
+		unsigned char ibuf[TS_MAXSZ];
+		size_t got;
+		int done;
+		unsigned int cur;	//step of the current identification
+		unsigned int steps;	//over all identifications
+		size_t bytes;		//sent
+		uint64_t initns;	//time in init (accumulated)
+		uint64_t stepns[IP_MAXSTEP];	//time per step (accumulated)
+	};
+
+	//step the side until it needs more input than is queued
+	//return 1 if it moved at all, -1 on a protocol error
+	static int madvance(struct mside *m, struct mq *in, struct mq *out){
+		size_t take;
+		uint64_t t0;
+		int rc, moved = 0;
+		while(!m->done){
+			if(m->ps.need > TS_MAXSZ) return -1;
+			if(m->got < m->ps.need){
+				take = in->w - in->r;
+				if(take > m->ps.need - m->got) take = m->ps.need - m->got;
+				memcpy(m->ibuf + m->got, in->buf + in->r, take);
+				in->r += take; m->got += take;
+				if(m->got < m->ps.need) return moved;
+			}
+			m->ps.in = m->ibuf;
+			m->ps.ilen = m->got;
+			t0 = mclock_ns();
+			rc = m->prover ? m->f->prvstep(m->ctx, &m->ps) : m->f->vrfstep(m->ctx, &m->ps);
+			if(m->cur < IP_MAXSTEP) m->stepns[m->cur] += mclock_ns() - t0;
+			m->cur++;
+			m->steps++;
+			if(out->w + m->ps.olen > IP_QSZ){
+				//compact, the queue only ever holds a move or two
+				memmove(out->buf, out->buf + out->r, out->w - out->r);
+				out->w -= out->r; out->r = 0;
+				if(out->w + m->ps.olen > IP_QSZ) return -1;
+			}
+			memcpy(out->buf + out->w, m->ps.out, m->ps.olen);
+			out->w += m->ps.olen;
+			m->bytes += m->ps.olen;
+			m->got = 0;
+			if(rc == PS_DONE) m->done = 1;
+			moved = 1;
+		}
+		return moved;
+	}
+
+	//a complete identification without any I/O, return the protocol result
+	static int memrun(const struct ialgostr *f, void *usk, void *par,
+		const unsigned char *m, size_t mlen, struct mside *p, struct mside *v){
+		struct mq *pv, *vp;
+		int rp, rv, rc = 1;
+		uint64_t t0, t1, t2;
+
+		pv = (struct mq *)malloc(2 * sizeof(struct mq));
+		if(pv == NULL) return 1;
+		vp = pv + 1;
+		pv->r = pv->w = 0; vp->r = vp->w = 0;
+		p->got = v->got = 0;
+		p->done = v->done = 0;
+		p->cur = v->cur = 0;
+		p->ctx = v->ctx = NULL;
+
+		//the ID and the go-ahead are framing, not moves
+		t0 = mclock_ns();
+		if( f->prvinit(usk, m, mlen, &p->ps, &p->ctx) != 0 ) goto done;
+		t1 = mclock_ns();
+		if( f->vrfinit(par, m, mlen, &v->ps, &v->ctx) != 0 ) goto done;
+		t2 = mclock_ns();
+		p->initns += t1 - t0;
+		v->initns += t2 - t1;
+		for(;;){
+			rp = madvance(p, vp, pv);
+			rv = madvance(v, pv, vp);
+			if(rp < 0 || rv < 0) break;
+			if(v->done){ rc = v->ps.rc; break; }
+			if(rp == 0 && rv == 0) break; //neither side can move
+		}
+	done:
+		if(p->ctx != NULL) f->prvfree(p->ctx);
+		if(v->ctx != NULL) f->vrffree(v->ctx);
+		free(pv);
+		return rc;
+	}
+
+	struct vrfarg{
+		const struct ialgostr *f;
+		int fd;
+		void *par;
+		unsigned int count;
+		int rc;
+	};
+
+	static void vrfloop(struct vrfarg *va){
+		unsigned char *mb; size_t ml;
+		unsigned int i;
+		for(i = 0; i < va->count; i++){
+			if( general::server::establish(va->fd, &mb, &ml) != 0 ){ va->rc = 1; return; }
+			va->rc |= va->f->signatvrf(va->fd, va->par, mb, ml);
+			free(mb);
+		}
+	}
+
+	static void ipreport(unsigned int a, unsigned int count, int json,
+		const struct hdrhist *sp, uint64_t spwall,
+		const struct hdrhist *mem, unsigned long long al, int hasal,
+		const struct mside *p, const struct mside *v){
+		double sper = (double)spwall / count;
+		double mper = hh_mean(mem);
+		unsigned int i, np, nv;
+
+		np = p->steps / count; nv = v->steps / count;
+		if(json){
+			printf("{\"algo\":%u,\"scheme\":\"%s\",\"n\":%u,"
+				"\"socketpair\":{\"ns_per_id\":%.1f,\"p50_ns\":%llu,\"p99_ns\":%llu},"
+				"\"memory\":{\"ns_per_id\":%.1f,\"p50_ns\":%llu,\"p99_ns\":%llu,\"allocs_per_id\":",
+				a, ifname[a], count,
+				sper, (unsigned long long)hh_pct(sp, 50.0), (unsigned long long)hh_pct(sp, 99.0),
+				mper, (unsigned long long)hh_pct(mem, 50.0), (unsigned long long)hh_pct(mem, 99.0));
+			if(hasal) printf("%.2f", (double)al / count);
+			else printf("null");
+			printf("},\"transport_ns_per_id\":%.1f,", sper - mper);
+			printf("\"prover\":{\"moves\":%u,\"bytes\":%zu,\"init_ns\":%.1f,\"step_ns\":[",
+				np, p->bytes / count, (double)p->initns / count);
+			for(i = 0; i < np && i < IP_MAXSTEP; i++)
+				printf("%s%.1f", i ? "," : "", (double)p->stepns[i] / count);
+			printf("]},\"verifier\":{\"moves\":%u,\"bytes\":%zu,\"init_ns\":%.1f,\"step_ns\":[",
+				nv, v->bytes / count, (double)v->initns / count);
+			for(i = 0; i < nv && i < IP_MAXSTEP; i++)
+				printf("%s%.1f", i ? "," : "", (double)v->stepns[i] / count);
+			printf("]}}\n");
+		}else{
+			printf("%s (algo %u), %u identifications\n", ifname[a], a, count);
+			printf("  %-11s %12s %12s %12s\n", "path", "ns/id", "p50 ns", "p99 ns");
+			printf("  %-11s %12.1f %12llu %12llu\n", "socketpair", sper,
+				(unsigned long long)hh_pct(sp, 50.0), (unsigned long long)hh_pct(sp, 99.0));
+			printf("  %-11s %12.1f %12llu %12llu", "memory", mper,
+				(unsigned long long)hh_pct(mem, 50.0), (unsigned long long)hh_pct(mem, 99.0));
+			if(hasal) printf("   (%.2f allocs/id)", (double)al / count);
+			printf("\n  %-11s %12.1f\n", "transport", sper - mper);
+			printf("  prover   %u moves, %zu B, init %.1f ns, per move (ns)", np, p->bytes / count,
+				(double)p->initns / count);
+			for(i = 0; i < np && i < IP_MAXSTEP; i++) printf(" %.1f", (double)p->stepns[i] / count);
+			printf("\n  verifier %u moves, %zu B, init %.1f ns, per move (ns)", nv, v->bytes / count,
+				(double)v->initns / count);
+			for(i = 0; i < nv && i < IP_MAXSTEP; i++) printf(" %.1f", (double)v->stepns[i] / count);
+			printf("\n");
+		}
+		fflush(stdout);
+	}
+
+	int inproc(unsigned int count, int json, unsigned long long (*allocs)(void)){
+		const unsigned char m[] = "alice@example.com";
+		const size_t mlen = sizeof(m) - 1;
+		const struct ialgostr *f;
+		struct hdrhist *sp, *mem;
+		struct mside *p, *v;
+		struct vrfarg va;
+		std::thread vt;
+		unsigned char *pbuf, *mb;
+		size_t plen;
+		void *sk, *par, *usk;
+		uint64_t t0, t1, start, spwall;
+		unsigned long long al, a0;
+		unsigned int a, i;
+		int fds[2], rc = 0;
+
+		if(count == 0) return 1;
+		sp = (struct hdrhist *)malloc(2 * sizeof(struct hdrhist));
+		p = (struct mside *)malloc(2 * sizeof(struct mside));
+		if(sp == NULL || p == NULL){ free(sp); free(p); return 1; }
+		mem = sp + 1; v = p + 1;
+
+		for(a = 0; a < sizeof(iftable)/sizeof(iftable[0]); a++){
+			f = iftable[a];
+			if(f == NULL) continue;
+			hh_reset(sp); hh_reset(mem);
+
+			f->randkeygen(&sk);
+			f->pubserial(sk, &pbuf, &plen);
+			f->pubstruct(pbuf, plen, &par);
+			f->signatgen(sk, m, mlen, &usk);
+			free(pbuf);
+
+			//socketpair, one identification runs from a start to the next
+			if( socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0 ){
+				lerror("socketpair failed\n");
+				rc = 1; break;
+			}
+			va.f = f; va.fd = fds[1]; va.par = par; va.count = count; va.rc = 0;
+			vt = std::thread(vrfloop, &va);
+			mb = (unsigned char *)m;
+			start = t0 = mclock_ns();
+			for(i = 0; i < count; i++){
+				if( general::client::establish(fds[0], mb, mlen) != 0 ) break;
+				f->signatprv(fds[0], usk, m, mlen);
+				t1 = mclock_ns();
+				if(i > 0) hh_record(sp, t1 - t0);
+				t0 = t1;
+			}
+			vt.join();
+			t1 = mclock_ns();
+			//the last one ends when the verifier is done with it
+			hh_record(sp, t1 - t0);
+			spwall = t1 - start;
+			close(fds[0]); close(fds[1]);
+			if(i < count || va.rc != 0) rc = 1;
+
+			//memory, the step functions only
+			memset(p, 0, 2 * sizeof(struct mside));
+			p->f = v->f = f;
+			p->prover = 1;
+			al = 0;
+			for(i = 0; i < count; i++){
+				a0 = allocs != NULL ? allocs() : 0;
+				t0 = mclock_ns();
+				rc |= memrun(f, usk, par, m, mlen, p, v);
+				t1 = mclock_ns();
+				if(allocs != NULL) al += allocs() - a0;
+				hh_record(mem, t1 - t0);
+			}
+
+			ipreport(a, count, json, sp, spwall, mem, al, allocs != NULL, p, v);
+
+			f->sigdestroy(usk);
+			f->pubdestroy(par);
+			f->secdestroy(sk);
+		}
+
+		free(sp); free(p);
+		return rc != 0;
+	}
+
+	struct rttarg{
+		const struct ialgostr *f;
+		int fd;
+		void *par;
+		unsigned int count;
+		uint64_t *ends;
+		int rc;
+	};
+
+	static void rttvrf(struct rttarg *ra){
+		unsigned char *mb; size_t ml;
+		unsigned int i;
+		for(i = 0; i < ra->count; i++){
+			if( general::server::establish(ra->fd, &mb, &ml) != 0 ){ ra->rc = 1; return; }
+			ra->rc |= ra->f->signatvrf(ra->fd, ra->par, mb, ml);
+			ra->ends[i] = mclock_ns();
+			free(mb);
+		}
+	}
+
+	static void rttreport(unsigned int a, unsigned int count, int json,
+		const struct a25519_linkopt *lo, const struct hdrhist *h, double fl){
+		unsigned long long lmin = h->n ? (unsigned long long)h->min : 0ULL;
+		if(json){
+			printf("{\"algo\":%u,\"scheme\":\"%s\",\"n\":%u,\"delay_us\":%u,"
+				"\"jitter_us\":%u,\"bandwidth\":%llu,\"flights\":%.2f,\"lat_ns\":{"
+				"\"min\":%llu,\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,"
+				"\"max\":%llu,\"mean\":%.1f}}\n",
+				a, ifname[a], count, lo->delay_us, lo->jitter_us, lo->bandwidth, fl,
+				lmin,
+				(unsigned long long)hh_pct(h, 50.0),
+				(unsigned long long)hh_pct(h, 90.0),
+				(unsigned long long)hh_pct(h, 99.0),
+				(unsigned long long)h->max,
+				hh_mean(h));
+		}else{
+			printf("%s (algo %u), one-way %u us +/- %u us, ", ifname[a], a,
+				lo->delay_us, lo->jitter_us);
+			if(lo->bandwidth > 0) printf("%llu bit/s", lo->bandwidth);
+			else printf("unlimited");
+			printf(", %u identifications, %.1f flights (%.1f round trips) each\n",
+				count, fl, fl / 2);
+			printf("latency ms: min %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f mean %.3f\n",
+				lmin * 1e-6,
+				hh_pct(h, 50.0) * 1e-6,
+				hh_pct(h, 90.0) * 1e-6,
+				hh_pct(h, 99.0) * 1e-6,
+				h->max * 1e-6,
+				hh_mean(h) * 1e-6);
+		}
+		fflush(stdout);
+	}
+
+	int rtt(unsigned int count, int json, const struct a25519_linkopt *lo){
+		const unsigned char m[] = "alice@example.com";
+		const size_t mlen = sizeof(m) - 1;
+		const struct ialgostr *f;
+		struct hdrhist *lat;
+		struct rttarg ra;
+		struct dlink::link *l;
+		std::thread vt;
+		uint64_t *starts, *ends;
+		unsigned char *pbuf, *mb;
+		size_t plen;
+		void *sk, *par, *usk;
+		unsigned int a, i;
+		int pa, vb, rc = 0;
+
+		if(count == 0) return 1;
+		lat = (struct hdrhist *)malloc(sizeof(struct hdrhist));
+		starts = (uint64_t *)malloc(2 * count * sizeof(uint64_t));
+		if(lat == NULL || starts == NULL){ free(lat); free(starts); return 1; }
+		ends = starts + count;
+
+		for(a = 0; a < sizeof(iftable)/sizeof(iftable[0]); a++){
+			f = iftable[a];
+			if(f == NULL) continue;
+			hh_reset(lat);
+
+			f->randkeygen(&sk);
+			f->pubserial(sk, &pbuf, &plen);
+			f->pubstruct(pbuf, plen, &par);
+			f->signatgen(sk, m, mlen, &usk);
+			free(pbuf);
+
+			l = dlink::open(lo, &pa, &vb);
+			if(l == NULL){
+				lerror("failed to open the delaying link\n");
+				rc = 1;
+			}else{
+				ra.f = f; ra.fd = vb; ra.par = par; ra.count = count;
+				ra.ends = ends; ra.rc = 0;
+				vt = std::thread(rttvrf, &ra);
+				mb = (unsigned char *)m;
+				for(i = 0; i < count; i++){
+					starts[i] = mclock_ns();
+					if( general::client::establish(pa, mb, mlen) != 0 ) break;
+					f->signatprv(pa, usk, m, mlen);
+				}
+				//the verifier sees the close only after the last move
+				close(pa);
+				vt.join();
+				close(vb);
+				if(i < count || ra.rc != 0) rc = 1;
+				else{
+					for(i = 0; i < count; i++) hh_record(lat, ends[i] - starts[i]);
+					rttreport(a, count, json, lo, lat, (double)dlink::flights(l) / count);
+				}
+				dlink::join(l);
+			}
+
+			f->sigdestroy(usk);
+			f->pubdestroy(par);
+			f->secdestroy(sk);
+		}
+
+		free(lat); free(starts);
+		return rc != 0;
+	}
+}
@@ -0,0 +1,78 @@
+/*
+ * internals/bench.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Benchmark reporting shared by the test harnesses
+ * and the per-operation, in-process protocol and round trip benchmarks
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _BENCH_HPP_
+#define _BENCH_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct hdrhist;
+struct a25519_linkopt;
+
+namespace bench{
+
+	//outcome of a measured run
+	struct result{
+		const char *role;	//what was measured (e.g. "prove")
+		unsigned int algo;
+		unsigned long ok, fail;
+		uint64_t wall;		//measured wall-clock time (ns)
+		const struct hdrhist *lat;	//per operation latency (ns)
+	};
+
+	//print the result as text, or as a single line JSON object
+	void report(const struct result *r, int json);
+
+	//time every ialgostr operation of every scheme in iftable, count
+	//iterations each, and print ns/op, cycles/op and allocations/op
+	//allocs returns a running allocation count (NULL - not reported)
+	//return 0 if every prototest passed
+	int micro(unsigned int count, int json, unsigned long long (*allocs)(void));
+
+	//run count complete identifications of every scheme in process, once
+	//over a socketpair (signatprv/signatvrf on two threads) and once by
+	//driving the step functions directly over memory, and report both
+	//with the cost of every protocol move
+	//return 0 if every identification was accepted
+	int inproc(unsigned int count, int json, unsigned long long (*allocs)(void));
+
+	//run count identifications of every scheme through a delaying link
+	//(see dlink) and report end-to-end latency and message flights
+	//return 0 if every identification was accepted
+	int rtt(unsigned int count, int json, const struct a25519_linkopt *lo);
+}
+
+#endif
@@ -50,6 +50,14 @@
 // SIGNALS
 //go-ahead
 #define SIG_GA 0x5a
+//verifier overloaded, sent instead of the go-ahead
+#define SIG_BUSY 0xa5
+
+// SANS-IO PROTOCOL STEPS
+//more moves follow
+#define PS_CONT 0
+//protocol complete, result in pstep.rc
+#define PS_DONE 1
 
 #endif
 
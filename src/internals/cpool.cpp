@@ -0,0 +1,210 @@
+/*
+ * internals/cpool.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Prover connection pool
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "cpool.hpp"
+
+#include "../a25519.hpp"
+#include "../utils/debug.h"
+#include "../utils/mclock.h"
+#include "../utils/simplesock.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sodium.h>
+
+#define CP_BACKOFF_MAX 1000 //ms between failed dials, at most
+
+//an authenticated channel waiting to be handed out
+struct chan{
+	int fd;
+	uint64_t born; //ns
+};
+
+struct a25519_cpool{
+	unsigned int a;
+	unsigned char *mbuffer; size_t mlen;
+	unsigned char *obuffer; size_t olen; //serialized usk (secure memory)
+	std::string srv;
+	int port, timeout;
+	size_t size;
+	uint64_t maxage; //ns
+
+	std::mutex mtx;
+	std::condition_variable cv; //refill needed or channel ready
+	std::deque<struct chan> idle;
+	std::thread thr;
+	int stop;
+};
+
+namespace cpool{
+
+	//dial and identify, return the socket or -1
+	static int dial(struct a25519_cpool *p){
+		int fd = sockgen(p->timeout, 1, 0);
+		if(fd == -1) return -1;
+		if( sockconn(fd, p->srv.c_str(), p->port) < 0 ||
+			a25519::ibi::prove(p->a, p->mbuffer, p->mlen, p->obuffer, p->olen, fd) != 0 ){
+			close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	//a channel is stale once the verifier hung up or it is too old
+	static int stale(struct a25519_cpool *p, const struct chan &c, uint64_t now){
+		struct pollfd pf;
+		char b;
+		if(now - c.born > p->maxage) return 1;
+		pf.fd = c.fd;
+		pf.events = POLLIN | POLLRDHUP;
+		pf.revents = 0;
+		if( poll(&pf, 1, 0) <= 0 ) return 0;
+		if( pf.revents & (POLLERR | POLLHUP | POLLRDHUP) ) return 1;
+		return recv(c.fd, &b, 1, MSG_PEEK | MSG_DONTWAIT) == 0;
+	}
+
+	//drop stale channels, call with mtx held
+	static void prune(struct a25519_cpool *p){
+		uint64_t now = mclock_ns();
+		std::deque<struct chan>::iterator it;
+		for(it = p->idle.begin(); it != p->idle.end(); ){
+			if( stale(p, *it, now) ){
+				close(it->fd);
+				it = p->idle.erase(it);
+			}else ++it;
+		}
+	}
+
+	static void refresher(struct a25519_cpool *p){
+		std::unique_lock<std::mutex> lk(p->mtx);
+		unsigned int backoff = 0;
+		struct chan c;
+		while(!p->stop){
+			prune(p);
+			if(p->idle.size() >= p->size){
+				//woken by get, or in time to catch channels ageing out
+				p->cv.wait_for(lk, std::chrono::milliseconds( p->maxage / 4000000ULL + 1 ));
+				continue;
+			}
+			lk.unlock();
+			c.fd = dial(p);
+			c.born = mclock_ns();
+			lk.lock();
+			if(c.fd == -1){
+				backoff = backoff == 0 ? 50 : backoff * 2;
+				if(backoff > CP_BACKOFF_MAX) backoff = CP_BACKOFF_MAX;
+				debug("Pool dial to %s:%d failed, retry in %ums\n", p->srv.c_str(), p->port, backoff);
+				p->cv.wait_for(lk, std::chrono::milliseconds(backoff), [p]{ return p->stop != 0; });
+				continue;
+			}
+			backoff = 0;
+			p->idle.push_back(c);
+			p->cv.notify_all();
+		}
+	}
+
+	struct a25519_cpool *create(
+		unsigned int a,
+		const unsigned char *mbuffer, size_t mlen,
+		const unsigned char *obuffer, size_t olen,
+		const char *srv, int port, int timeout,
+		size_t size, unsigned int maxage
+	){
+		struct a25519_cpool *p = new struct a25519_cpool;
+		p->a = a;
+		p->mbuffer = (unsigned char *)malloc(mlen);
+		p->obuffer = (unsigned char *)sodium_malloc(olen);
+		if(p->mbuffer == NULL || p->obuffer == NULL){
+			lerror("failed to allocate connection pool\n");
+			free(p->mbuffer); sodium_free(p->obuffer);
+			delete p; return NULL;
+		}
+		memcpy(p->mbuffer, mbuffer, mlen); p->mlen = mlen;
+		memcpy(p->obuffer, obuffer, olen); p->olen = olen;
+		p->srv = srv;
+		p->port = port;
+		p->timeout = timeout;
+		p->size = size > 0 ? size : 1;
+		p->maxage = (uint64_t)(maxage > 0 ? maxage : 1) * 1000000ULL;
+		p->stop = 0;
+		p->thr = std::thread(refresher, p);
+		return p;
+	}
+
+	int get(struct a25519_cpool *p, unsigned int wait){
+		std::unique_lock<std::mutex> lk(p->mtx);
+		std::chrono::steady_clock::time_point until =
+			std::chrono::steady_clock::now() + std::chrono::milliseconds(wait);
+		struct chan c;
+		for(;;){
+			prune(p);
+			if(!p->idle.empty()){
+				c = p->idle.front();
+				p->idle.pop_front();
+				p->cv.notify_all(); //refill
+				return c.fd;
+			}
+			if( p->cv.wait_until(lk, until) == std::cv_status::timeout && p->idle.empty() ) break;
+		}
+		lk.unlock();
+		debug("Pool empty, dialing %s:%d inline\n", p->srv.c_str(), p->port);
+		return dial(p);
+	}
+
+	size_t ready(struct a25519_cpool *p){
+		std::lock_guard<std::mutex> lk(p->mtx);
+		return p->idle.size();
+	}
+
+	void destroy(struct a25519_cpool *p){
+		if(p == NULL) return;
+		{
+			std::lock_guard<std::mutex> lk(p->mtx);
+			p->stop = 1;
+			p->cv.notify_all();
+		}
+		p->thr.join();
+		for(const struct chan &c : p->idle) close(c.fd);
+		free(p->mbuffer);
+		sodium_free(p->obuffer);
+		delete p;
+	}
+}
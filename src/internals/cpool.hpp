@@ -0,0 +1,66 @@
+/*
+ * internals/cpool.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Prover connection pool, keeps channels to a verifier authenticated
+ * ahead of demand and refreshes them from a background thread
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _CPOOL_HPP_
+#define _CPOOL_HPP_
+
+#include <stddef.h>
+
+struct a25519_cpool;
+
+namespace cpool{
+
+	//start the pool and its refresher, keys and ID are copied
+	//return NULL on fail
+	struct a25519_cpool *create(
+		unsigned int a,
+		const unsigned char *mbuffer, size_t mlen,
+		const unsigned char *obuffer, size_t olen,
+		const char *srv, int port, int timeout,
+		size_t size, unsigned int maxage
+	);
+
+	//take an authenticated socket, waiting up to wait ms for one
+	//dials inline if none became ready, return -1 on fail
+	int get(struct a25519_cpool *p, unsigned int wait);
+
+	//channels ready to be handed out
+	size_t ready(struct a25519_cpool *p);
+
+	//stop the refresher and close the idle channels
+	void destroy(struct a25519_cpool *p);
+}
+
+#endif
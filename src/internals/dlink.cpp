@@ -0,0 +1,218 @@
+/*
+ * internals/dlink.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Delaying link
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "dlink.hpp"
+#include "../utils/debug.h"
+#include "../utils/mclock.h"
+
+#include <atomic>
+#include <deque>
+#include <new>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sodium.h>
+
+#define DL_CHUNK 65536
+
+struct chunk{
+	uint64_t due;	//delivery time (ns)
+	std::vector<unsigned char> data;
+	size_t off;	//already delivered
+};
+
+//one direction of the link
+struct dpipe{
+	int in, out;	//relay ends, read from in and deliver to out
+	std::deque<struct chunk> q;
+	uint64_t last;	//due time of the newest chunk, delivery keeps order
+	uint64_t busy;	//the wire is busy sending until (bandwidth)
+	int eof, shut, blocked;
+};
+
+namespace dlink{
+
+	struct link{
+		struct a25519_linkopt opt;
+		struct dpipe d[2];
+		int x, y;	//relay ends of a and b
+		int lastdir;
+		std::atomic<unsigned long> nflights;
+		std::thread thr;
+	};
+
+	static void enqueue(struct link *l, int dir, const unsigned char *buf, size_t len){
+		struct dpipe *p = &l->d[dir];
+		struct chunk c;
+		uint64_t now = mclock_ns(), start, due;
+		int64_t jit = 0;
+
+		//serialization at the configured rate, one chunk after another
+		start = now > p->busy ? now : p->busy;
+		if(l->opt.bandwidth > 0) p->busy = start + (uint64_t)len * 8000000000ULL / l->opt.bandwidth;
+		else p->busy = start;
+		if(l->opt.jitter_us > 0)
+			jit = (int64_t)randombytes_uniform(2 * l->opt.jitter_us + 1) - (int64_t)l->opt.jitter_us;
+		due = p->busy + (uint64_t)l->opt.delay_us * 1000ULL;
+		if(jit < 0 && (uint64_t)(-jit) * 1000ULL > due - p->busy) due = p->busy;
+		else due += jit * 1000;
+		//a stream does not reorder
+		if(due < p->last) due = p->last;
+		p->last = due;
+
+		c.due = due;
+		c.data.assign(buf, buf + len);
+		c.off = 0;
+		p->q.push_back(std::move(c));
+
+		if(dir != l->lastdir){
+			l->lastdir = dir;
+			l->nflights.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	//deliver what is due, return the earliest pending due time (0 if none)
+	static uint64_t deliver(struct dpipe *p, uint64_t now){
+		ssize_t r;
+		p->blocked = 0;
+		while(!p->q.empty()){
+			struct chunk &c = p->q.front();
+			if(c.due > now) return c.due;
+			r = send(p->out, c.data.data() + c.off, c.data.size() - c.off,
+				MSG_DONTWAIT | MSG_NOSIGNAL);
+			if(r < 0){
+				if(errno == EINTR) continue;
+				if(errno == EAGAIN || errno == EWOULDBLOCK){ p->blocked = 1; return 0; }
+				//the receiver is gone, what is in flight is lost
+				p->q.clear();
+				return 0;
+			}
+			c.off += (size_t)r;
+			if(c.off == c.data.size()) p->q.pop_front();
+		}
+		return 0;
+	}
+
+	static void relay(struct link *l){
+		unsigned char *buf;
+		struct pollfd pf[2];
+		struct timespec ts;
+		uint64_t now, next, due;
+		ssize_t r;
+		int i;
+
+		buf = (unsigned char *)malloc(DL_CHUNK);
+		if(buf == NULL){
+			lerror("link relay failed to start\n");
+			return;
+		}
+		for(;;){
+			now = mclock_ns();
+			next = 0;
+			for(i = 0; i < 2; i++){
+				due = deliver(&l->d[i], now);
+				if(due != 0 && (next == 0 || due < next)) next = due;
+				//pass the close on once everything before it arrived
+				if(l->d[i].eof && l->d[i].q.empty() && !l->d[i].shut){
+					shutdown(l->d[i].out, SHUT_WR);
+					l->d[i].shut = 1;
+				}
+			}
+			if(l->d[0].shut && l->d[1].shut) break;
+
+			//d[0] reads x and writes y, d[1] the reverse
+			pf[0].fd = l->x; pf[1].fd = l->y;
+			pf[0].events = (l->d[0].eof ? 0 : POLLIN) | (l->d[1].blocked ? POLLOUT : 0);
+			pf[1].events = (l->d[1].eof ? 0 : POLLIN) | (l->d[0].blocked ? POLLOUT : 0);
+			if(next != 0){
+				now = mclock_ns();
+				next = next > now ? next - now : 0;
+				ts.tv_sec = next / 1000000000ULL;
+				ts.tv_nsec = next % 1000000000ULL;
+			}
+			if( ppoll(pf, 2, next != 0 ? &ts : NULL, NULL) < 0 && errno != EINTR ) break;
+
+			for(i = 0; i < 2; i++){
+				if(l->d[i].eof || !(pf[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+				r = recv(l->d[i].in, buf, DL_CHUNK, MSG_DONTWAIT);
+				if(r > 0) enqueue(l, i, buf, (size_t)r);
+				else if(r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+					l->d[i].eof = 1;
+			}
+		}
+		free(buf);
+		close(l->x);
+		close(l->y);
+	}
+
+	struct link *open(const struct a25519_linkopt *opt, int *a, int *b){
+		struct link *l;
+		int s0[2], s1[2], i;
+
+		if( socketpair(AF_UNIX, SOCK_STREAM, 0, s0) != 0 ) return NULL;
+		if( socketpair(AF_UNIX, SOCK_STREAM, 0, s1) != 0 ){
+			close(s0[0]); close(s0[1]);
+			return NULL;
+		}
+		l = new (std::nothrow) struct link;
+		if(l == NULL){
+			close(s0[0]); close(s0[1]); close(s1[0]); close(s1[1]);
+			return NULL;
+		}
+		l->opt = *opt;
+		*a = s0[0]; l->x = s0[1];
+		*b = s1[0]; l->y = s1[1];
+		l->d[0].in = l->x; l->d[0].out = l->y;
+		l->d[1].in = l->y; l->d[1].out = l->x;
+		for(i = 0; i < 2; i++){
+			l->d[i].last = l->d[i].busy = 0;
+			l->d[i].eof = l->d[i].shut = l->d[i].blocked = 0;
+		}
+		l->lastdir = -1;
+		l->nflights.store(0, std::memory_order_relaxed);
+		l->thr = std::thread(relay, l);
+		return l;
+	}
+
+	unsigned long flights(struct link *l){
+		return l->nflights.load(std::memory_order_relaxed);
+	}
+
+	void join(struct link *l){
+		if(l == NULL) return;
+		l->thr.join();
+		delete l;
+	}
+}
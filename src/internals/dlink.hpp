@@ -0,0 +1,60 @@
+/*
+ * internals/dlink.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Delaying link, an in-process stream transport that adds one-way
+ * latency, jitter and a bandwidth limit, to see what round trips cost
+ * without a WAN (or root and netem)
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _DLINK_HPP_
+#define _DLINK_HPP_
+
+#include "../a25519.h"
+#include <stddef.h>
+
+namespace dlink{
+
+	struct link;
+
+	//connect two stream sockets through a relay thread that delays
+	//everything according to opt, the caller owns (and closes) a and b
+	//return NULL on fail
+	struct link *open(const struct a25519_linkopt *opt, int *a, int *b);
+
+	//message flights so far, a flight is data sent after data travelled
+	//the other way (or the first data)
+	unsigned long flights(struct link *l);
+
+	//wait for the relay to finish (both a and b closed) and free it
+	void join(struct link *l);
+}
+
+#endif
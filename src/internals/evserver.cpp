@@ -0,0 +1,537 @@
+/*
+ * internals/evserver.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Event-driven identification server
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "evserver.hpp"
+#include "nbsess.hpp"
+#include "wpool.hpp"
+#include "mpmc.hpp"
+#include "ifcall.hpp"
+#include "twheel.hpp"
+#include "metrics.hpp"
+#include "mexpo.hpp"
+#include "vcache.hpp"
+
+#include "../a25519.h"
+#include "../utils/debug.h"
+#include "../utils/mclock.h"
+#include "../utils/simplesock.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+
+#define EV_MAX 64
+#define EV_TICK 10 //deadline resolution (ms)
+#define EV_DEADLINE 1000 //phase deadline (ms) where none is given, as srvopt_init
+#define EV_QDEPTH 1024 //worker queue capacity where none is given, as srvopt_init
+#define EV_MAXSESS 1024 //sessions in flight where none is given, as srvopt_init
+#define EV_MAXIP 65536 //token buckets kept before pruning
+
+static_assert(NP_ID == A25519_MP_ID && NP_COMMIT == A25519_MP_COMMIT &&
+	NP_RESPONSE == A25519_MP_RESPONSE, "phase numbering");
+
+namespace evserver{
+
+	struct srv;
+
+	//one accepted connection
+	struct conn{
+		struct wpool::job j; //must be first
+		struct nbsess::sess *s;
+		struct srv *sv;
+		struct twheel::tnode tn; //phase deadline
+		int phase; //phase the deadline was armed for
+		int busy; //owned by a worker
+		int admitted; //counted in srv.nadm
+		uint64_t born, pstart; //accepted, entered the phase (ns)
+	};
+
+	//per source address admission rate
+	struct bucket{
+		double tok;
+		uint64_t t; //last refill (ns)
+	};
+
+	struct srv{
+		unsigned int a;
+		void *par;
+		int ssock, efd, evfd, tfd;
+		int tmo; //socket timeout handed to the callback (s)
+		unsigned int dl[3]; //deadline per phase (ms)
+		struct twheel::wheel tw;
+		int ticking; //tfd armed
+		void (*callback)(int, int, const unsigned char *, size_t);
+		struct wpool::pool *pool;
+		mpmc<struct conn *> *cq; //steps completed by the workers
+		std::deque<struct wpool::job *> backlog; //jobs refused by a full pool
+		std::atomic<size_t> nback; //backlog size, readable by poolstat
+		std::unordered_map<int, struct conn *> conns;
+
+		//admission control
+		size_t maxsess; //admitted sessions in flight
+		size_t shedq; //worker queue depth that sheds new sessions
+		double rate, burst; //per address sessions/s
+		size_t nadm;
+		int paused; //listen socket disarmed
+		std::unordered_map<uint32_t, struct bucket> buckets;
+		std::atomic<size_t> nsess;
+		std::atomic<unsigned long long> shed_cap, shed_queue, shed_rate;
+	};
+
+	//pool of the running server, for poolstat
+	static std::mutex gmtx;
+	static struct srv *gsrv = NULL;
+
+	//--------------------------------------------------------------------
+	// worker side
+
+	static void steprun(struct wpool::job *j){
+		struct conn *c = (struct conn *)j;
+		struct srv *sv = c->sv;
+		nbsess::step(c->s);
+		//hand the session back to the I/O thread
+		while( !sv->cq->push(c) ){
+			eventfd_write(sv->evfd, 1);
+			std::this_thread::yield();
+		}
+		eventfd_write(sv->evfd, 1);
+	}
+
+	static void callrun(struct wpool::job *j){
+		struct conn *c = (struct conn *)j;
+		struct nbsess::sess *s = c->s;
+		c->sv->callback(s->rc, s->fd, s->mbuffer, s->mlen);
+		close(s->fd);
+		nbsess::destroy(s);
+		free(c);
+	}
+
+	//--------------------------------------------------------------------
+	// I/O thread side
+
+	static void dispatch(struct srv *sv, struct wpool::job *j){
+		if(sv->pool == NULL){
+			j->run(j);
+			return;
+		}
+		//keep submission order, the backlog drains first
+		if( !sv->backlog.empty() || wpool::submit(sv->pool, j) != 0 ){
+			sv->backlog.push_back(j);
+			sv->nback.store(sv->backlog.size(), std::memory_order_relaxed);
+		}
+	}
+
+	static void arm(struct srv *sv, struct conn *c, unsigned int ev){
+		struct epoll_event e;
+		e.events = ev | EPOLLONESHOT;
+		e.data.ptr = c;
+		epoll_ctl(sv->efd, EPOLL_CTL_MOD, c->s->fd, &e);
+	}
+
+	//arm (on) or disarm the listen socket
+	static void listening(struct srv *sv, int on){
+		struct epoll_event e;
+		if(sv->paused == !on) return;
+		e.events = on ? (uint32_t)EPOLLIN : 0;
+		e.data.ptr = &sv->ssock;
+		epoll_ctl(sv->efd, EPOLL_CTL_MOD, sv->ssock, &e);
+		sv->paused = !on;
+	}
+
+	//account for a session that is over, late if its deadline passed
+	static void record(struct srv *sv, struct conn *c, int late){
+		uint64_t now;
+		struct nbsess::sess *s = c->s;
+		metrics::bytes(sv->a, s->nin, s->nout);
+		if(s->shed){
+			metrics::ended(sv->a, 1, A25519_MR_BUSY);
+		}else if(s->stage == NS_DONE){
+			now = mclock_ns();
+			metrics::phase(sv->a, c->phase, now - c->pstart);
+			metrics::phase(sv->a, A25519_MP_TOTAL, now - c->born);
+			metrics::ended(sv->a, s->rc, A25519_MR_REJECT);
+		}else{
+			metrics::ended(sv->a, 1, late ? A25519_MR_TIMEOUT : A25519_MR_IO);
+		}
+	}
+
+	//protocol over, hand the (now blocking) socket to the callback
+	static void finish(struct srv *sv, struct conn *c, int late){
+		struct timeval tv;
+		int fd = c->s->fd;
+		record(sv, c, late);
+		epoll_ctl(sv->efd, EPOLL_CTL_DEL, fd, NULL);
+		sv->conns.erase(fd);
+		twheel::disarm(&sv->tw, &c->tn);
+		if(c->admitted) sv->nadm--;
+		sv->nsess.store(sv->nadm, std::memory_order_relaxed);
+		if(sv->conns.size() < 2*sv->maxsess) listening(sv, 1);
+
+		if(c->s->shed){
+			//rejected sessions never reach the callback
+			close(fd);
+			nbsess::destroy(c->s);
+			free(c);
+			return;
+		}
+
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+
+		tv.tv_sec = sv->tmo;
+		tv.tv_usec = 0;
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(struct timeval));
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(struct timeval));
+
+		debug("Session on fd %d done (rc=%d)\n", fd, c->s->rc);
+		c->j.run = callrun;
+		dispatch(sv, &c->j);
+	}
+
+	//a phase deadline runs from entering the phase, not from the last byte,
+	//so trickling a move in does not extend it
+	static void deadline(struct srv *sv, struct conn *c){
+		int ph = nbsess::phase(c->s);
+		uint64_t now;
+		if(ph == c->phase && c->tn.next != NULL) return;
+		if(ph != c->phase){
+			now = mclock_ns();
+			metrics::phase(sv->a, c->phase, now - c->pstart);
+			c->pstart = now;
+		}
+		c->phase = ph;
+		//an idle wheel does not tick, catch it up first
+		if(sv->tw.count == 0) sv->tw.now = (mclock_ns() / 1000000ULL) / sv->tw.tick;
+		twheel::arm(&sv->tw, &c->tn, sv->dl[ph]);
+	}
+
+	//decide on admission right before the ID is answered
+	static void admit(struct srv *sv, struct conn *c){
+		if(c->s->shed || c->admitted) return;
+		if(sv->nadm >= sv->maxsess){
+			c->s->shed = 1;
+			sv->shed_cap.fetch_add(1, std::memory_order_relaxed);
+		}else if(sv->pool != NULL &&
+			wpool::depth(sv->pool) + sv->backlog.size() >= sv->shedq){
+			c->s->shed = 1;
+			sv->shed_queue.fetch_add(1, std::memory_order_relaxed);
+		}else{
+			c->admitted = 1;
+			sv->nadm++;
+			sv->nsess.store(sv->nadm, std::memory_order_relaxed);
+		}
+	}
+
+	static void advance(struct srv *sv, struct conn *c){
+		c->busy = 0;
+		if(c->s->stage == NS_ID) admit(sv, c);
+		for(;;){
+			switch( nbsess::pump(c->s) ){
+			case NB_WANTRD:
+				deadline(sv, c);
+				arm(sv, c, EPOLLIN);
+				return;
+			case NB_WANTWR:
+				deadline(sv, c);
+				arm(sv, c, EPOLLOUT);
+				return;
+			case NB_STEP:
+				if(c->s->ps.heavy && sv->pool != NULL){
+					//time spent queued for a worker is not the client's
+					twheel::disarm(&sv->tw, &c->tn);
+					c->busy = 1;
+					c->j.run = steprun;
+					dispatch(sv, &c->j);
+					return;
+				}
+				nbsess::step(c->s);
+				break;
+			default:
+				finish(sv, c, 0);
+				return;
+			}
+		}
+	}
+
+	//take a token from the source address, return 0 if none is left
+	static int ratecheck(struct srv *sv, uint32_t ip){
+		struct bucket *b;
+		uint64_t now = mclock_ns();
+		std::unordered_map<uint32_t, struct bucket>::iterator it;
+		if(sv->rate <= 0) return 1;
+
+		if(sv->buckets.size() >= EV_MAXIP && sv->buckets.find(ip) == sv->buckets.end()){
+			//a refilled bucket is the same as a fresh one
+			for(it = sv->buckets.begin(); it != sv->buckets.end(); ){
+				if( (double)(now - it->second.t) * 1e-9 * sv->rate >= sv->burst ) it = sv->buckets.erase(it);
+				else ++it;
+			}
+		}
+		it = sv->buckets.find(ip);
+		if(it == sv->buckets.end()){
+			b = &sv->buckets[ip];
+			b->tok = sv->burst;
+		}else{
+			b = &it->second;
+			b->tok += (double)(now - b->t) * 1e-9 * sv->rate;
+			if(b->tok > sv->burst) b->tok = sv->burst;
+		}
+		b->t = now;
+		if(b->tok < 1.0) return 0;
+		b->tok -= 1.0;
+		return 1;
+	}
+
+	static void accepts(struct srv *sv){
+		struct epoll_event e;
+		struct sockaddr_in cli;
+		socklen_t cli_len;
+		struct conn *c;
+		int fd;
+		for(;;){
+			if(sv->conns.size() >= 2*sv->maxsess){
+				//sessions being rejected count too, leave the rest to the kernel
+				listening(sv, 0);
+				return;
+			}
+			cli_len = sizeof(struct sockaddr_in);
+			fd = accept4(sv->ssock, (struct sockaddr *)&cli, &cli_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+			if(fd < 0){
+				if(errno == EINTR || errno == ECONNABORTED) continue;
+				return;
+			}
+			c = (struct conn *)malloc(sizeof(struct conn));
+			if(c == NULL || (c->s = nbsess::verifier(sv->a, fd, sv->par)) == NULL){
+				lerror("Unable to allocate session, dropping fd %d\n", fd);
+				free(c); close(fd);
+				continue;
+			}
+			c->sv = sv;
+			c->busy = 0;
+			c->admitted = 0;
+			c->born = c->pstart = mclock_ns();
+			metrics::started(sv->a);
+			if( !ratecheck(sv, cli.sin_addr.s_addr) ){
+				c->s->shed = 1;
+				sv->shed_rate.fetch_add(1, std::memory_order_relaxed);
+			}
+			c->phase = NP_ID;
+			twheel::node(&c->tn);
+			sv->conns[fd] = c;
+
+			//registered disarmed, advance() arms for the first move
+			e.events = EPOLLONESHOT;
+			e.data.ptr = c;
+			epoll_ctl(sv->efd, EPOLL_CTL_ADD, fd, &e);
+			advance(sv, c);
+		}
+	}
+
+	static void completions(struct srv *sv){
+		struct conn *c;
+		eventfd_t v;
+		eventfd_read(sv->evfd, &v);
+		while( sv->cq->pop(c) ) advance(sv, c);
+	}
+
+	//evict a session that overran its phase deadline
+	static void expire(struct twheel::tnode *n, void *arg){
+		struct conn *c = (struct conn *)((char *)n - offsetof(struct conn, tn));
+		debug("Session on fd %d missed its deadline (phase %d)\n", c->s->fd, c->phase);
+		finish((struct srv *)arg, c, 1);
+	}
+
+	static void ticks(struct srv *sv){
+		uint64_t v;
+		if( read(sv->tfd, &v, sizeof(v)) < 0 && errno != EAGAIN ) return;
+		twheel::advance(&sv->tw, mclock_ns() / 1000000ULL, expire, sv);
+	}
+
+	//the tick only runs while deadlines are pending
+	static void tsync(struct srv *sv){
+		struct itimerspec its;
+		int want = sv->tw.count > 0;
+		if(want == sv->ticking) return;
+		memset(&its, 0, sizeof(its));
+		if(want){
+			its.it_interval.tv_nsec = EV_TICK * 1000000L;
+			its.it_value.tv_nsec = EV_TICK * 1000000L;
+		}
+		timerfd_settime(sv->tfd, 0, &its, NULL);
+		sv->ticking = want;
+	}
+
+	static void drain(struct srv *sv){
+		while( !sv->backlog.empty() ){
+			if( wpool::submit(sv->pool, sv->backlog.front()) != 0 ) return;
+			sv->backlog.pop_front();
+			sv->nback.store(sv->backlog.size(), std::memory_order_relaxed);
+		}
+	}
+
+	//a server that failed to start, everything set up so far is released
+	static int teardown(struct srv *sv){
+		if(sv->pool != NULL) wpool::destroy(sv->pool);
+		delete sv->cq;
+		if(sv->tfd >= 0) close(sv->tfd);
+		if(sv->evfd >= 0) close(sv->evfd);
+		if(sv->efd >= 0) close(sv->efd);
+		if(sv->ssock >= 0) close(sv->ssock);
+		if(sv->par != NULL) iftable[sv->a]->pubdestroy(sv->par);
+		return 1;
+	}
+
+	int run(
+		unsigned int a,
+		const unsigned char *pbuffer, size_t plen,
+		int port, const struct a25519_srvopt *opt,
+		void (*callback)(int, int, const unsigned char *, size_t)
+	){
+		struct srv sv;
+		struct epoll_event e, evs[EV_MAX];
+		int i, n, tick;
+		size_t qd;
+
+		sv.a = a;
+		sv.callback = callback;
+		sv.tmo = opt->timeout > 0 ? opt->timeout : 30;
+		//a zero filled option struct gets the usual deadlines, not instant eviction
+		sv.dl[NP_ID] = opt->id_ms > 0 ? (unsigned int)opt->id_ms : EV_DEADLINE;
+		sv.dl[NP_COMMIT] = opt->commit_ms > 0 ? (unsigned int)opt->commit_ms : EV_DEADLINE;
+		sv.dl[NP_RESPONSE] = opt->response_ms > 0 ? (unsigned int)opt->response_ms : EV_DEADLINE;
+		sv.ticking = 0;
+		sv.maxsess = opt->maxsess > 0 ? (size_t)opt->maxsess : EV_MAXSESS;
+		sv.shedq = opt->shedq > 0 ? (size_t)opt->shedq : (size_t)-1;
+		sv.rate = opt->rate;
+		sv.burst = opt->burst > 1 ? opt->burst : 1;
+		sv.nadm = 0;
+		sv.paused = 0;
+		sv.nsess.store(0);
+		sv.shed_cap.store(0);
+		sv.shed_queue.store(0);
+		sv.shed_rate.store(0);
+		twheel::init(&sv.tw, EV_TICK, mclock_ns() / 1000000ULL);
+		sv.pool = NULL;
+		sv.cq = NULL;
+		sv.par = NULL;
+		sv.ssock = sv.efd = sv.evfd = sv.tfd = -1;
+		sv.nback.store(0);
+
+		//the public key is parsed once and shared read-only by all sessions
+		iftable[a]->pubstruct(pbuffer, plen, &sv.par);
+		if(sv.par == NULL){lerror("Invalid public key\n");return teardown(&sv);}
+
+		//sized before any worker can verify
+		if(opt->vcache_bytes > 0 && vcache::resize(opt->vcache_bytes) != 0){
+			lerror("Verifier cache of %zu bytes unavailable\n", opt->vcache_bytes);
+		}
+
+		//Create socket (timeout, rebind, nonblock)
+		sv.ssock = sockgen(0, 1, 1);
+		if(sv.ssock == -1){lerror("Socket creation failed\n");return teardown(&sv);}
+		//bind the socket
+		if(sockbind(sv.ssock,port) < 0){lerror("Port bind failed\n");return teardown(&sv);}
+		listen(sv.ssock, opt->maxcq < 0 ? 0 : opt->maxcq);
+
+		sv.efd = epoll_create1(EPOLL_CLOEXEC);
+		sv.evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		sv.tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		if(sv.efd < 0 || sv.evfd < 0 || sv.tfd < 0){lerror("Event loop setup failed\n");return teardown(&sv);}
+		e.events = EPOLLIN;
+		e.data.ptr = &sv.ssock;
+		epoll_ctl(sv.efd, EPOLL_CTL_ADD, sv.ssock, &e);
+		e.events = EPOLLIN;
+		e.data.ptr = &sv.evfd;
+		epoll_ctl(sv.efd, EPOLL_CTL_ADD, sv.evfd, &e);
+		e.events = EPOLLIN;
+		e.data.ptr = &sv.tfd;
+		epoll_ctl(sv.efd, EPOLL_CTL_ADD, sv.tfd, &e);
+
+		qd = opt->qdepth > 0 ? (size_t)opt->qdepth : EV_QDEPTH;
+		sv.cq = new mpmc<struct conn *>(qd);
+		if(opt->workers > 0){
+			sv.pool = wpool::create((unsigned int)opt->workers, qd);
+			if(sv.pool == NULL){lerror("Worker pool creation failed\n");return teardown(&sv);}
+		}
+		gmtx.lock(); gsrv = &sv; gmtx.unlock();
+		//a scraper can not hold up the event loop, it gets a thread of its own
+		if(opt->metrics_port > 0 && mexpo::start(opt->metrics_port) == NULL){
+			lerror("Metrics page unavailable on port %d\n", opt->metrics_port);
+		}
+
+		debug("Listening for verification attempts on port %d (%d workers)\n",port,opt->workers);
+		while(1){
+			if(sv.pool != NULL) drain(&sv);
+			tsync(&sv);
+			//poll briefly while jobs wait for pool capacity
+			n = epoll_wait(sv.efd, evs, EV_MAX, sv.backlog.empty() ? -1 : 1);
+			tick = 0;
+			for(i=0;i<n;i++){
+				if(evs[i].data.ptr == &sv.ssock) accepts(&sv);
+				else if(evs[i].data.ptr == &sv.evfd) completions(&sv);
+				else if(evs[i].data.ptr == &sv.tfd) tick = 1;
+				else if( !((struct conn *)evs[i].data.ptr)->busy ){
+					advance(&sv, (struct conn *)evs[i].data.ptr);
+				}
+			}
+			//evict last, events of this batch may still refer to the sessions
+			if(tick) ticks(&sv);
+		}
+		return 0;
+	}
+
+	int poolstat(struct a25519_poolstat *out){
+		std::lock_guard<std::mutex> lk(gmtx);
+		if(gsrv == NULL) return 1;
+		memset(out, 0, sizeof(struct a25519_poolstat));
+		if(gsrv->pool != NULL) wpool::stats(gsrv->pool, out);
+		out->backlog = gsrv->nback.load(std::memory_order_relaxed);
+		out->sessions = gsrv->nsess.load(std::memory_order_relaxed);
+		out->shed_cap = gsrv->shed_cap.load(std::memory_order_relaxed);
+		out->shed_queue = gsrv->shed_queue.load(std::memory_order_relaxed);
+		out->shed_rate = gsrv->shed_rate.load(std::memory_order_relaxed);
+		return 0;
+	}
+}
@@ -0,0 +1,60 @@
+/*
+ * internals/evserver.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Event-driven identification server, socket I/O stays on a single
+ * epoll thread while scalar multiplications and user callbacks run
+ * on a bounded worker pool
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _EVSERVER_HPP_
+#define _EVSERVER_HPP_
+
+#include <stddef.h>
+
+struct a25519_srvopt;
+struct a25519_poolstat;
+
+namespace evserver{
+
+	//serve verification attempts on port, only returns on failure
+	int run(
+		unsigned int a,
+		const unsigned char *pbuffer, size_t plen,
+		int port, const struct a25519_srvopt *opt,
+		void (*callback)(int, int, const unsigned char *, size_t)
+	);
+
+	//statistics of the running server's pool
+	//return 0 on success, 1 if no pooled server is running
+	int poolstat(struct a25519_poolstat *out);
+}
+
+#endif
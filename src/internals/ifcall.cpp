@@ -0,0 +1,60 @@
+/*
+ * internals/ifcall.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Scheme function table
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "ifcall.hpp"
+
+#include "tnc25519/base.hpp"
+#include "sch25519/base.hpp"
+#include "tsc25519/base.hpp"
+#include "twn25519/base.hpp"
+#include "rss25519/base.hpp"
+#include "rtw25519/base.hpp"
+
+const struct ialgostr *iftable[10] = {
+	&tnc25519::ftable,
+	NULL,
+	&sch25519::ftable,
+	&tsc25519::ftable,
+	&twn25519::ftable,
+	&rss25519::ftable,
+	&rtw25519::ftable,
+};
+
+const char *ifname[10] = {
+	"tnc25519",
+	NULL,
+	"sch25519",
+	"tsc25519",
+	"twn25519",
+	"rss25519",
+	"rtw25519",
+};
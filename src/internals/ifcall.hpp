@@ -26,22 +26,13 @@
 #ifndef _IFCALL_HPP_
 #define _IFCALL_HPP_
 
-#include "tnc25519/base.hpp"
-#include "sch25519/base.hpp"
-#include "tsc25519/base.hpp"
-#include "twn25519/base.hpp"
-#include "rss25519/base.hpp"
-#include "rtw25519/base.hpp"
+#include "internal.hpp"
 
-const struct ialgostr *iftable[10] = {
-	&tnc25519::ftable,
-	NULL,
-	&sch25519::ftable,
-	&tsc25519::ftable,
-	&twn25519::ftable,
-	&rss25519::ftable,
-	&rtw25519::ftable,
-};
+//function table of all schemes, indexed by algotype (see ifcall.cpp)
+extern const struct ialgostr *iftable[10];
+
+//scheme names, indexed like iftable (NULL where iftable is)
+extern const char *ifname[10];
 
 #define A25519_TNC 		0
 #define A25519_CLI 		1	//TODO: not implemented
@@ -26,6 +26,52 @@
 #ifndef _INTERNAL_HPP_
 #define _INTERNAL_HPP_
 
+#include "cmacro.h"
+#include "nonce.hpp"
+#include <sodium.h>
+#include <stddef.h>
+
+/*
+ * a single protocol move for the sans-io (non-blocking) protocol core
+ * the driver receives 'need' bytes into 'in', calls the step function
+ * and sends 'olen' bytes of 'out' back to the peer
+ */
+struct pstep{
+	const unsigned char *in;	//move received from the peer
+	size_t ilen;
+	unsigned char out[TS_MAXSZ];	//move to send to the peer
+	size_t olen;
+	size_t need;			//bytes expected before the next step
+	int heavy;			//next step performs scalar multiplication
+	int rc;				//protocol result, valid on PS_DONE
+};
+
+/*
+ * storage for a public key or signature parsed in place (pubview and
+ * sigview): the scheme's own struct, its components pointing into the
+ * serialized buffer. nothing is allocated or destroyed, the view is good
+ * for as long as the buffer is and is only ever read through
+ */
+#define KV_MAXC 8
+struct kview{
+	alignas(void *) unsigned char b[KV_MAXC * sizeof(unsigned char *)];
+};
+
+/*
+ * a signature over an ID given piece by piece (signatini, then the ID
+ * through sigabsorb, then signatfin or signatchkp): the challenge hash
+ * midstate as hashpre leaves it, and the nonces drawn for the ID
+ */
+struct sigstream{
+	crypto_hash_sha512_state pre;
+	struct nonce::stream nc;
+};
+
+static inline void sigabsorb(struct sigstream *ss, const unsigned char *mbuffer, size_t mlen){
+	crypto_hash_sha512_update(&ss->pre, mbuffer, mlen);
+	nonce::update(&ss->nc, mbuffer, mlen);
+}
+
 struct ialgostr{
 	void (*randkeygen)(void **);
 	void (*signatgen)( void *, const unsigned char *, size_t, void ** );
@@ -45,5 +91,18 @@ struct ialgostr{
 	int (*signatprv)(int, void *, const unsigned char *, size_t);
 	int (*signatvrf)(int, void *, const unsigned char *, size_t);
 	int (*prototest)(void *, void *, const unsigned char *, size_t);
+	int (*vrfinit)(void *, const unsigned char *, size_t, struct pstep *, void **);
+	int (*vrfstep)(void *, struct pstep *);
+	void (*vrffree)(void *);
+	int (*prvinit)(void *, const unsigned char *, size_t, struct pstep *, void **);
+	int (*prvstep)(void *, struct pstep *);
+	void (*prvfree)(void *);
+	void (*signatgenv)(void *, size_t, const unsigned char *const *, const size_t *, void **);
+	void (*signatchkv)(void *, size_t, void *const *, const unsigned char *const *, const size_t *, int *);
+	int (*pubview)(const unsigned char *, size_t, struct kview *);
+	int (*sigview)(const unsigned char *, size_t, struct kview *);
+	void (*signatini)(void *, struct sigstream *);
+	void (*signatfin)(void *, struct sigstream *, void **);
+	int (*signatchkp)(void *, void *, const struct sigstream *);
 };
 #endif
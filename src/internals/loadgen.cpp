@@ -0,0 +1,343 @@
+/*
+ * internals/loadgen.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Open-loop load generator
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "loadgen.hpp"
+#include "nbsess.hpp"
+#include "twheel.hpp"
+#include "ifcall.hpp"
+#include "../utils/debug.h"
+#include "../utils/mclock.h"
+#include "../utils/hdrhist.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define LG_TICK 10	//wheel tick (ms)
+#define LG_EVENTS 256
+
+// CONNECTION STATES
+#define LC_CONNECT 0	//non-blocking connect in progress
+#define LC_RUN 1	//protocol running
+#define LC_LINGER 2	//done, waiting for the verifier to close first
+
+struct loop;
+
+struct lconn{
+	struct twheel::tnode tn;	//must be first, timeout
+	struct loop *lp;
+	int fd;
+	int state;
+	uint64_t sched;	//intended start (ns), latency counts from here
+	struct nbsess::sess *s;
+};
+
+struct loop{
+	unsigned int a;
+	void *usk;	//shared, prvstep only reads it
+	const unsigned char *mbuffer; size_t mlen;
+	struct sockaddr_in addr;
+	unsigned int timeout;	//ms
+	size_t maxconn, live;
+	uint64_t start, end, interval;	//ns
+	int ep;
+	struct twheel::wheel tw;
+	//outcomes
+	unsigned long started, ok, busy, tmo, err;
+	struct hdrhist *lat;
+};
+
+namespace loadgen{
+
+	static void drop(struct loop *lp, struct lconn *c){
+		twheel::disarm(&lp->tw, &c->tn);
+		close(c->fd);
+		if(c->s != NULL) nbsess::destroy(c->s);
+		free(c);
+		lp->live--;
+	}
+
+	static void watch(struct loop *lp, struct lconn *c, unsigned int ev){
+		struct epoll_event e;
+		e.events = ev;
+		e.data.ptr = c;
+		epoll_ctl(lp->ep, EPOLL_CTL_MOD, c->fd, &e);
+	}
+
+	//start an identification that was due at sched
+	static void launch(struct loop *lp, uint64_t sched){
+		struct lconn *c;
+		struct epoll_event e;
+		int fd;
+
+		lp->started++;
+		fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+		if(fd < 0){ lp->err++; return; }
+		if( connect(fd, (struct sockaddr *)&lp->addr, sizeof(lp->addr)) != 0 &&
+			errno != EINPROGRESS ){
+			close(fd); lp->err++; return;
+		}
+		c = (struct lconn *)malloc(sizeof(struct lconn));
+		if(c == NULL){ close(fd); lp->err++; return; }
+		twheel::node(&c->tn);
+		c->lp = lp;
+		c->fd = fd;
+		c->state = LC_CONNECT;
+		c->sched = sched;
+		c->s = NULL;
+		lp->live++;
+
+		e.events = EPOLLOUT;
+		e.data.ptr = c;
+		if( epoll_ctl(lp->ep, EPOLL_CTL_ADD, fd, &e) != 0 ){
+			lp->err++; drop(lp, c); return;
+		}
+		twheel::arm(&lp->tw, &c->tn, lp->timeout);
+	}
+
+	//run the prover until it blocks or ends
+	static void drive(struct loop *lp, struct lconn *c){
+		for(;;){
+			switch( nbsess::pump(c->s) ){
+			case NB_WANTRD: watch(lp, c, EPOLLIN); return;
+			case NB_WANTWR: watch(lp, c, EPOLLOUT); return;
+			case NB_STEP: nbsess::step(c->s); break;
+			case NB_DONE:
+				lp->ok++;
+				hh_record(lp->lat, mclock_ns() - c->sched);
+				//closing first would leave TIME_WAIT (and a port) with us
+				c->state = LC_LINGER;
+				watch(lp, c, EPOLLIN);
+				twheel::arm(&lp->tw, &c->tn, lp->timeout);
+				return;
+			default:
+				if(nbsess::busy(c->s)) lp->busy++;
+				else lp->err++;
+				drop(lp, c);
+				return;
+			}
+		}
+	}
+
+	static void handle(struct loop *lp, struct lconn *c){
+		unsigned char sink[64];
+		socklen_t len;
+		ssize_t r;
+		int e;
+
+		switch(c->state){
+		case LC_CONNECT:
+			len = sizeof(e);
+			if( getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &e, &len) != 0 || e != 0 ){
+				lp->err++; drop(lp, c); return;
+			}
+			c->s = nbsess::prover(lp->a, c->fd, lp->usk, lp->mbuffer, lp->mlen);
+			if(c->s == NULL){ lp->err++; drop(lp, c); return; }
+			c->state = LC_RUN;
+			drive(lp, c);
+			return;
+		case LC_RUN:
+			drive(lp, c);
+			return;
+		default:
+			do{
+				r = recv(c->fd, sink, sizeof(sink), MSG_DONTWAIT);
+			}while(r > 0 || (r < 0 && errno == EINTR));
+			if(r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+			drop(lp, c);
+		}
+	}
+
+	static void expire(struct twheel::tnode *n, void *arg){
+		struct loop *lp = (struct loop *)arg;
+		struct lconn *c = (struct lconn *)n;
+		//a verifier that keeps the channel open is not a failure
+		if(c->state != LC_LINGER) lp->tmo++;
+		drop(lp, c);
+	}
+
+	static void worker(struct loop *lp){
+		struct epoll_event ev[LG_EVENTS];
+		uint64_t next = lp->start, now;
+		int n, i, wait;
+
+		for(;;){
+			now = mclock_ns();
+			//arrivals held back by maxconn keep their intended start
+			while(next < lp->end && next <= now && lp->live < lp->maxconn){
+				launch(lp, next);
+				next += lp->interval;
+			}
+			if(next >= lp->end && lp->live == 0) break;
+
+			wait = LG_TICK;
+			if(next < lp->end && lp->live < lp->maxconn){
+				wait = next > now ? (int)((next - now + 999999) / 1000000) : 0;
+				if(wait > LG_TICK) wait = LG_TICK;
+			}
+			n = epoll_wait(lp->ep, ev, LG_EVENTS, wait);
+			for(i = 0; i < n; i++) handle(lp, (struct lconn *)ev[i].data.ptr);
+			twheel::advance(&lp->tw, mclock_ns() / 1000000ULL, expire, lp);
+		}
+	}
+
+	static void report(
+		unsigned int a, const struct a25519_loadopt *opt,
+		const struct loop *t, uint64_t wall
+	){
+		const struct hdrhist *h = t->lat;
+		double secs = (double)wall * 1e-9;
+		unsigned long bad = t->busy + t->tmo + t->err;
+		double erate = t->started ? 100.0 * bad / t->started : 0;
+		double tput = secs > 0 ? t->ok / secs : 0;
+		unsigned long long lmin = h->n ? (unsigned long long)h->min : 0ULL;
+
+		if(opt->json){
+			printf("{\"role\":\"load\",\"algo\":%u,\"rate\":%u,\"duration_s\":%u,"
+				"\"threads\":%u,\"maxconn\":%u,\"started\":%lu,\"ok\":%lu,"
+				"\"busy\":%lu,\"timeout\":%lu,\"error\":%lu,\"error_pct\":%.3f,"
+				"\"wall_s\":%.6f,\"ok_per_s\":%.2f,\"lat_ns\":{"
+				"\"min\":%llu,\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,"
+				"\"p999\":%llu,\"max\":%llu,\"mean\":%.1f}}\n",
+				a, opt->rate, opt->duration, opt->threads, opt->maxconn,
+				t->started, t->ok, t->busy, t->tmo, t->err, erate, secs, tput,
+				lmin,
+				(unsigned long long)hh_pct(h, 50.0),
+				(unsigned long long)hh_pct(h, 90.0),
+				(unsigned long long)hh_pct(h, 99.0),
+				(unsigned long long)hh_pct(h, 99.9),
+				(unsigned long long)h->max,
+				hh_mean(h));
+		}else{
+			printf("load (algo %u): offered %u/s for %u s over %u thread(s), %lu started\n",
+				a, opt->rate, opt->duration, opt->threads, t->started);
+			printf("%lu ok, %lu busy, %lu timed out, %lu failed (%.2f%% errors), %.1f ok/s in %.3f s\n",
+				t->ok, t->busy, t->tmo, t->err, erate, tput, secs);
+			printf("latency us: min %.1f p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f max %.1f mean %.1f\n",
+				lmin * 1e-3,
+				hh_pct(h, 50.0) * 1e-3,
+				hh_pct(h, 90.0) * 1e-3,
+				hh_pct(h, 99.0) * 1e-3,
+				hh_pct(h, 99.9) * 1e-3,
+				h->max * 1e-3,
+				hh_mean(h) * 1e-3);
+		}
+		fflush(stdout);
+	}
+
+	int run(
+		unsigned int a,
+		unsigned char *mbuffer, size_t mlen,
+		unsigned char *obuffer, size_t olen,
+		const char *srv, int port,
+		const struct a25519_loadopt *opt
+	){
+		struct loop *lp, total;
+		std::thread *thr;
+		unsigned int nt, i;
+		uint64_t start, span, wall;
+		void *usk;
+		int rc = 1;
+
+		if(opt->rate == 0 || opt->duration == 0){
+			lerror("Load generator needs a rate and a duration\n");
+			return 1;
+		}
+		nt = opt->threads > 0 ? opt->threads : 1;
+		lp = (struct loop *)calloc(nt, sizeof(struct loop));
+		thr = new (std::nothrow) std::thread[nt];
+		if(lp == NULL || thr == NULL){ free(lp); delete[] thr; return 1; }
+
+		iftable[a]->sigstruct(obuffer, olen, &usk);
+
+		//threads interleave their arrivals to make up the total rate
+		start = mclock_ns();
+		span = (uint64_t)opt->duration * 1000000000ULL;
+		for(i = 0; i < nt; i++){
+			lp[i].a = a;
+			lp[i].usk = usk;
+			lp[i].mbuffer = mbuffer; lp[i].mlen = mlen;
+			lp[i].addr.sin_family = AF_INET;
+			lp[i].addr.sin_addr.s_addr = inet_addr(srv);
+			lp[i].addr.sin_port = htons(port);
+			lp[i].timeout = opt->timeout > 0 ? (unsigned int)opt->timeout : 5000;
+			lp[i].maxconn = opt->maxconn / nt > 0 ? opt->maxconn / nt : 1;
+			lp[i].interval = 1000000000ULL * nt / opt->rate;
+			lp[i].start = start + 1000000000ULL * i / opt->rate;
+			lp[i].end = start + span;
+			lp[i].ep = epoll_create1(0);
+			lp[i].lat = (struct hdrhist *)malloc(sizeof(struct hdrhist));
+			if(lp[i].ep < 0 || lp[i].lat == NULL){
+				lerror("Load generator setup failed\n");
+				nt = i + 1;
+				goto done;
+			}
+			hh_reset(lp[i].lat);
+			twheel::init(&lp[i].tw, LG_TICK, start / 1000000ULL);
+		}
+
+		for(i = 0; i < nt; i++) thr[i] = std::thread(worker, &lp[i]);
+		for(i = 0; i < nt; i++) thr[i].join();
+		wall = mclock_ns() - start;
+
+		memset(&total, 0, sizeof(total));
+		total.lat = lp[0].lat;
+		for(i = 0; i < nt; i++){
+			total.started += lp[i].started;
+			total.ok += lp[i].ok;
+			total.busy += lp[i].busy;
+			total.tmo += lp[i].tmo;
+			total.err += lp[i].err;
+			if(i > 0) hh_merge(total.lat, lp[i].lat);
+		}
+		report(a, opt, &total, wall);
+		rc = total.ok == total.started ? 0 : 1;
+
+	done:
+		for(i = 0; i < nt; i++){
+			if(lp[i].ep >= 0) close(lp[i].ep);
+			free(lp[i].lat);
+		}
+		iftable[a]->sigdestroy(usk);
+		delete[] thr;
+		free(lp);
+		return rc;
+	}
+}
@@ -0,0 +1,56 @@
+/*
+ * internals/loadgen.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Open-loop load generator, many concurrent non-blocking prover
+ * sessions against a verifier server
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _LOADGEN_HPP_
+#define _LOADGEN_HPP_
+
+#include "../a25519.h"
+#include <stddef.h>
+
+namespace loadgen{
+
+	//run identifications at opt->rate per second for opt->duration seconds
+	//and report throughput, outcomes and the latency distribution
+	//return 0 if every identification completed
+	int run(
+		unsigned int a,
+		unsigned char *mbuffer, size_t mlen,
+		unsigned char *obuffer, size_t olen,
+		const char *srv, int port,
+		const struct a25519_loadopt *opt
+	);
+}
+
+#endif
@@ -0,0 +1,195 @@
+/*
+ * internals/metrics.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Identification metrics
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "metrics.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#define MT_SUB 2	//2^MT_SUB buckets per power of 2
+#define MT_LO 10	//first bucket ends near 2^MT_LO ns
+#define MT_HI 36	//values from 2^MT_HI ns overflow
+#define MT_ALGOS 10
+
+static_assert( ((MT_HI - MT_LO) << MT_SUB) + 1 == A25519_MH_BUCKETS, "bucket layout" );
+
+typedef std::atomic<uint64_t> mcount;
+
+//a thread's share, written only by that thread (no read-modify-write),
+//read by snapshot at any time
+struct shard{
+	mcount started[MT_ALGOS];
+	mcount ok[MT_ALGOS];
+	mcount fail[MT_ALGOS][A25519_MR_COUNT];
+	mcount bin[MT_ALGOS], bout[MT_ALGOS];
+	mcount hn[MT_ALGOS][A25519_MP_COUNT];
+	mcount hsum[MT_ALGOS][A25519_MP_COUNT];
+	mcount hb[MT_ALGOS][A25519_MP_COUNT][A25519_MH_BUCKETS];
+	std::atomic<int> owned;
+	struct shard *next;
+};
+
+//shards outlive their threads (counts are cumulative), a new thread
+//adopts a released one before allocating
+static std::mutex gmtx;
+static struct shard *ghead = NULL;
+
+namespace metrics{
+
+	struct holder{
+		struct shard *s;
+		~holder(){ if(s != NULL) s->owned.store(0, std::memory_order_release); }
+	};
+	static thread_local struct holder tl = { NULL };
+
+	static struct shard *adopt(void){
+		struct shard *s;
+		std::lock_guard<std::mutex> lk(gmtx);
+		for(s = ghead; s != NULL; s = s->next){
+			if(s->owned.load(std::memory_order_acquire) == 0){
+				s->owned.store(1, std::memory_order_relaxed);
+				return s;
+			}
+		}
+		s = new (std::nothrow) struct shard();
+		if(s == NULL) return NULL;
+		s->owned.store(1, std::memory_order_relaxed);
+		s->next = ghead;
+		ghead = s;
+		return s;
+	}
+
+	static inline struct shard *mine(void){
+		if(tl.s == NULL) tl.s = adopt();
+		return tl.s;
+	}
+
+	//single writer, a plain load and store is enough
+	static inline void add(mcount &c, uint64_t v){
+		c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+	}
+
+	unsigned int bucket(uint64_t ns){
+		unsigned int msb;
+		if(ns < (1ULL << MT_LO)) return 0;
+		msb = 63 - __builtin_clzll(ns);
+		if(msb >= MT_HI) return A25519_MH_BUCKETS - 1;
+		return ((msb - MT_LO) << MT_SUB) +
+			(unsigned int)((ns >> (msb - MT_SUB)) & ((1u << MT_SUB) - 1));
+	}
+
+	uint64_t bound(unsigned int b){
+		unsigned int o;
+		if(b >= A25519_MH_BUCKETS - 1) return ~0ULL;
+		o = MT_LO + (b >> MT_SUB);
+		return (1ULL << o) + ((uint64_t)((b & ((1u << MT_SUB) - 1)) + 1) << (o - MT_SUB));
+	}
+
+	void started(unsigned int a){
+		struct shard *s = mine();
+		if(s == NULL || a >= MT_ALGOS) return;
+		add(s->started[a], 1);
+	}
+
+	void ended(unsigned int a, int rc, int why){
+		struct shard *s = mine();
+		if(s == NULL || a >= MT_ALGOS) return;
+		if(rc == 0) add(s->ok[a], 1);
+		else if(why >= 0 && why < A25519_MR_COUNT) add(s->fail[a][why], 1);
+	}
+
+	void phase(unsigned int a, int ph, uint64_t ns){
+		struct shard *s = mine();
+		if(s == NULL || a >= MT_ALGOS || ph < 0 || ph >= A25519_MP_COUNT) return;
+		add(s->hb[a][ph][bucket(ns)], 1);
+		add(s->hsum[a][ph], ns);
+		add(s->hn[a][ph], 1);
+	}
+
+	void bytes(unsigned int a, size_t in, size_t out){
+		struct shard *s = mine();
+		if(s == NULL || a >= MT_ALGOS) return;
+		if(in > 0) add(s->bin[a], in);
+		if(out > 0) add(s->bout[a], out);
+	}
+
+	void snapshot(struct a25519_metrics *out){
+		struct shard *s;
+		struct a25519_ident *d;
+		unsigned long long done;
+		int a, i, j;
+
+		memset(out, 0, sizeof(struct a25519_metrics));
+		std::lock_guard<std::mutex> lk(gmtx);
+		for(s = ghead; s != NULL; s = s->next){
+			for(a = 0; a < MT_ALGOS; a++){
+				d = &out->algo[a];
+				d->started += s->started[a].load(std::memory_order_relaxed);
+				d->ok += s->ok[a].load(std::memory_order_relaxed);
+				for(i = 0; i < A25519_MR_COUNT; i++)
+					d->fail[i] += s->fail[a][i].load(std::memory_order_relaxed);
+				d->bytes_in += s->bin[a].load(std::memory_order_relaxed);
+				d->bytes_out += s->bout[a].load(std::memory_order_relaxed);
+				for(i = 0; i < A25519_MP_COUNT; i++){
+					d->lat[i].n += s->hn[a][i].load(std::memory_order_relaxed);
+					d->lat[i].sum_ns += s->hsum[a][i].load(std::memory_order_relaxed);
+					for(j = 0; j < A25519_MH_BUCKETS; j++)
+						d->lat[i].bucket[j] += s->hb[a][i][j].load(std::memory_order_relaxed);
+				}
+			}
+		}
+		//sessions start and end on different threads, only the sum is exact
+		for(a = 0; a < MT_ALGOS; a++){
+			d = &out->algo[a];
+			done = d->ok;
+			for(i = 0; i < A25519_MR_COUNT; i++) done += d->fail[i];
+			d->active = d->started > done ? d->started - done : 0;
+		}
+	}
+
+	uint64_t pct(const struct a25519_mhist *h, double p){
+		unsigned long long want, seen = 0;
+		unsigned int b;
+		if(h->n == 0) return 0;
+		if(p < 0) p = 0;
+		if(p > 100) p = 100;
+		want = (unsigned long long)(p / 100.0 * (double)h->n + 0.5);
+		if(want == 0) want = 1;
+		for(b = 0; b < A25519_MH_BUCKETS; b++){
+			seen += h->bucket[b];
+			if(seen >= want) return bound(b);
+		}
+		return bound(A25519_MH_BUCKETS - 1);
+	}
+}
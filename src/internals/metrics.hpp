@@ -0,0 +1,70 @@
+/*
+ * internals/metrics.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Identification metrics, per-thread shards of counters and latency
+ * histograms that are only ever written by their own thread and merged
+ * when a snapshot is taken
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _METRICS_HPP_
+#define _METRICS_HPP_
+
+#include "../a25519.h"
+#include <stddef.h>
+#include <stdint.h>
+
+namespace metrics{
+
+	//a verifier session was accepted
+	void started(unsigned int a);
+
+	//a session ended, rc 0 for an accepted identification,
+	//otherwise why is one of A25519_MR_*
+	void ended(unsigned int a, int rc, int why);
+
+	//time spent in a phase (A25519_MP_*)
+	void phase(unsigned int a, int ph, uint64_t ns);
+
+	//protocol bytes of a verifier session
+	void bytes(unsigned int a, size_t in, size_t out);
+
+	//merge all shards into out
+	void snapshot(struct a25519_metrics *out);
+
+	//histogram bucket of a value, and the upper bound of a bucket
+	unsigned int bucket(uint64_t ns);
+	uint64_t bound(unsigned int b);
+
+	//value at percentile p of a histogram
+	uint64_t pct(const struct a25519_mhist *h, double p);
+}
+
+#endif
@@ -0,0 +1,281 @@
+/*
+ * internals/mexpo.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Metrics exposition
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "mexpo.hpp"
+#include "metrics.hpp"
+#include "evserver.hpp"
+#include "ifcall.hpp"
+#include "optrace.hpp"
+#include "vcache.hpp"
+#include "../utils/debug.h"
+#include "../utils/simplesock.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#define MX_REQMAX 2048	//request head, anything longer is refused
+#define MX_POLL 200	//ms between checks for stop
+#define MX_TIMEOUT 2	//seconds a scraper gets to send its request
+#define MX_EVENTS 512	//trace events drained at a time
+
+static const char *mreason[A25519_MR_COUNT] = { "reject", "timeout", "io", "busy" };
+static const char *mphase[A25519_MP_COUNT] = { "id", "commit", "response", "total" };
+
+namespace mexpo{
+
+	struct page{
+		int ssock;
+		std::atomic<int> stop;
+		std::thread thr;
+	};
+
+	static void put(std::string &out, const char *fmt, ...){
+		char line[256];
+		va_list ap;
+		va_start(ap, fmt);
+		vsnprintf(line, sizeof(line), fmt, ap);
+		va_end(ap);
+		out += line;
+	}
+
+	static void family(std::string &out, const char *name, const char *type, const char *help){
+		put(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+	}
+
+	void render(std::string &out){
+		struct a25519_metrics *m;
+		struct a25519_poolstat ps;
+		struct a25519_vcstat vc;
+		const struct a25519_ident *d;
+		const struct a25519_mhist *h;
+		unsigned long long cum;
+		int a, i, b;
+		int used[10];
+
+		m = (struct a25519_metrics *)malloc(sizeof(struct a25519_metrics));
+		if(m == NULL) return;
+		metrics::snapshot(m);
+		//schemes that never saw a session stay out of the page
+		for(a = 0; a < 10; a++) used[a] = ifname[a] != NULL && m->algo[a].started > 0;
+
+		family(out, "id2_sessions_started_total", "counter", "Verifier sessions accepted.");
+		for(a = 0; a < 10; a++) if(used[a])
+			put(out, "id2_sessions_started_total{scheme=\"%s\"} %llu\n", ifname[a], m->algo[a].started);
+
+		family(out, "id2_identifications_total", "counter", "Finished identifications by result.");
+		for(a = 0; a < 10; a++) if(used[a]){
+			d = &m->algo[a];
+			put(out, "id2_identifications_total{scheme=\"%s\",result=\"ok\"} %llu\n", ifname[a], d->ok);
+			for(i = 0; i < A25519_MR_COUNT; i++)
+				put(out, "id2_identifications_total{scheme=\"%s\",result=\"%s\"} %llu\n",
+					ifname[a], mreason[i], d->fail[i]);
+		}
+
+		family(out, "id2_sessions_active", "gauge", "Verifier sessions in flight.");
+		for(a = 0; a < 10; a++) if(used[a])
+			put(out, "id2_sessions_active{scheme=\"%s\"} %llu\n", ifname[a], m->algo[a].active);
+
+		family(out, "id2_protocol_bytes_total", "counter", "Protocol bytes of verifier sessions.");
+		for(a = 0; a < 10; a++) if(used[a]){
+			put(out, "id2_protocol_bytes_total{scheme=\"%s\",direction=\"in\"} %llu\n", ifname[a], m->algo[a].bytes_in);
+			put(out, "id2_protocol_bytes_total{scheme=\"%s\",direction=\"out\"} %llu\n", ifname[a], m->algo[a].bytes_out);
+		}
+
+		//one bucket per power of 2 is plenty for a scraper
+		family(out, "id2_phase_seconds", "histogram", "Time spent per protocol phase.");
+		for(a = 0; a < 10; a++) if(used[a]){
+			for(i = 0; i < A25519_MP_COUNT; i++){
+				h = &m->algo[a].lat[i];
+				cum = 0;
+				for(b = 0; b < A25519_MH_BUCKETS - 1; b++){
+					cum += h->bucket[b];
+					if((b & 3) != 3) continue;
+					put(out, "id2_phase_seconds_bucket{scheme=\"%s\",phase=\"%s\",le=\"%.6g\"} %llu\n",
+						ifname[a], mphase[i], metrics::bound(b) * 1e-9, cum);
+				}
+				put(out, "id2_phase_seconds_bucket{scheme=\"%s\",phase=\"%s\",le=\"+Inf\"} %llu\n",
+					ifname[a], mphase[i], h->n);
+				put(out, "id2_phase_seconds_sum{scheme=\"%s\",phase=\"%s\"} %.9f\n",
+					ifname[a], mphase[i], h->sum_ns * 1e-9);
+				put(out, "id2_phase_seconds_count{scheme=\"%s\",phase=\"%s\"} %llu\n",
+					ifname[a], mphase[i], h->n);
+			}
+		}
+
+		//for a glance with curl, the histogram is the one to aggregate
+		family(out, "id2_identification_seconds", "gauge",
+			"Identification latency percentiles since start (fine buckets).");
+		for(a = 0; a < 10; a++) if(used[a]){
+			h = &m->algo[a].lat[A25519_MP_TOTAL];
+			put(out, "id2_identification_seconds{scheme=\"%s\",quantile=\"0.5\"} %.6g\n",
+				ifname[a], metrics::pct(h, 50.0) * 1e-9);
+			put(out, "id2_identification_seconds{scheme=\"%s\",quantile=\"0.9\"} %.6g\n",
+				ifname[a], metrics::pct(h, 90.0) * 1e-9);
+			put(out, "id2_identification_seconds{scheme=\"%s\",quantile=\"0.99\"} %.6g\n",
+				ifname[a], metrics::pct(h, 99.0) * 1e-9);
+		}
+
+		if( evserver::poolstat(&ps) == 0 ){
+			family(out, "id2_pool_workers", "gauge", "Worker threads of the pooled server.");
+			put(out, "id2_pool_workers %u\n", ps.workers);
+			family(out, "id2_pool_queue_depth", "gauge", "Jobs queued for the workers.");
+			put(out, "id2_pool_queue_depth %zu\n", ps.qdepth);
+			family(out, "id2_pool_backlog", "gauge", "Jobs held back by the I/O thread.");
+			put(out, "id2_pool_backlog %zu\n", ps.backlog);
+			family(out, "id2_sessions_shed_total", "counter", "Sessions turned away by admission control.");
+			put(out, "id2_sessions_shed_total{reason=\"cap\"} %llu\n", ps.shed_cap);
+			put(out, "id2_sessions_shed_total{reason=\"queue\"} %llu\n", ps.shed_queue);
+			put(out, "id2_sessions_shed_total{reason=\"rate\"} %llu\n", ps.shed_rate);
+		}
+
+		vcache::stats(&vc);
+		if(vc.capacity > 0){
+			family(out, "id2_vcache_lookups_total", "counter", "Verifier cache lookups.");
+			put(out, "id2_vcache_lookups_total{result=\"hit\"} %llu\n", vc.hits);
+			put(out, "id2_vcache_lookups_total{result=\"miss\"} %llu\n", vc.misses);
+			family(out, "id2_vcache_evictions_total", "counter", "Verifier cache entries replaced to make room.");
+			put(out, "id2_vcache_evictions_total %llu\n", vc.evictions);
+			family(out, "id2_vcache_entries", "gauge", "Verifier cache entries in use.");
+			put(out, "id2_vcache_entries %zu\n", vc.entries);
+			family(out, "id2_vcache_bytes", "gauge", "Memory held by the verifier cache.");
+			put(out, "id2_vcache_bytes %zu\n", vc.bytes);
+		}
+		free(m);
+	}
+
+	//drain the operation trace, one event per line
+	static void events(std::string &out){
+		struct a25519_opevent ev[MX_EVENTS];
+		size_t i, n;
+		out += "# ring scheme op start_ns dur_ns lost\n";
+		do{
+			n = optrace::drain(ev, MX_EVENTS);
+			for(i = 0; i < n; i++){
+				put(out, "%u %s %s %llu %llu %u\n", ev[i].ring,
+					ev[i].algo < 10 && ifname[ev[i].algo] != NULL ? ifname[ev[i].algo] : "?",
+					optrace::opname(ev[i].op), ev[i].start_ns, ev[i].dur_ns, ev[i].lost);
+			}
+		}while(n == MX_EVENTS);
+	}
+
+	static void respond(int csock){
+		char req[MX_REQMAX + 1];
+		std::string body, head;
+		size_t got = 0;
+		int r;
+		struct timeval tv;
+
+		tv.tv_sec = MX_TIMEOUT;
+		tv.tv_usec = 0;
+		setsockopt(csock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(struct timeval));
+		setsockopt(csock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(struct timeval));
+
+		//only the request head matters
+		while(got < MX_REQMAX){
+			r = recvbuf(csock, req + got, MX_REQMAX - got);
+			if(r <= 0) return;
+			got += (size_t)r;
+			req[got] = '\0';
+			if(strstr(req, "\r\n\r\n") != NULL || strstr(req, "\n\n") != NULL) break;
+		}
+		req[got] = '\0';
+
+		if(strncmp(req, "GET /metrics ", 13) == 0 || strncmp(req, "GET /metrics?", 13) == 0){
+			render(body);
+			head = "HTTP/1.0 200 OK\r\n"
+				"Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+		}else if(strncmp(req, "GET /trace/on ", 14) == 0 || strncmp(req, "GET /trace/off ", 15) == 0){
+			body = optrace::enable(req[12] == 'n') ? "was on\n" : "was off\n";
+			head = "HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\n";
+		}else if(strncmp(req, "GET /trace ", 11) == 0){
+			events(body);
+			head = "HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\n";
+		}else{
+			body = "not found, try /metrics, /trace, /trace/on or /trace/off\n";
+			head = "HTTP/1.0 404 Not Found\r\nContent-Type: text/plain\r\n";
+		}
+		head += "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+		head += body;
+		//a scraper hanging up early must not take the server down with SIGPIPE
+		for(got = 0; got < head.size(); got += (size_t)r){
+			r = send(csock, head.data() + got, head.size() - got, MSG_NOSIGNAL);
+			if(r <= 0) return;
+		}
+	}
+
+	static void serve(struct page *p){
+		struct pollfd pf;
+		int csock;
+		pf.fd = p->ssock;
+		pf.events = POLLIN;
+		while( !p->stop.load(std::memory_order_relaxed) ){
+			if( poll(&pf, 1, MX_POLL) <= 0 ) continue;
+			csock = accept(p->ssock, NULL, NULL);
+			if(csock < 0) continue;
+			respond(csock);
+			close(csock);
+		}
+	}
+
+	struct page *start(int port){
+		struct page *p = new (std::nothrow) struct page;
+		if(p == NULL) return NULL;
+		p->stop.store(0);
+		p->ssock = sockgen(0, 1, 0);
+		if(p->ssock == -1){ delete p; return NULL; }
+		if( sockbindaddr(p->ssock, "127.0.0.1", port) < 0 ){
+			lerror("Metrics port bind failed\n");
+			close(p->ssock); delete p; return NULL;
+		}
+		listen(p->ssock, 8);
+		p->thr = std::thread(serve, p);
+		debug("Serving metrics on 127.0.0.1:%d/metrics\n", port);
+		return p;
+	}
+
+	void stop(struct page *p){
+		if(p == NULL) return;
+		p->stop.store(1);
+		p->thr.join();
+		close(p->ssock);
+		delete p;
+	}
+}
@@ -0,0 +1,57 @@
+/*
+ * internals/mexpo.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Metrics exposition, a minimal HTTP responder that serves the metrics
+ * registry in the Prometheus text format on GET /metrics, and the
+ * operation trace on GET /trace (/trace/on and /trace/off to toggle it)
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _MEXPO_HPP_
+#define _MEXPO_HPP_
+
+#include <string>
+
+namespace mexpo{
+
+	struct page;
+
+	//serve on 127.0.0.1:port from a thread of its own
+	//return NULL on fail
+	struct page *start(int port);
+
+	//stop serving and free
+	void stop(struct page *p);
+
+	//append the exposition text of the current metrics to out
+	void render(std::string &out);
+}
+
+#endif
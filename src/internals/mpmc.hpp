@@ -0,0 +1,125 @@
+/*
+ * internals/mpmc.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Bounded lock-free multi-producer multi-consumer queue
+ * (D. Vyukov's sequenced ring), capacity is rounded up to a power of 2
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _MPMC_HPP_
+#define _MPMC_HPP_
+
+#include <atomic>
+#include <cstdlib>
+#include <stddef.h>
+
+#define MPMC_MAXCAP ((size_t)1 << 24) //larger requests are clamped to this
+
+template <typename T>
+class mpmc{
+public:
+	explicit mpmc(size_t cap){
+		size_t i;
+		if(cap > MPMC_MAXCAP) cap = MPMC_MAXCAP;
+		for(sz = 2; sz < cap; sz <<= 1);
+		mask = sz - 1;
+		ring = new cell[sz];
+		for(i=0; i<sz; i++) ring[i].seq.store(i, std::memory_order_relaxed);
+		head.store(0, std::memory_order_relaxed);
+		tail.store(0, std::memory_order_relaxed);
+	}
+	~mpmc(){ delete[] ring; }
+
+	//return false if the queue is full
+	bool push(T v){
+		cell *c; size_t pos, seq; long dif;
+		pos = head.load(std::memory_order_relaxed);
+		for(;;){
+			c = &ring[pos & mask];
+			seq = c->seq.load(std::memory_order_acquire);
+			dif = (long)seq - (long)pos;
+			if(dif == 0){
+				if(head.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) break;
+			}else if(dif < 0){
+				return false;
+			}else{
+				pos = head.load(std::memory_order_relaxed);
+			}
+		}
+		c->data = v;
+		c->seq.store(pos+1, std::memory_order_release);
+		return true;
+	}
+
+	//return false if the queue is empty
+	bool pop(T &v){
+		cell *c; size_t pos, seq; long dif;
+		pos = tail.load(std::memory_order_relaxed);
+		for(;;){
+			c = &ring[pos & mask];
+			seq = c->seq.load(std::memory_order_acquire);
+			dif = (long)seq - (long)(pos+1);
+			if(dif == 0){
+				if(tail.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) break;
+			}else if(dif < 0){
+				return false;
+			}else{
+				pos = tail.load(std::memory_order_relaxed);
+			}
+		}
+		v = c->data;
+		c->seq.store(pos+mask+1, std::memory_order_release);
+		return true;
+	}
+
+	//approximate number of queued items
+	size_t depth() const {
+		size_t h = head.load(std::memory_order_relaxed);
+		size_t t = tail.load(std::memory_order_relaxed);
+		return h > t ? h - t : 0;
+	}
+
+	size_t capacity() const { return sz; }
+
+private:
+	struct cell{
+		std::atomic<size_t> seq;
+		T data;
+	};
+	cell *ring;
+	size_t sz, mask;
+	alignas(64) std::atomic<size_t> head; //enqueue position
+	alignas(64) std::atomic<size_t> tail; //dequeue position
+
+	mpmc(const mpmc &);
+	mpmc &operator=(const mpmc &);
+};
+
+#endif
@@ -0,0 +1,244 @@
+/*
+ * internals/nbsess.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Non-blocking protocol session
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "nbsess.hpp"
+#include "ifcall.hpp"
+#include "../utils/debug.h"
+#include "../utils/usdt.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sodium.h>
+
+static_assert( NS_VERIFIER == USDT_VERIFIER && NS_PROVER == USDT_PROVER, "probe roles" );
+
+namespace nbsess{
+
+	static struct sess *alloc(unsigned int a, int fd, int role, void *par){
+		struct sess *s = (struct sess *)malloc(sizeof(struct sess));
+		if(s == NULL){
+			lerror("failed to allocate session\n");
+			return NULL;
+		}
+		s->a = a;
+		s->fd = fd;
+		s->role = role;
+		s->stage = NS_ID;
+		s->par = par;
+		s->ctx = NULL;
+		s->obuf = NULL;
+		s->olen = 0; s->sent = 0;
+		s->got = 0;
+		s->moves = 0;
+		s->nin = 0; s->nout = 0;
+		s->ack[0] = 0;
+		s->mbuffer = NULL;
+		s->mlen = 0;
+		s->last = 0;
+		s->shed = 0;
+		s->rc = 1;
+		probe_session_start(a, fd, role);
+		probe_establish_start(fd, role);
+		return s;
+	}
+
+	struct sess *verifier(unsigned int a, int fd, void *par){
+		return alloc(a, fd, NS_VERIFIER, par);
+	}
+
+	struct sess *prover(
+		unsigned int a, int fd, void *usk,
+		const unsigned char *mbuffer, size_t mlen
+	){
+		struct sess *s;
+		if(mlen == 0 || mlen > TS_MAXSZ) return NULL;
+		s = alloc(a, fd, NS_PROVER, usk);
+		if(s == NULL) return NULL;
+		s->mbuffer = (unsigned char *)malloc(mlen);
+		if(s->mbuffer == NULL){
+			free(s); return NULL;
+		}
+		memcpy(s->mbuffer, mbuffer, mlen);
+		s->mlen = mlen;
+		if( iftable[a]->prvinit(usk, s->mbuffer, mlen, &s->ps, &s->ctx) != 0 ){
+			destroy(s); return NULL;
+		}
+		//send the ID string, then await the go-ahead
+		s->obuf = s->mbuffer; s->olen = mlen; s->sent = 0;
+		s->stage = NS_SEND;
+		return s;
+	}
+
+	static int wouldblock(void){
+		return errno == EAGAIN || errno == EWOULDBLOCK;
+	}
+
+	int pump(struct sess *s){
+		ssize_t r;
+		for(;;){
+			switch(s->stage){
+			case NS_ID:
+				//the ID arrives in a single segment, as in general::server::establish
+				r = recv(s->fd, s->ibuf, TS_MAXSZ, MSG_DONTWAIT);
+				if(r < 0){
+					if(errno == EINTR) continue;
+					return wouldblock() ? NB_WANTRD : NB_ERROR;
+				}
+				if(r == 0) return NB_ERROR;
+				s->nin += (size_t)r;
+				s->mlen = (size_t)r;
+				s->mbuffer = (unsigned char *)malloc(s->mlen);
+				if(s->mbuffer == NULL) return NB_ERROR;
+				memcpy(s->mbuffer, s->ibuf, s->mlen);
+				if(s->shed){
+					//rejected before any scalar multiplication
+					s->ack[0] = SIG_BUSY;
+					s->obuf = s->ack; s->olen = 1; s->sent = 0;
+					s->last = 1;
+					s->stage = NS_SEND;
+					break;
+				}
+				if( iftable[s->a]->vrfinit(s->par, s->mbuffer, s->mlen, &s->ps, &s->ctx) != 0 ){
+					return NB_ERROR;
+				}
+				probe_establish_done(s->fd, s->role, 0);
+				//send a go-ahead
+				s->ack[0] = SIG_GA;
+				s->obuf = s->ack; s->olen = 1; s->sent = 0;
+				s->stage = NS_SEND;
+				break;
+
+			case NS_SEND:
+				while(s->sent < s->olen){
+					r = send(s->fd, s->obuf + s->sent, s->olen - s->sent,
+						MSG_DONTWAIT | MSG_NOSIGNAL);
+					if(r < 0){
+						if(errno == EINTR) continue;
+						return wouldblock() ? NB_WANTWR : NB_ERROR;
+					}
+					s->sent += (size_t)r;
+					s->nout += (size_t)r;
+				}
+				if(s->obuf == s->ps.out) probe_move_send(s->a, s->fd, s->role, s->olen);
+				if(s->last){
+					s->stage = NS_DONE;
+					break;
+				}
+				if(s->role == NS_PROVER && s->obuf == s->mbuffer){
+					s->stage = NS_GA;
+					break;
+				}
+				s->got = 0;
+				//some schemes move twice in a row (e.g. go-ahead then pre-challenge)
+				s->stage = s->ps.need == 0 ? NS_STEP : NS_RECV;
+				break;
+
+			case NS_RECV:
+				while(s->got < s->ps.need){
+					r = recv(s->fd, s->ibuf + s->got, s->ps.need - s->got, MSG_DONTWAIT);
+					if(r < 0){
+						if(errno == EINTR) continue;
+						return wouldblock() ? NB_WANTRD : NB_ERROR;
+					}
+					if(r == 0) return NB_ERROR;
+					s->got += (size_t)r;
+					s->nin += (size_t)r;
+				}
+				probe_move_recv(s->a, s->fd, s->role, s->got);
+				s->moves++;
+				s->stage = NS_STEP;
+				break;
+
+			case NS_GA:
+				r = recv(s->fd, s->ack, 1, MSG_DONTWAIT);
+				if(r < 0){
+					if(errno == EINTR) continue;
+					return wouldblock() ? NB_WANTRD : NB_ERROR;
+				}
+				if(r == 0 || s->ack[0] != SIG_GA) return NB_ERROR;
+				probe_establish_done(s->fd, s->role, 0);
+				s->nin++;
+				s->got = 0;
+				s->stage = s->ps.need == 0 ? NS_STEP : NS_RECV;
+				break;
+
+			case NS_STEP:
+				return NB_STEP;
+
+			default:
+				return NB_DONE;
+			}
+		}
+	}
+
+	int phase(struct sess *s){
+		if(s->stage == NS_ID || s->stage == NS_GA || s->ctx == NULL) return NP_ID;
+		return s->moves == 0 ? NP_COMMIT : NP_RESPONSE;
+	}
+
+	int busy(struct sess *s){
+		return s->role == NS_PROVER && s->stage == NS_GA && s->ack[0] == SIG_BUSY;
+	}
+
+	void step(struct sess *s){
+		int rc;
+		s->ps.in = s->ibuf;
+		s->ps.ilen = s->got;
+		probe_crypt_start(s->a, s->fd, s->role);
+		rc = s->role == NS_PROVER ?
+			iftable[s->a]->prvstep(s->ctx, &s->ps) :
+			iftable[s->a]->vrfstep(s->ctx, &s->ps);
+		probe_crypt_done(s->a, s->fd, s->role);
+		if( rc == PS_DONE ){
+			s->last = 1;
+			s->rc = s->ps.rc;
+			probe_session_done(s->a, s->fd, s->role, s->rc);
+		}
+		s->obuf = s->ps.out;
+		s->olen = s->ps.olen;
+		s->sent = 0;
+		s->stage = NS_SEND;
+	}
+
+	void destroy(struct sess *s){
+		if(s == NULL) return;
+		if(s->ctx != NULL){
+			if(s->role == NS_PROVER) iftable[s->a]->prvfree(s->ctx);
+			else iftable[s->a]->vrffree(s->ctx);
+		}
+		free(s->mbuffer);
+		sodium_memzero(s, sizeof(struct sess));
+		free(s);
+	}
+}
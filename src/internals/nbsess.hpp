@@ -0,0 +1,118 @@
+/*
+ * internals/nbsess.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Non-blocking protocol session, drives the sans-io step functions
+ * of a scheme over a non-blocking socket
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _NBSESS_HPP_
+#define _NBSESS_HPP_
+
+#include "internal.hpp"
+#include <stddef.h>
+
+// SESSION ROLES
+#define NS_VERIFIER 0
+#define NS_PROVER 1
+
+// SESSION STAGES
+#define NS_ID 0		//awaiting the ID string
+#define NS_GA 5		//awaiting the go-ahead byte (prover)
+#define NS_SEND 1	//flushing a move
+#define NS_RECV 2	//collecting a move
+#define NS_STEP 3	//move collected, step function pending
+#define NS_DONE 4
+
+// PROTOCOL PHASES (for deadlines)
+#define NP_ID 0		//until the ID is in
+#define NP_COMMIT 1	//until the first protocol move is in
+#define NP_RESPONSE 2	//until the session completes
+
+// PUMP RESULTS
+#define NB_ERROR -1
+#define NB_WANTRD 0	//wait for the socket to be readable
+#define NB_WANTWR 1	//wait for the socket to be writable
+#define NB_STEP 2	//call step (ps.heavy hints scalar multiplication)
+#define NB_DONE 3
+
+namespace nbsess{
+
+	struct sess{
+		unsigned int a;
+		int fd;
+		int role;
+		int stage;
+		void *par;	//parsed public key or usk (not owned)
+		void *ctx;	//scheme step context
+		struct pstep ps;
+		const unsigned char *obuf;
+		size_t olen, sent;
+		unsigned char ibuf[TS_MAXSZ];
+		size_t got;
+		int moves;	//protocol moves received
+		size_t nin, nout;	//bytes received and sent
+		unsigned char ack[1];
+		unsigned char *mbuffer;	//ID string of the prover (copied)
+		size_t mlen;
+		int last;	//final move is being flushed
+		int shed;	//answer the ID with SIG_BUSY and stop (verifier)
+		int rc;		//protocol result (0 on valid)
+	};
+
+	//create a verifier session on a non-blocking socket
+	//return NULL on fail
+	struct sess *verifier(unsigned int a, int fd, void *par);
+
+	//create a prover session on a connected non-blocking socket
+	//return NULL on fail
+	struct sess *prover(
+		unsigned int a, int fd, void *usk,
+		const unsigned char *mbuffer, size_t mlen
+	);
+
+	//perform socket I/O until the session blocks, needs a step or finishes
+	//returns one of the NB_* codes
+	int pump(struct sess *s);
+
+	//current protocol phase, one of NP_*
+	int phase(struct sess *s);
+
+	//the verifier turned the prover away with SIG_BUSY (after NB_ERROR)
+	int busy(struct sess *s);
+
+	//run the pending step function (may be called from any thread)
+	void step(struct sess *s);
+
+	//release the session (does not close the socket)
+	void destroy(struct sess *s);
+}
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ * internals/nonce.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Signature nonces
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "nonce.hpp"
+#include "cmacro.h"
+#include "rng.hpp"
+
+#include <sodium.h>
+#include <atomic>
+#include <cstring>
+
+//domain separation of the derivation, hashed ahead of the index and ID
+static const unsigned char nctag[] = "id2 deterministic nonce v1";
+
+static std::atomic<int> gmode(A25519_NONCE_RANDOM);
+
+namespace nonce{
+
+	void init(struct stream *s, size_t n, const unsigned char *const *sec, size_t nsec){
+		unsigned char key[NC_MAXSEC * RS_SCSZ];
+		unsigned char idx;
+		size_t i, ks = nsec < NC_MAXSEC ? nsec : NC_MAXSEC;
+
+		s->n = n < NC_MAXN ? n : NC_MAXN;
+		s->det = gmode.load(std::memory_order_relaxed) == A25519_NONCE_DETERMINISTIC;
+		if(!s->det) return;
+
+		//r_i = HMAC-SHA512(secret scalars, tag || i || ID) mod l, reduced
+		//from 512 bits so the bias is negligible
+		for(i = 0; i < ks; i++) memcpy(key + i*RS_SCSZ, sec[i], RS_SCSZ);
+		for(i = 0; i < s->n; i++){
+			idx = (unsigned char)i;
+			crypto_auth_hmacsha512_init(&s->st[i], key, ks * RS_SCSZ);
+			crypto_auth_hmacsha512_update(&s->st[i], nctag, sizeof(nctag) - 1);
+			crypto_auth_hmacsha512_update(&s->st[i], &idx, 1);
+		}
+		sodium_memzero(key, sizeof(key));
+	}
+
+	void update(struct stream *s, const unsigned char *mbuffer, size_t mlen){
+		size_t i;
+		if(!s->det) return;
+		for(i = 0; i < s->n; i++) crypto_auth_hmacsha512_update(&s->st[i], mbuffer, mlen);
+	}
+
+	void final(struct stream *s, unsigned char *out){
+		unsigned char h[crypto_auth_hmacsha512_BYTES];
+		size_t i;
+
+		if(!s->det){
+			for(i = 0; i < s->n; i++) rng::scalar(out + i*RS_SCSZ);
+			return;
+		}
+		for(i = 0; i < s->n; i++){
+			crypto_auth_hmacsha512_final(&s->st[i], h);
+			crypto_core_ristretto255_scalar_reduce(out + i*RS_SCSZ, h);
+		}
+		sodium_memzero(h, sizeof(h));
+		sodium_memzero(s, sizeof(*s));
+	}
+
+	void draw(
+		unsigned char *out, size_t n,
+		const unsigned char *const *sec, size_t nsec,
+		const unsigned char *mbuffer, size_t mlen
+	){
+		struct stream s;
+		init(&s, n, sec, nsec);
+		update(&s, mbuffer, mlen);
+		final(&s, out);
+	}
+
+	int mode(int m){
+		if(m < 0) return gmode.load(std::memory_order_relaxed);
+		return gmode.exchange(m, std::memory_order_relaxed);
+	}
+
+}
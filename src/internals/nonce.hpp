@@ -0,0 +1,78 @@
+/*
+ * internals/nonce.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Signature nonces, random (the default) or derived from the secret key
+ * and the ID being signed, after RFC 6979: the same key and ID always
+ * give the same nonce and so the same signature, distinct IDs unrelated
+ * nonces. only for signatgen, the interactive protocols must always
+ * commit to fresh randomness
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _NONCE_HPP_
+#define _NONCE_HPP_
+
+#include "../a25519.h"
+#include <sodium.h>
+#include <stddef.h>
+
+#define NC_MAXSEC 2	//most secret scalars a key has
+#define NC_MAXN 2	//most nonces a signature takes
+
+namespace nonce{
+
+	//nonces for an ID given piece by piece, in the mode in effect at init
+	struct stream{
+		crypto_auth_hmacsha512_state st[NC_MAXN];	//one per nonce
+		size_t n;
+		int det;
+	};
+
+	void init(struct stream *s, size_t n, const unsigned char *const *sec, size_t nsec);
+	void update(struct stream *s, const unsigned char *mbuffer, size_t mlen);
+
+	//the n nonce scalars into out, s is wiped
+	void final(struct stream *s, unsigned char *out);
+
+	//n nonce scalars for signing mbuffer with the nsec secret scalars in
+	//sec, according to the mode in effect, as init, update and final
+	void draw(
+		unsigned char *out, size_t n,
+		const unsigned char *const *sec, size_t nsec,
+		const unsigned char *mbuffer, size_t mlen
+	);
+
+	//set the mode (A25519_NONCE_*), a negative mode only reads it.
+	//return the mode before
+	int mode(int m);
+
+}
+
+#endif
@@ -0,0 +1,231 @@
+/*
+ * internals/optrace.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Operation tracing
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "optrace.hpp"
+#include "ifcall.hpp"
+#include "../utils/mclock.h"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#define OT_RING 4096	//events per thread, a power of 2
+#define OT_ALGOS 10
+
+//the table fields in declaration order, numbered A25519_OP_*
+#define OT_OPS(X) \
+	X(randkeygen) X(signatgen) X(signatchk) \
+	X(secserial) X(pubserial) X(sigserial) \
+	X(secstruct) X(pubstruct) X(sigstruct) \
+	X(secdestroy) X(pubdestroy) X(sigdestroy) \
+	X(secprint) X(pubprint) X(sigprint) \
+	X(signatprv) X(signatvrf) X(prototest) \
+	X(vrfinit) X(vrfstep) X(vrffree) \
+	X(prvinit) X(prvstep) X(prvfree) \
+	X(signatgenv) X(signatchkv) \
+	X(pubview) X(sigview) \
+	X(signatini) X(signatfin) X(signatchkp)
+
+#define OT_ENUM(f) OT_##f,
+enum { OT_OPS(OT_ENUM) OT_COUNT };
+#define OT_NAME(f) #f,
+static const char *otname[OT_COUNT] = { OT_OPS(OT_NAME) };
+
+static_assert( OT_COUNT == A25519_OP_COUNT, "operation numbering" );
+static_assert( OT_signatchkv == A25519_OP_SIGNATCHKV, "operation numbering" );
+static_assert( OT_sigview == A25519_OP_SIGVIEW, "operation numbering" );
+static_assert( OT_signatchkp == A25519_OP_SIGNATCHKP, "operation numbering" );
+
+typedef std::atomic<uint64_t> tword;
+
+//a thread's ring, one writer; a reader keeps its own cursor and checks
+//after copying an event that the writer has not lapped it meanwhile
+struct ring{
+	tword head;		//events written
+	tword wip;		//events written or being written
+	uint64_t tail;		//reader side, under gmtx
+	tword t0[OT_RING], dur[OT_RING], tag[OT_RING];
+	unsigned int id;
+	std::atomic<int> owned;
+	struct ring *next;
+};
+
+static std::mutex gmtx;
+static struct ring *ghead = NULL;
+static unsigned int gnext = 0;
+
+//tables as they were before tracing, and their shadows
+static const struct ialgostr *base[OT_ALGOS];
+static struct ialgostr shadow[OT_ALGOS];
+static int filled[OT_ALGOS];
+static int gon = 0;
+
+namespace optrace{
+
+	struct holder{
+		struct ring *r;
+		~holder(){ if(r != NULL) r->owned.store(0, std::memory_order_release); }
+	};
+	static thread_local struct holder tl = { NULL };
+
+	static struct ring *adopt(void){
+		struct ring *r;
+		std::lock_guard<std::mutex> lk(gmtx);
+		for(r = ghead; r != NULL; r = r->next){
+			if(r->owned.load(std::memory_order_acquire) == 0){
+				r->owned.store(1, std::memory_order_relaxed);
+				return r;
+			}
+		}
+		r = new (std::nothrow) struct ring();
+		if(r == NULL) return NULL;
+		r->owned.store(1, std::memory_order_relaxed);
+		r->id = gnext++;
+		r->next = ghead;
+		ghead = r;
+		return r;
+	}
+
+	static void log(unsigned int a, unsigned int op, uint64_t t0, uint64_t t1){
+		struct ring *r = tl.r;
+		uint64_t h, i;
+		if(r == NULL && (r = tl.r = adopt()) == NULL) return;
+		h = r->head.load(std::memory_order_relaxed);
+		i = h & (OT_RING - 1);
+		//claim the slot first, a reader copying it meanwhile will know
+		r->wip.store(h + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		r->t0[i].store(t0, std::memory_order_relaxed);
+		r->dur[i].store(t1 - t0, std::memory_order_relaxed);
+		r->tag[i].store(a | (op << 8), std::memory_order_relaxed);
+		r->head.store(h + 1, std::memory_order_release);
+	}
+
+	//times a call, also where the call returns void
+	struct span{
+		unsigned int a, op;
+		uint64_t t0;
+		span(unsigned int a, unsigned int op) : a(a), op(op), t0(mclock_ns()) {}
+		~span(){ log(a, op, t0, mclock_ns()); }
+	};
+
+	template<unsigned int A, typename F, F ialgostr::*M, unsigned int OP> struct shim;
+
+	template<unsigned int A, typename R, typename... T, R (*ialgostr::*M)(T...), unsigned int OP>
+	struct shim<A, R (*)(T...), M, OP>{
+		static R call(T... args){
+			struct span s(A, OP);
+			return (base[A]->*M)(args...);
+		}
+	};
+
+	//entries the real table leaves NULL stay NULL, callers test for them
+	template<unsigned int A> static void fill(struct ialgostr *s, const struct ialgostr *b){
+#define OT_FILL(f) s->f = b->f == NULL ? NULL : \
+		&shim<A, decltype(ialgostr::f), &ialgostr::f, OT_##f>::call;
+		OT_OPS(OT_FILL)
+#undef OT_FILL
+	}
+
+	static void (*const fillers[OT_ALGOS])(struct ialgostr *, const struct ialgostr *) = {
+		fill<0>, fill<1>, fill<2>, fill<3>, fill<4>,
+		fill<5>, fill<6>, fill<7>, fill<8>, fill<9>,
+	};
+
+	int enable(int on){
+		int a, was;
+		std::lock_guard<std::mutex> lk(gmtx);
+		was = gon;
+		on = on != 0;
+		if(on == was) return was;
+		for(a = 0; a < OT_ALGOS; a++){
+			if(on){
+				if(iftable[a] == NULL) continue;
+				//a shadow is built once, calls in flight may still be using it
+				if(!filled[a]){
+					base[a] = iftable[a];
+					fillers[a](&shadow[a], base[a]);
+					filled[a] = 1;
+				}
+				__atomic_store_n(&iftable[a], &shadow[a], __ATOMIC_RELEASE);
+			}else if(filled[a]){
+				__atomic_store_n(&iftable[a], base[a], __ATOMIC_RELEASE);
+			}
+		}
+		gon = on;
+		return was;
+	}
+
+	size_t drain(struct a25519_opevent *out, size_t max){
+		struct ring *r;
+		struct a25519_opevent *e;
+		uint64_t h, i, tag;
+		size_t n = 0;
+		unsigned int lost;
+
+		std::lock_guard<std::mutex> lk(gmtx);
+		for(r = ghead; r != NULL && n < max; r = r->next){
+			h = r->head.load(std::memory_order_acquire);
+			lost = 0;
+			//the oldest events were overwritten
+			if(h - r->tail > OT_RING){
+				lost = (unsigned int)(h - OT_RING - r->tail);
+				r->tail = h - OT_RING;
+			}
+			for(; r->tail < h && n < max; r->tail++){
+				i = r->tail & (OT_RING - 1);
+				e = &out[n];
+				e->start_ns = r->t0[i].load(std::memory_order_relaxed);
+				e->dur_ns = r->dur[i].load(std::memory_order_relaxed);
+				tag = r->tag[i].load(std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_acquire);
+				//lapped while copying, this and everything before it is gone
+				if(r->wip.load(std::memory_order_relaxed) - r->tail > OT_RING){
+					lost++;
+					continue;
+				}
+				e->algo = (unsigned char)(tag & 0xff);
+				e->op = (unsigned char)(tag >> 8);
+				e->ring = r->id;
+				e->lost = lost;
+				lost = 0;
+				n++;
+			}
+		}
+		return n;
+	}
+
+	const char *opname(unsigned int op){
+		return op < OT_COUNT ? otname[op] : NULL;
+	}
+}
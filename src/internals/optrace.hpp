@@ -0,0 +1,57 @@
+/*
+ * internals/optrace.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Operation tracing, a shadow of the scheme function table whose entries
+ * time the call into the real table and log it to a per-thread ring.
+ * Enabling swaps iftable[a] to the shadow, disabling swaps it back, so
+ * an untraced call is exactly the indirect call it always was
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _OPTRACE_HPP_
+#define _OPTRACE_HPP_
+
+#include "../a25519.h"
+#include <stddef.h>
+
+namespace optrace{
+
+	//trace every scheme (on != 0) or none, return the previous state
+	int enable(int on);
+
+	//move logged events into out (up to max), oldest first per thread,
+	//return the number of events written
+	size_t drain(struct a25519_opevent *out, size_t max);
+
+	//name of an A25519_OP_* operation, NULL if out of range
+	const char *opname(unsigned int op);
+}
+
+#endif
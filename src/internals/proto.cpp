@@ -36,6 +36,7 @@
 //mini socket library
 #include "../utils/debug.h"
 #include "../utils/simplesock.h"
+#include "../utils/usdt.h"
 
 #include <cstdlib>
 #include <sys/socket.h>
@@ -47,12 +48,23 @@ namespace client{
 	int establish(int sock, unsigned char *mbuffer, size_t mlen){
 		if(sock == -1){return -1;}
 		unsigned char buf[1];
+		probe_establish_start(sock, USDT_PROVER);
 		//TODO: implement a check here on the number of bytes sent
 		sendbuf(sock, (char *)mbuffer , mlen);
 		//await byte 0x5a before proceeding with protocol
-		if( fixed_recvbuf(sock, (char *)buf, 1) < 0 || buf[0] != SIG_GA){
+		if( fixed_recvbuf(sock, (char *)buf, 1) < 0 ){
+			probe_establish_done(sock, USDT_PROVER, 2);
 			return 2;
 		}
+		if( buf[0] == SIG_BUSY ){
+			probe_establish_done(sock, USDT_PROVER, 3);
+			return 3;
+		}
+		if( buf[0] != SIG_GA ){
+			probe_establish_done(sock, USDT_PROVER, 2);
+			return 2;
+		}
+		probe_establish_done(sock, USDT_PROVER, 0);
 		return 0;
 	}
 }
@@ -64,17 +76,23 @@ namespace server{
 		int rc;
 		unsigned char buf[TS_MAXSZ] = {0};
 		unsigned char ackp[1] = { SIG_GA };
+		probe_establish_start(sock, USDT_VERIFIER);
 		//receive ID
 		rc = recvbuf(sock, (char *)buf, TS_MAXSZ);
 		//if received nothing or zero len string, exit
-		if( rc <= 0 ){return 1;}
+		if( rc <= 0 ){
+			probe_establish_done(sock, USDT_VERIFIER, 1);
+			return 1;
+		}
 		*mlen = (size_t)rc;
 		*mbuffer = (unsigned char *)malloc(*mlen);
 		memcpy( *mbuffer, buf, *mlen );
 		//send a go-ahead
 		if( send(sock, ackp, 1, 0) < 0){
+			probe_establish_done(sock, USDT_VERIFIER, 2);
 			return 2;
 		}
+		probe_establish_done(sock, USDT_VERIFIER, 0);
 		return 0;
 	}
 }
@@ -38,7 +38,7 @@ namespace general{
 
 namespace client{
 	//establish a protocol by sending ID over as client
-	//return 0 on succeed, abort protocol otherwise
+	//return 0 on succeed, 3 if the verifier is busy, abort protocol otherwise
 	int establish(int sock, unsigned char *mbuffer, size_t mlen);
 
 }
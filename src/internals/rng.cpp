@@ -0,0 +1,125 @@
+/*
+ * internals/rng.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Buffered per-thread random generator
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "rng.hpp"
+#include "cmacro.h"
+
+#include <sodium.h>
+#include <pthread.h>
+#include <atomic>
+#include <cstring>
+
+#define RNG_KEYSZ crypto_stream_chacha20_KEYBYTES
+
+struct rstate{
+	unsigned char key[RNG_KEYSZ];
+	unsigned char buf[RNG_KEYSZ + RNG_BUFSZ];	//next key, then output
+	size_t pos;					//next unused byte of buf
+	uint64_t nonce;					//refills under this key
+	uint64_t out;					//bytes handed out since the seed
+	unsigned long forks;				//fork count at the seed
+	int seeded;
+	~rstate(){ sodium_memzero(this, sizeof(*this)); }
+};
+
+static std::atomic<int> gmode(A25519_RNG_BUFFERED);
+static std::atomic<unsigned long> gforks(0);
+
+//a child starts from its parent's state, count forks so it reseeds
+static void forked(void){
+	gforks.fetch_add(1, std::memory_order_relaxed);
+}
+
+static struct atfork{
+	atfork(){ pthread_atfork(NULL, NULL, &forked); }
+} reg;
+
+namespace rng{
+
+	static thread_local struct rstate tl;
+
+	static void seed(struct rstate *st){
+		randombytes_buf(st->key, RNG_KEYSZ);
+		st->nonce = 0;
+		st->out = 0;
+		st->forks = gforks.load(std::memory_order_relaxed);
+		st->pos = sizeof(st->buf);
+		st->seeded = 1;
+	}
+
+	static void refill(struct rstate *st){
+		unsigned char n[crypto_stream_chacha20_NONCEBYTES];
+		uint64_t c = st->nonce++;
+		size_t i;
+		for(i = 0; i < sizeof(n); i++){ n[i] = (unsigned char)c; c >>= 8; }
+		crypto_stream_chacha20(st->buf, sizeof(st->buf), n, st->key);
+		//the old key is gone, what was handed out cannot be recomputed
+		memcpy(st->key, st->buf, RNG_KEYSZ);
+		sodium_memzero(st->buf, RNG_KEYSZ);
+		st->pos = RNG_KEYSZ;
+	}
+
+	void bytes(unsigned char *out, size_t len){
+		struct rstate *st = &tl;
+		size_t c;
+
+		if(gmode.load(std::memory_order_relaxed) != A25519_RNG_BUFFERED){
+			randombytes_buf(out, len);
+			return;
+		}
+		if(!st->seeded || st->out >= RNG_RESEED ||
+			st->forks != gforks.load(std::memory_order_relaxed)) seed(st);
+		while(len > 0){
+			if(st->pos == sizeof(st->buf)) refill(st);
+			c = sizeof(st->buf) - st->pos < len ? sizeof(st->buf) - st->pos : len;
+			memcpy(out, st->buf + st->pos, c);
+			//used output does not stay behind in the buffer
+			sodium_memzero(st->buf + st->pos, c);
+			st->pos += c; st->out += c;
+			out += c; len -= c;
+		}
+	}
+
+	void scalar(unsigned char *out){
+		unsigned char h[RS_HSSZ];
+		//reduced from 512 bits, uniform but for a negligible bias
+		bytes(h, sizeof(h));
+		crypto_core_ristretto255_scalar_reduce(out, h);
+		sodium_memzero(h, sizeof(h));
+	}
+
+	int mode(int m){
+		if(m < 0) return gmode.load(std::memory_order_relaxed);
+		return gmode.exchange(m, std::memory_order_relaxed);
+	}
+
+}
@@ -0,0 +1,65 @@
+/*
+ * internals/rng.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Random generator for the hot paths: signature nonces, prover
+ * commitments and verifier challenges. each thread keeps a ChaCha20
+ * keystream seeded from the system generator (libsodium) and hands it
+ * out from a buffer, many scalars per refill. every refill replaces the
+ * key with the first block of its own output (fast key erasure), the
+ * stream is reseeded after RNG_RESEED bytes, and in a forked child before
+ * its first use, so parent and child never share output.
+ * long-term keys (randomkey) still come straight from the system
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _RNG_HPP_
+#define _RNG_HPP_
+
+#include "../a25519.h"
+#include <stddef.h>
+
+#define RNG_BUFSZ 2048			//output per refill
+#define RNG_RESEED (1ULL << 24)		//output per seed
+
+namespace rng{
+
+	//len random bytes
+	void bytes(unsigned char *out, size_t len);
+
+	//a uniformly random scalar, as crypto_core_ristretto255_scalar_random
+	void scalar(unsigned char *out);
+
+	//set the mode (A25519_RNG_*), a negative mode only reads it.
+	//return the mode before
+	int mode(int m);
+
+}
+
+#endif
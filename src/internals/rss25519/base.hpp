@@ -49,7 +49,20 @@ namespace rss25519{
 		&sigprint,
 		&signatprv,
 		&signatvrf,
-		&prototest
+		&prototest,
+		&vrfinit,
+		&vrfstep,
+		&vrffree,
+		&prvinit,
+		&prvstep,
+		&prvfree,
+		&signatgenv,
+		NULL,
+		&pubview,
+		&sigview,
+		&signatini,
+		&signatfin,
+		&signatchkp
 	};
 }
 
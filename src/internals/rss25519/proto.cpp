@@ -38,11 +38,14 @@
 // include general prototype and macro
 #include "../proto.hpp"
 #include "../cmacro.h"
+#include "../rng.hpp"
+#include "../ifcall.hpp"
 
 //mini socket library
 #include "../../utils/bufhelp.h"
 #include "../../utils/debug.h"
 #include "../../utils/simplesock.h"
+#include "../../utils/usdt.h"
 
 // implementation includes (archlinux os stored under /usr/include/sodium)
 //Nacl Finite Field Arithmetic on top of Curve25519
@@ -67,7 +70,7 @@ namespace rss25519{
 
 		//--------------------------TODO START
 		unsigned char t[2*RS_SCSZ], c[RS_SCSZ], y[RS_SCSZ];
-		unsigned char *xp;
+		unsigned char xp[RS_SCSZ];
 		unsigned char tmp1[RS_EPSZ], tmp2[RS_EPSZ], tmp[RS_SCSZ];
 		unsigned char buf[TS_MAXSZ] = {0};
 
@@ -78,23 +81,27 @@ namespace rss25519{
 			lerror("Failed to recv PRE-NONCE from prover\n");
 			return 1;
 		}
+		probe_move_recv(A25519_RESETSCHNORR, sock, USDT_PROVER, RS_EPSZ);
 
 		//COMPUTE NONCE WITH PRE-NONCE AS SEED
-		randombytes_buf(y, RS_EPSZ);
-		xp = hashexec( mbuffer, mlen, y, c);
+		rng::bytes(y, RS_EPSZ);
+		hashexec(xp, mbuffer, mlen, y, c);
 
 		//--------------------------------------------------------
 		//--------------COMPUTE AND SEND COMMIT
 		//CMT <- U', T
 		// T = tB
 		memcpy( buf, usk->U, RS_EPSZ);
+		probe_crypt_start(A25519_RESETSCHNORR, sock, USDT_PROVER);
 		rc = crypto_scalarmult_ristretto255_base( buf+RS_EPSZ, xp);
+		probe_crypt_done(A25519_RESETSCHNORR, sock, USDT_PROVER);
 		if( rc != 0 ){
 			//abort if fail
 			lerror("Failed to compute COMMIT\n");
 			return 1;
 		}
 		sendbuf( sock, (char *)buf , 2*RS_EPSZ); //send CMT
+		probe_move_send(A25519_RESETSCHNORR, sock, USDT_PROVER, 2*RS_EPSZ);
 
 		//--------------------------------------------------------
 		//--------------RECEIVE REVEAL
@@ -103,13 +110,16 @@ namespace rss25519{
 			lerror("Failed to recv REVEAL from verifier\n");
 			return 1;
 		}
+		probe_move_recv(A25519_RESETSCHNORR, sock, USDT_PROVER, 2*RS_SCSZ);
 
 		//--------------------------------------------------------
 		//--------------VERIFY REVEAL
+		probe_crypt_start(A25519_RESETSCHNORR, sock, USDT_PROVER);
 		rc = 0;
 		rc += crypto_scalarmult_ristretto255_base( tmp1, t); //fixed
 		rc += crypto_scalarmult_ristretto255( tmp2, t+RS_SCSZ, usk->P2);//rH
 		rc += crypto_core_ristretto255_add( tmp, tmp1, tmp2);
+		probe_crypt_done(A25519_RESETSCHNORR, sock, USDT_PROVER);
 		rc += crypto_verify_32(tmp, c);
 		if( rc != 0){
 			//prevent reset attacks by aborting
@@ -123,6 +133,7 @@ namespace rss25519{
 #endif
 			//send back garbage
 			sendbuf(sock, (char *)y , RS_SCSZ);
+			probe_move_send(A25519_RESETSCHNORR, sock, USDT_PROVER, RS_SCSZ);
 			return 1;
 		}
 
@@ -141,8 +152,9 @@ namespace rss25519{
 	printf("y :"); ucbprint(y, RS_SCSZ); printf("\n");
 #endif
 
-		hashfree(xp);
+		sodium_memzero(xp, RS_SCSZ);
 		sendbuf(sock, (char *)y , RS_SCSZ);
+		probe_move_send(A25519_RESETSCHNORR, sock, USDT_PROVER, RS_SCSZ);
 
 		buf[0] = 0x01;
 		rc = fixed_recvbuf(sock, (char *)buf, 1); //receive final result
@@ -150,6 +162,7 @@ namespace rss25519{
 			lerror("Failed to recv RESULT from verifier\n");
 			return 1;
 		}
+		probe_move_recv(A25519_RESETSCHNORR, sock, USDT_PROVER, 1);
 		debug("Received: %02X\n",buf[0]);
 		//--------------------------TODO END
 
@@ -168,20 +181,23 @@ namespace rss25519{
 
 		//--------------------------TODO START
 		unsigned char pc[2*RS_SCSZ];
-		unsigned char c[RS_SCSZ], y[RS_SCSZ], *xp;
+		unsigned char c[RS_SCSZ], y[RS_SCSZ], xp[RS_SCSZ];
 		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ];
 		unsigned char buf[TS_MAXSZ] = {0};
 
 		//--------------------------------------------------------
 		//--------------COMPUTE AND SEND PRE-NONCE
-		crypto_core_ristretto255_scalar_random(pc); //m
-		crypto_core_ristretto255_scalar_random(pc+RS_SCSZ); //r
+		rng::scalar(pc); //m
+		rng::scalar(pc+RS_SCSZ); //r
+		probe_crypt_start(A25519_RESETSCHNORR, sock, USDT_VERIFIER);
 		rc = 0;
 		rc += crypto_scalarmult_ristretto255_base( LHS, pc);//mB
 		rc += crypto_scalarmult_ristretto255( RHS, pc+RS_SCSZ, par->P2 );//rH
 		rc += crypto_core_ristretto255_add( c, LHS, RHS ); //compute pre-nonce
+		probe_crypt_done(A25519_RESETSCHNORR, sock, USDT_VERIFIER);
 		if( rc != 0 ) return rc; //abort if fail
 		sendbuf(sock, (char *)c , RS_SCSZ);
+		probe_move_send(A25519_RESETSCHNORR, sock, USDT_VERIFIER, RS_SCSZ);
 
 		//--------------------------------------------------------
 		//--------------RECEIVE COMMIT FROM PROVER
@@ -191,10 +207,12 @@ namespace rss25519{
 			lerror("Failed to recv COMMIT from prover\n");
 			return 1;
 		}
+		probe_move_recv(A25519_RESETSCHNORR, sock, USDT_VERIFIER, 2*RS_EPSZ);
 
 		//--------------------------------------------------------
 		//---------------------REVEAL THE PRE-NONCE
 		sendbuf(sock, (char *)pc , 2*RS_SCSZ);
+		probe_move_send(A25519_RESETSCHNORR, sock, USDT_VERIFIER, 2*RS_SCSZ);
 		memset(y, 0, RS_SCSZ);
 
 		//--------------------------------------------------------
@@ -204,9 +222,11 @@ namespace rss25519{
 			lerror("Failed to recv RESPONSE from prover\n");
 			return 1;
 		}
+		probe_move_recv(A25519_RESETSCHNORR, sock, USDT_VERIFIER, RS_SCSZ);
 
+		probe_crypt_start(A25519_RESETSCHNORR, sock, USDT_VERIFIER);
 		//hash
-		xp = hashexec(mbuffer, mlen, buf, par->P1);
+		hashexec(xp, mbuffer, mlen, buf, par->P1);
 
 #ifdef DEBUG
 	pubprint(par);
@@ -222,13 +242,14 @@ namespace rss25519{
 		// yB = T + c( U' - xP1 )
 		rc = 0;
 		rc += crypto_scalarmult_ristretto255( RHS, xp, par->P1); // xP1
-		//zero and free
-		hashfree(xp);
+		//zero
+		sodium_memzero(xp, RS_SCSZ);
 		rc += crypto_scalarmult_ristretto255_base( LHS, y); // yB
 		rc += crypto_core_ristretto255_sub( RHS, buf, RHS); // U' - xP1
 		rc += crypto_scalarmult_ristretto255( RHS, c, RHS); // c( U' - xP1 )
 		// T + c(U' - xP1)
 		rc += crypto_core_ristretto255_add( RHS, RHS, buf+RS_EPSZ);
+		probe_crypt_done(A25519_RESETSCHNORR, sock, USDT_VERIFIER);
 		if( rc != 0 ) return rc; //abort if fail
 
 		//check if tmp is equal to x from obuffer
@@ -239,6 +260,7 @@ namespace rss25519{
 			buf[0] = 0x01;
 		}
 		sendbuf(sock, (char *)buf , 1); //send back the results
+		probe_move_send(A25519_RESETSCHNORR, sock, USDT_VERIFIER, 1);
 		debug("Replied: %02X\n",buf[0]);
 		//--------------------------TODO END
 
@@ -259,12 +281,13 @@ namespace rss25519{
 		int rc;
 
 		//------------------------------------TODO START
-		unsigned char t[2*RS_SCSZ], c[RS_SCSZ], y[RS_SCSZ], *xp;
+		unsigned char t[2*RS_SCSZ], c[RS_SCSZ], y[RS_SCSZ], xp[RS_SCSZ];
 		unsigned char tmp[RS_EPSZ], LHS[RS_EPSZ], RHS[RS_EPSZ];
+		crypto_hash_sha512_state pre;
 
 		//sample the pre-nonces
-		crypto_core_ristretto255_scalar_random(t);
-		crypto_core_ristretto255_scalar_random(t+RS_SCSZ);
+		rng::scalar(t);
+		rng::scalar(t+RS_SCSZ);
 
 		//compute challenge from pre-nonce
 		rc = 0;
@@ -273,22 +296,23 @@ namespace rss25519{
 		rc += crypto_core_ristretto255_add( c, LHS, RHS ); //compute pre-nonce
 
 		//compute nonce from challenge
-		randombytes_buf(y, RS_EPSZ);
-		xp = hashexec( mbuffer, mlen, y, c); //xp is the nonce
+		rng::bytes(y, RS_EPSZ);
+		hashpre(&pre, mbuffer, mlen); //the ID is hashed twice
+		hashfrom(xp, &pre, y, c); //xp is the nonce
 		rc += crypto_scalarmult_ristretto255_base( tmp, xp); //stores Y
 
 		//c == tB (t+SCSZ)P1 no need to check
 		//compute response
 		crypto_core_ristretto255_scalar_mul( y , c, usk->s ); //
 		crypto_core_ristretto255_scalar_add( y, y, xp ); // y = t + cs
-		hashfree(xp);
+		sodium_memzero(xp, RS_SCSZ);
 
-		xp = hashexec(mbuffer, mlen, usk->U, par->P1);
+		hashfrom(xp, &pre, usk->U, par->P1);
 
 		// yB = T + c( U' - xP1 )
 		rc += crypto_scalarmult_ristretto255( RHS, xp, par->P1); // xP1
-		//zero and free
-		hashfree(xp);
+		//zero
+		sodium_memzero(xp, RS_SCSZ);
 		rc += crypto_scalarmult_ristretto255_base( LHS, y); // yB
 		rc += crypto_core_ristretto255_sub( RHS, usk->U, RHS); // U' - xP1
 		rc += crypto_scalarmult_ristretto255( RHS, c, RHS); // c( U' - xP1 )
@@ -304,4 +328,192 @@ namespace rss25519{
 		return rc;
 	}
 
+
+	//verifier session state for the sans-io core
+	struct vrfctx{
+		int stage;
+		struct pubkey *par;
+		const unsigned char *mbuffer; size_t mlen;
+		unsigned char pc[2*RS_SCSZ];
+		unsigned char c[RS_SCSZ];
+		unsigned char cmt[2*RS_EPSZ];
+	};
+
+	int vrfinit(
+		void *vpar,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	){
+		struct vrfctx *tmp = (struct vrfctx *)malloc(sizeof(struct vrfctx));
+		tmp->stage = 0;
+		tmp->par = (struct pubkey *)vpar;
+		tmp->mbuffer = mbuffer;
+		tmp->mlen = mlen;
+
+		//verifier moves first with the PRE-NONCE
+		ps->need = 0;
+		ps->heavy = 1;
+		*out = (void *)tmp; return 0;
+	}
+
+	int vrfstep(void *vctx, struct pstep *ps){
+		struct vrfctx *ctx = (struct vrfctx *)vctx;
+		unsigned char xp[RS_SCSZ];
+		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ];
+		int rc = 0;
+
+		switch(ctx->stage++){
+		case 0:
+			//--------------------------------------------------------
+			//--------------COMPUTE AND SEND PRE-NONCE
+			rng::scalar(ctx->pc); //m
+			rng::scalar(ctx->pc+RS_SCSZ); //r
+			rc += crypto_scalarmult_ristretto255_base( LHS, ctx->pc);//mB
+			rc += crypto_scalarmult_ristretto255( RHS, ctx->pc+RS_SCSZ, ctx->par->P2 );//rH
+			rc += crypto_core_ristretto255_add( ctx->c, LHS, RHS ); //compute pre-nonce
+			if( rc != 0 ) break; //abort if fail
+			memcpy( ps->out, ctx->c, RS_SCSZ);
+			ps->olen = RS_SCSZ;
+			ps->need = 2*RS_EPSZ;
+			ps->heavy = 0;
+			return PS_CONT;
+		case 1:
+			//--------------------------------------------------------
+			//--------------RECEIVE COMMIT, REVEAL THE PRE-NONCE
+			//CMT <- U, T
+			memcpy( ctx->cmt, ps->in, 2*RS_EPSZ);
+			memcpy( ps->out, ctx->pc, 2*RS_SCSZ);
+			ps->olen = 2*RS_SCSZ;
+			ps->need = RS_SCSZ;
+			ps->heavy = 1;
+			return PS_CONT;
+		default:
+			//--------------------------------------------------------
+			//--------------RECEIVE RESPONSE, SEND THE RESULT
+			hashexec(xp, ctx->mbuffer, ctx->mlen, ctx->cmt, ctx->par->P1);
+
+			// yB = T + c( U' - xP1 )
+			rc += crypto_scalarmult_ristretto255( RHS, xp, ctx->par->P1); // xP1
+			sodium_memzero(xp, RS_SCSZ);
+			rc += crypto_scalarmult_ristretto255_base( LHS, ps->in); // yB
+			rc += crypto_core_ristretto255_sub( RHS, ctx->cmt, RHS); // U' - xP1
+			rc += crypto_scalarmult_ristretto255( RHS, ctx->c, RHS); // c( U' - xP1 )
+			// T + c(U' - xP1)
+			rc += crypto_core_ristretto255_add( RHS, RHS, ctx->cmt+RS_EPSZ);
+			rc += crypto_verify_32( LHS, RHS );
+			break;
+		}
+
+		ps->out[0] = rc == 0 ? 0x00 : 0x01;
+		ps->olen = 1;
+		ps->need = 0;
+		ps->heavy = 0;
+		ps->rc = rc;
+		debug("Replied: %02X\n",ps->out[0]);
+		return PS_DONE;
+	}
+
+	void vrffree(void *vctx){
+		sodium_memzero(vctx, sizeof(struct vrfctx));
+		free(vctx); return;
+	}
+
+	//prover session state for the sans-io core
+	struct prvctx{
+		int stage;
+		struct signat *usk;
+		const unsigned char *mbuffer; size_t mlen;
+		unsigned char c[RS_EPSZ];
+		unsigned char y[RS_SCSZ];
+		unsigned char xp[RS_SCSZ];
+	};
+
+	int prvinit(
+		void *vusk,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	){
+		struct prvctx *tmp = (struct prvctx *)malloc(sizeof(struct prvctx));
+		tmp->stage = 0;
+		tmp->usk = (struct signat *)vusk;
+		tmp->mbuffer = mbuffer;
+		tmp->mlen = mlen;
+
+		//verifier moves first with the PRE-NONCE
+		ps->need = RS_EPSZ;
+		ps->heavy = 1;
+		*out = (void *)tmp; return 0;
+	}
+
+	int prvstep(void *vctx, struct pstep *ps){
+		struct prvctx *ctx = (struct prvctx *)vctx;
+		unsigned char tmp1[RS_EPSZ], tmp2[RS_EPSZ], tmp[RS_SCSZ];
+		int rc = 0;
+
+		switch(ctx->stage++){
+		case 0:
+			//--------------------------------------------------------
+			//--------------RECEIVE PRE-NONCE, COMPUTE AND SEND COMMIT
+			memcpy( ctx->c, ps->in, RS_EPSZ);
+			//COMPUTE NONCE WITH PRE-NONCE AS SEED
+			rng::bytes(ctx->y, RS_EPSZ);
+			hashexec(ctx->xp, ctx->mbuffer, ctx->mlen, ctx->y, ctx->c);
+
+			//CMT <- U', T
+			// T = tB
+			memcpy( ps->out, ctx->usk->U, RS_EPSZ);
+			rc = crypto_scalarmult_ristretto255_base( ps->out+RS_EPSZ, ctx->xp);
+			if( rc != 0 ){
+				lerror("Failed to compute COMMIT\n");
+				ps->olen = 0; ps->rc = 1;
+				return PS_DONE;
+			}
+			ps->olen = 2*RS_EPSZ;
+			ps->need = 2*RS_SCSZ;
+			ps->heavy = 1;
+			return PS_CONT;
+		case 1:
+			//--------------------------------------------------------
+			//--------------RECEIVE AND VERIFY REVEAL
+			rc += crypto_scalarmult_ristretto255_base( tmp1, ps->in); //fixed
+			rc += crypto_scalarmult_ristretto255( tmp2, ps->in+RS_SCSZ, ctx->usk->P2);//rH
+			rc += crypto_core_ristretto255_add( tmp, tmp1, tmp2);
+			rc += crypto_verify_32(tmp, ctx->c);
+			if( rc != 0){
+				//prevent reset attacks by aborting
+				lerror("Invalid REVEAL, aborting\n");
+				//send back garbage
+				memcpy( ps->out, ctx->y, RS_SCSZ);
+				ps->olen = RS_SCSZ;
+				ps->need = 0;
+				ps->rc = 1;
+				return PS_DONE;
+			}
+
+			//--------------COMPUTE AND SEND RESPONSE
+			// y = t + cs
+			crypto_core_ristretto255_scalar_mul( ps->out, ctx->c, ctx->usk->s );
+			crypto_core_ristretto255_scalar_add( ps->out, ps->out, ctx->xp );
+			sodium_memzero(ctx->xp, RS_SCSZ);
+			ps->olen = RS_SCSZ;
+			ps->need = 1;
+			ps->heavy = 0;
+			return PS_CONT;
+		default:
+			//--------------------------------------------------------
+			//--------------RECEIVE RESULT
+			debug("Received: %02X\n",ps->in[0]);
+			ps->olen = 0;
+			ps->need = 0;
+			ps->rc = (int)ps->in[0];
+			return PS_DONE;
+		}
+	}
+
+	void prvfree(void *vctx){
+		sodium_memzero(vctx, sizeof(struct prvctx));
+		free(vctx); return;
+	}
 }
@@ -38,11 +38,14 @@
 // include general prototype and macro
 #include "../proto.hpp"
 #include "../cmacro.h"
+#include "../rng.hpp"
+#include "../ifcall.hpp"
 
 //mini socket library
 #include "../../utils/bufhelp.h"
 #include "../../utils/debug.h"
 #include "../../utils/simplesock.h"
+#include "../../utils/usdt.h"
 
 // implementation includes (archlinux os stored under /usr/include/sodium)
 //Nacl Finite Field Arithmetic on top of Curve25519
@@ -67,9 +70,10 @@ namespace rtw25519{
 
 		//--------------------------TODO START
 		unsigned char t[2*RS_SCSZ], c[RS_SCSZ], y[2*RS_SCSZ];
-		unsigned char *xp1, *xp2;
+		unsigned char xp1[RS_SCSZ], xp2[RS_SCSZ];
 		unsigned char tmp1[RS_EPSZ], tmp2[RS_EPSZ], tmp[RS_SCSZ];
 		unsigned char buf[TS_MAXSZ] = {0};
+		crypto_hash_sha512_state pre;
 
 		//--------------------------------------------------------
 		//--------------RECEIVE PRE-NONCE
@@ -78,6 +82,7 @@ namespace rtw25519{
 			lerror("Failed to recv PRE-NONCE from prover\n");
 			return 1;
 		}
+		probe_move_recv(A25519_RESET2SCHNORR, sock, USDT_PROVER, RS_EPSZ);
 
 
 		//--------------------------------------------------------
@@ -87,12 +92,15 @@ namespace rtw25519{
 		memcpy( buf, usk->U, RS_EPSZ);
 		rc = 0;
 
-		randombytes_buf(y, 2*RS_EPSZ);
-		xp1 = hashexec( mbuffer, mlen, y, c);
-		xp2 = hashexec( mbuffer, mlen, y+RS_SCSZ, c);
+		rng::bytes(y, 2*RS_EPSZ);
+		hashpre(&pre, mbuffer, mlen); //the ID is hashed twice
+		hashfrom(xp1, &pre, y, c);
+		hashfrom(xp2, &pre, y+RS_SCSZ, c);
+		probe_crypt_start(A25519_RESET2SCHNORR, sock, USDT_PROVER);
 		rc += crypto_scalarmult_ristretto255_base( tmp1, xp1);
 		rc += crypto_scalarmult_ristretto255( tmp2, xp2, usk->B2);
 		rc += crypto_core_ristretto255_add( buf+RS_EPSZ, tmp1, tmp2);
+		probe_crypt_done(A25519_RESET2SCHNORR, sock, USDT_PROVER);
 
 		if( rc != 0 ){
 			//abort if fail
@@ -100,6 +108,7 @@ namespace rtw25519{
 			return 1;
 		}
 		sendbuf( sock, (char *)buf , 2*RS_EPSZ); //send CMT
+		probe_move_send(A25519_RESET2SCHNORR, sock, USDT_PROVER, 2*RS_EPSZ);
 
 		//--------------------------------------------------------
 		//--------------RECEIVE REVEAL
@@ -108,13 +117,16 @@ namespace rtw25519{
 			lerror("Failed to recv REVEAL from verifier\n");
 			return 1;
 		}
+		probe_move_recv(A25519_RESET2SCHNORR, sock, USDT_PROVER, 2*RS_SCSZ);
 
 		//--------------------------------------------------------
 		//--------------VERIFY REVEAL
+		probe_crypt_start(A25519_RESET2SCHNORR, sock, USDT_PROVER);
 		rc = 0;
 		rc += crypto_scalarmult_ristretto255_base( tmp1, t); //fixed
 		rc += crypto_scalarmult_ristretto255( tmp2, t+RS_SCSZ, usk->P2);//rH
 		rc += crypto_core_ristretto255_add( tmp, tmp1, tmp2);
+		probe_crypt_done(A25519_RESET2SCHNORR, sock, USDT_PROVER);
 		rc += crypto_verify_32(tmp, c);
 		if( rc != 0){
 			//prevent reset attacks by aborting
@@ -128,6 +140,7 @@ namespace rtw25519{
 #endif
 			//send back garbage
 			sendbuf(sock, (char *)y , 2*RS_SCSZ);
+			probe_move_send(A25519_RESET2SCHNORR, sock, USDT_PROVER, 2*RS_SCSZ);
 			return 1;
 		}
 
@@ -150,9 +163,10 @@ namespace rtw25519{
 	printf("y2:"); ucbprint(y+RS_SCSZ, RS_SCSZ); printf("\n");
 #endif
 
-		hashfree(xp1);
-		hashfree(xp2);
+		sodium_memzero(xp1, RS_SCSZ);
+		sodium_memzero(xp2, RS_SCSZ);
 		sendbuf(sock, (char *)y , 2*RS_SCSZ);
+		probe_move_send(A25519_RESET2SCHNORR, sock, USDT_PROVER, 2*RS_SCSZ);
 
 		buf[0] = 0x01;
 		rc = fixed_recvbuf(sock, (char *)buf, 1); //receive final result
@@ -160,6 +174,7 @@ namespace rtw25519{
 			lerror("Failed to recv RESULT from verifier\n");
 			return 1;
 		}
+		probe_move_recv(A25519_RESET2SCHNORR, sock, USDT_PROVER, 1);
 		debug("Received: %02X\n",buf[0]);
 		//--------------------------TODO END
 
@@ -178,20 +193,23 @@ namespace rtw25519{
 
 		//--------------------------TODO START
 		unsigned char pc[2*RS_SCSZ];
-		unsigned char c[RS_SCSZ], y[2*RS_SCSZ], *xp;
+		unsigned char c[RS_SCSZ], y[2*RS_SCSZ], xp[RS_SCSZ];
 		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ];
 		unsigned char buf[TS_MAXSZ] = {0};
 
 		//--------------------------------------------------------
 		//--------------COMPUTE AND SEND PRE-NONCE
-		crypto_core_ristretto255_scalar_random(pc); //m
-		crypto_core_ristretto255_scalar_random(pc+RS_SCSZ); //r
+		rng::scalar(pc); //m
+		rng::scalar(pc+RS_SCSZ); //r
+		probe_crypt_start(A25519_RESET2SCHNORR, sock, USDT_VERIFIER);
 		rc = 0;
 		rc += crypto_scalarmult_ristretto255_base( LHS, pc);//mB
 		rc += crypto_scalarmult_ristretto255( RHS, pc+RS_SCSZ, par->P2 );//rH
 		rc += crypto_core_ristretto255_add( c, LHS, RHS ); //compute pre-nonce
+		probe_crypt_done(A25519_RESET2SCHNORR, sock, USDT_VERIFIER);
 		if( rc != 0 ) return rc; //abort if fail
 		sendbuf(sock, (char *)c , RS_SCSZ);
+		probe_move_send(A25519_RESET2SCHNORR, sock, USDT_VERIFIER, RS_SCSZ);
 
 		//--------------------------------------------------------
 		//--------------RECEIVE COMMIT FROM PROVER
@@ -201,10 +219,12 @@ namespace rtw25519{
 			lerror("Failed to recv COMMIT from prover\n");
 			return 1;
 		}
+		probe_move_recv(A25519_RESET2SCHNORR, sock, USDT_VERIFIER, 2*RS_EPSZ);
 
 		//--------------------------------------------------------
 		//---------------------REVEAL THE PRE-NONCE
 		sendbuf(sock, (char *)pc , 2*RS_SCSZ);
+		probe_move_send(A25519_RESET2SCHNORR, sock, USDT_VERIFIER, 2*RS_SCSZ);
 		memset(y, 0, RS_SCSZ);
 
 		//--------------------------------------------------------
@@ -214,9 +234,11 @@ namespace rtw25519{
 			lerror("Failed to recv RESPONSE from prover\n");
 			return 1;
 		}
+		probe_move_recv(A25519_RESET2SCHNORR, sock, USDT_VERIFIER, 2*RS_SCSZ);
 
+		probe_crypt_start(A25519_RESET2SCHNORR, sock, USDT_VERIFIER);
 		//hash
-		xp = hashexec(mbuffer, mlen, buf, par->P1);
+		hashexec(xp, mbuffer, mlen, buf, par->P1);
 
 #ifdef DEBUG
 	pubprint(par);
@@ -241,8 +263,9 @@ namespace rtw25519{
 		rc += crypto_scalarmult_ristretto255( RHS, c, RHS); // c( U' - xP1 )
 		// T + c(U' - xP1)
 		rc += crypto_core_ristretto255_add( RHS, RHS, buf+RS_EPSZ);
-		//zero and free
-		hashfree(xp);
+		probe_crypt_done(A25519_RESET2SCHNORR, sock, USDT_VERIFIER);
+		//zero
+		sodium_memzero(xp, RS_SCSZ);
 		if( rc != 0 ) return rc; //abort if fail
 
 		//check if tmp is equal to x from obuffer
@@ -253,6 +276,7 @@ namespace rtw25519{
 			buf[0] = 0x01;
 		}
 		sendbuf(sock, (char *)buf , 1); //send back the results
+		probe_move_send(A25519_RESET2SCHNORR, sock, USDT_VERIFIER, 1);
 		debug("Replied: %02X\n",buf[0]);
 		//--------------------------TODO END
 
@@ -273,12 +297,13 @@ namespace rtw25519{
 		int rc;
 
 		//------------------------------------TODO START
-		unsigned char t[2*RS_SCSZ], c[RS_SCSZ], y[2*RS_SCSZ], *xp1, *xp2;
+		unsigned char t[2*RS_SCSZ], c[RS_SCSZ], y[2*RS_SCSZ], xp1[RS_SCSZ], xp2[RS_SCSZ];
 		unsigned char tmp[RS_EPSZ], LHS[RS_EPSZ], RHS[RS_EPSZ];
+		crypto_hash_sha512_state pre;
 
 		//sample the pre-nonces
-		crypto_core_ristretto255_scalar_random(t);
-		crypto_core_ristretto255_scalar_random(t+RS_SCSZ);
+		rng::scalar(t);
+		rng::scalar(t+RS_SCSZ);
 
 		//compute challenge from pre-nonce
 		rc = 0;
@@ -287,9 +312,10 @@ namespace rtw25519{
 		rc += crypto_core_ristretto255_add( c, LHS, RHS ); //compute pre-nonce
 
 		//compute nonce from challenge
-		randombytes_buf(y, 2*RS_EPSZ);
-		xp1 = hashexec( mbuffer, mlen, y, c); //xp is the nonce
-		xp2 = hashexec( mbuffer, mlen, y+RS_SCSZ, c); //xp is the nonce
+		rng::bytes(y, 2*RS_EPSZ);
+		hashpre(&pre, mbuffer, mlen); //the ID is hashed thrice
+		hashfrom(xp1, &pre, y, c); //xp is the nonce
+		hashfrom(xp2, &pre, y+RS_SCSZ, c); //xp is the nonce
 		rc += crypto_scalarmult_ristretto255_base( LHS, xp1); //stores Y
 		rc += crypto_scalarmult_ristretto255( RHS, xp2, usk->B2); //stores Y
 		rc += crypto_core_ristretto255_add( tmp, LHS, RHS); //stores Y
@@ -300,9 +326,9 @@ namespace rtw25519{
 		crypto_core_ristretto255_scalar_add( y, y, xp1 );
 		crypto_core_ristretto255_scalar_mul( y+RS_SCSZ , c, usk->s2 );
 		crypto_core_ristretto255_scalar_add( y+RS_SCSZ, y+RS_SCSZ, xp2 );
-		hashfree(xp1);
-		hashfree(xp2);
-		xp1 = hashexec(mbuffer, mlen, usk->U, par->P1);
+		sodium_memzero(xp1, RS_SCSZ);
+		sodium_memzero(xp2, RS_SCSZ);
+		hashfrom(xp1, &pre, usk->U, par->P1);
 
 		//compute LHS
 		rc += crypto_scalarmult_ristretto255_base( LHS, y);
@@ -314,8 +340,8 @@ namespace rtw25519{
 		rc += crypto_scalarmult_ristretto255( RHS, c, RHS);
 		// T + c(U' - xP1)
 		rc += crypto_core_ristretto255_add( RHS, RHS, tmp);
-		//zero and free
-		hashfree(xp1);
+		//zero
+		sodium_memzero(xp1, RS_SCSZ);
 		if( rc != 0 ) return rc; //abort if fail
 
 		//check LHS == RHS
@@ -326,4 +352,201 @@ namespace rtw25519{
 		return rc;
 	}
 
+
+	//verifier session state for the sans-io core
+	struct vrfctx{
+		int stage;
+		struct pubkey *par;
+		const unsigned char *mbuffer; size_t mlen;
+		unsigned char pc[2*RS_SCSZ];
+		unsigned char c[RS_SCSZ];
+		unsigned char cmt[2*RS_EPSZ];
+	};
+
+	int vrfinit(
+		void *vpar,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	){
+		struct vrfctx *tmp = (struct vrfctx *)malloc(sizeof(struct vrfctx));
+		tmp->stage = 0;
+		tmp->par = (struct pubkey *)vpar;
+		tmp->mbuffer = mbuffer;
+		tmp->mlen = mlen;
+
+		//verifier moves first with the PRE-NONCE
+		ps->need = 0;
+		ps->heavy = 1;
+		*out = (void *)tmp; return 0;
+	}
+
+	int vrfstep(void *vctx, struct pstep *ps){
+		struct vrfctx *ctx = (struct vrfctx *)vctx;
+		unsigned char xp[RS_SCSZ];
+		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ];
+		int rc = 0;
+
+		switch(ctx->stage++){
+		case 0:
+			//--------------------------------------------------------
+			//--------------COMPUTE AND SEND PRE-NONCE
+			rng::scalar(ctx->pc); //m
+			rng::scalar(ctx->pc+RS_SCSZ); //r
+			rc += crypto_scalarmult_ristretto255_base( LHS, ctx->pc);//mB
+			rc += crypto_scalarmult_ristretto255( RHS, ctx->pc+RS_SCSZ, ctx->par->P2 );//rH
+			rc += crypto_core_ristretto255_add( ctx->c, LHS, RHS ); //compute pre-nonce
+			if( rc != 0 ) break; //abort if fail
+			memcpy( ps->out, ctx->c, RS_SCSZ);
+			ps->olen = RS_SCSZ;
+			ps->need = 2*RS_EPSZ;
+			ps->heavy = 0;
+			return PS_CONT;
+		case 1:
+			//--------------------------------------------------------
+			//--------------RECEIVE COMMIT, REVEAL THE PRE-NONCE
+			//CMT <- U, T
+			memcpy( ctx->cmt, ps->in, 2*RS_EPSZ);
+			memcpy( ps->out, ctx->pc, 2*RS_SCSZ);
+			ps->olen = 2*RS_SCSZ;
+			ps->need = 2*RS_SCSZ;
+			ps->heavy = 1;
+			return PS_CONT;
+		default:
+			//--------------------------------------------------------
+			//--------------RECEIVE RESPONSE, SEND THE RESULT
+			hashexec(xp, ctx->mbuffer, ctx->mlen, ctx->cmt, ctx->par->P1);
+
+			// y1B1 + y2B2 = LHS
+			rc += crypto_scalarmult_ristretto255_base( LHS, ps->in);
+			rc += crypto_scalarmult_ristretto255( RHS, ps->in+RS_SCSZ, ctx->par->B2);
+			rc += crypto_core_ristretto255_add( LHS, RHS, LHS);
+
+			rc += crypto_scalarmult_ristretto255( RHS, xp, ctx->par->P1); // xP1
+			sodium_memzero(xp, RS_SCSZ);
+			rc += crypto_core_ristretto255_sub( RHS, ctx->cmt, RHS); // U' - xP1
+			rc += crypto_scalarmult_ristretto255( RHS, ctx->c, RHS); // c( U' - xP1 )
+			// T + c(U' - xP1)
+			rc += crypto_core_ristretto255_add( RHS, RHS, ctx->cmt+RS_EPSZ);
+			rc += crypto_verify_32( LHS, RHS );
+			break;
+		}
+
+		ps->out[0] = rc == 0 ? 0x00 : 0x01;
+		ps->olen = 1;
+		ps->need = 0;
+		ps->heavy = 0;
+		ps->rc = rc;
+		debug("Replied: %02X\n",ps->out[0]);
+		return PS_DONE;
+	}
+
+	void vrffree(void *vctx){
+		sodium_memzero(vctx, sizeof(struct vrfctx));
+		free(vctx); return;
+	}
+
+	//prover session state for the sans-io core
+	struct prvctx{
+		int stage;
+		struct signat *usk;
+		const unsigned char *mbuffer; size_t mlen;
+		unsigned char c[RS_EPSZ];
+		unsigned char y[2*RS_SCSZ];
+		unsigned char xp1[RS_SCSZ], xp2[RS_SCSZ];
+	};
+
+	int prvinit(
+		void *vusk,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	){
+		struct prvctx *tmp = (struct prvctx *)malloc(sizeof(struct prvctx));
+		tmp->stage = 0;
+		tmp->usk = (struct signat *)vusk;
+		tmp->mbuffer = mbuffer;
+		tmp->mlen = mlen;
+
+		//verifier moves first with the PRE-NONCE
+		ps->need = RS_EPSZ;
+		ps->heavy = 1;
+		*out = (void *)tmp; return 0;
+	}
+
+	int prvstep(void *vctx, struct pstep *ps){
+		struct prvctx *ctx = (struct prvctx *)vctx;
+		crypto_hash_sha512_state pre;
+		unsigned char tmp1[RS_EPSZ], tmp2[RS_EPSZ], tmp[RS_SCSZ];
+		int rc = 0;
+
+		switch(ctx->stage++){
+		case 0:
+			//--------------------------------------------------------
+			//--------------RECEIVE PRE-NONCE, COMPUTE AND SEND COMMIT
+			memcpy( ctx->c, ps->in, RS_EPSZ);
+			rng::bytes(ctx->y, 2*RS_EPSZ);
+			hashpre(&pre, ctx->mbuffer, ctx->mlen);
+			hashfrom(ctx->xp1, &pre, ctx->y, ctx->c);
+			hashfrom(ctx->xp2, &pre, ctx->y+RS_SCSZ, ctx->c);
+
+			//CMT <- U', T
+			memcpy( ps->out, ctx->usk->U, RS_EPSZ);
+			rc += crypto_scalarmult_ristretto255_base( tmp1, ctx->xp1);
+			rc += crypto_scalarmult_ristretto255( tmp2, ctx->xp2, ctx->usk->B2);
+			rc += crypto_core_ristretto255_add( ps->out+RS_EPSZ, tmp1, tmp2);
+			if( rc != 0 ){
+				lerror("Failed to compute COMMIT\n");
+				ps->olen = 0; ps->rc = 1;
+				return PS_DONE;
+			}
+			ps->olen = 2*RS_EPSZ;
+			ps->need = 2*RS_SCSZ;
+			ps->heavy = 1;
+			return PS_CONT;
+		case 1:
+			//--------------------------------------------------------
+			//--------------RECEIVE AND VERIFY REVEAL
+			rc += crypto_scalarmult_ristretto255_base( tmp1, ps->in); //fixed
+			rc += crypto_scalarmult_ristretto255( tmp2, ps->in+RS_SCSZ, ctx->usk->P2);//rH
+			rc += crypto_core_ristretto255_add( tmp, tmp1, tmp2);
+			rc += crypto_verify_32(tmp, ctx->c);
+			if( rc != 0){
+				//prevent reset attacks by aborting
+				lerror("Invalid REVEAL, aborting\n");
+				//send back garbage
+				memcpy( ps->out, ctx->y, 2*RS_SCSZ);
+				ps->olen = 2*RS_SCSZ;
+				ps->need = 0;
+				ps->rc = 1;
+				return PS_DONE;
+			}
+
+			//--------------COMPUTE AND SEND RESPONSE
+			// y = t + cs
+			crypto_core_ristretto255_scalar_mul( ps->out, ctx->c, ctx->usk->s1 );
+			crypto_core_ristretto255_scalar_add( ps->out, ps->out, ctx->xp1 );
+			crypto_core_ristretto255_scalar_mul( ps->out+RS_SCSZ, ctx->c, ctx->usk->s2 );
+			crypto_core_ristretto255_scalar_add( ps->out+RS_SCSZ, ps->out+RS_SCSZ, ctx->xp2 );
+			sodium_memzero(ctx->xp1, RS_SCSZ);
+			sodium_memzero(ctx->xp2, RS_SCSZ);
+			ps->olen = 2*RS_SCSZ;
+			ps->need = 1;
+			ps->heavy = 0;
+			return PS_CONT;
+		default:
+			//--------------------------------------------------------
+			//--------------RECEIVE RESULT
+			debug("Received: %02X\n",ps->in[0]);
+			ps->olen = 0;
+			ps->need = 0;
+			ps->rc = (int)ps->in[0];
+			return PS_DONE;
+		}
+	}
+
+	void prvfree(void *vctx){
+		sodium_memzero(vctx, sizeof(struct prvctx));
+		free(vctx); return;
+	}
 }
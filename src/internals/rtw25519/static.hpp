@@ -37,6 +37,10 @@
 
 #include "../cmacro.h"
 #include <stddef.h>
+#include <sodium.h>
+
+struct kview;
+struct sigstream;
 
 namespace rtw25519 {
 
@@ -92,15 +96,45 @@ namespace rtw25519 {
 		const unsigned char *mbuffer, size_t mlen
 	);
 
-	// hash( m, u, v) to a scalar in ristretto255
-	// output is always size RS_SCSZ
-	unsigned char *hashexec(
+	//signatgen and signatchk of an ID given piece by piece: signatini
+	//starts the stream, the ID goes through sigabsorb (internal.hpp)
+	void signatini(void *vkey, struct sigstream *ss);
+	void signatfin(void *vkey, struct sigstream *ss, void **out);
+	int signatchkp(void *vpar, void *vsig, const struct sigstream *ss);
+
+	//signatgen over n messages, the challenges of up to SHA512MB_LANES
+	//of them hashed at once
+	void signatgenv(
+		void *vkey, size_t n,
+		const unsigned char *const *mbuffer, const size_t *mlen,
+		void **out
+	);
+
+	// hash( m, u, v) to a scalar in ristretto255, written to out
+	// (always size RS_SCSZ)
+	void hashexec(
+		unsigned char *out,
 		const unsigned char *mbuffer, size_t mlen,
-		unsigned char *ubuffer,
-		unsigned char *vbuffer
+		const unsigned char *ubuffer,
+		const unsigned char *vbuffer
+	);
+	//the same in two parts, hashpre absorbs the ID into a midstate that
+	//hashfrom starts from, when one ID is hashed more than once
+	void hashpre(crypto_hash_sha512_state *pre, const unsigned char *mbuffer, size_t mlen);
+	void hashfrom(
+		unsigned char *out,
+		const crypto_hash_sha512_state *pre,
+		const unsigned char *ubuffer,
+		const unsigned char *vbuffer
+	);
+	//hashexec of n (m, u, v) at once, multi-buffer SHA-512
+	void hashexecv(
+		unsigned char *const *out,
+		const unsigned char *const *mbuffer, const size_t *mlen,
+		const unsigned char *const *ubuffer,
+		const unsigned char *const *vbuffer,
+		size_t n
 	);
-	//frees up the hash
-	void hashfree(unsigned char *hash);
 
 	//serialize the secret,public and signature from a structure
 	size_t secserial(void *in, unsigned char **sbuffer, size_t *slen);
@@ -113,6 +147,11 @@ namespace rtw25519 {
 	void pubstruct(const unsigned char *pbuffer, size_t plen, void **out);
 	void sigstruct(const unsigned char *obuffer, size_t olen, void **out);
 
+	//the same, parsed in place into a view (see internal.hpp) without
+	//copying or allocating, 1 if the length is not the scheme's
+	int pubview(const unsigned char *pbuffer, size_t plen, struct kview *view);
+	int sigview(const unsigned char *obuffer, size_t olen, struct kview *view);
+
 	//destroy secret,public and signature struct
 	void secdestroy(void *in);
 	void pubdestroy(void *in);
@@ -38,11 +38,15 @@
 // include general prototype and macro
 #include "../proto.hpp"
 #include "../cmacro.h"
+#include "../rng.hpp"
+#include "../ifcall.hpp"
+#include "../vcache.hpp"
 
 //mini socket library
 #include "../../utils/bufhelp.h"
 #include "../../utils/debug.h"
 #include "../../utils/simplesock.h"
+#include "../../utils/usdt.h"
 
 // implementation includes (archlinux os stored under /usr/include/sodium)
 //Nacl Finite Field Arithmetic on top of Curve25519
@@ -71,20 +75,23 @@ namespace sch25519{
 		unsigned char buf[TS_MAXSZ] = {0};
 
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(t);
+		rng::scalar(t);
 
 		//--------------------------------------------------------
 		//--------------COMPUTE AND SEND COMMIT
 		//CMT <- U', T
 		// T = tB
 		memcpy( buf, usk->U, RS_EPSZ);
+		probe_crypt_start(A25519_SCHNORR, sock, USDT_PROVER);
 		rc = crypto_scalarmult_ristretto255_base( buf+RS_EPSZ, t);
+		probe_crypt_done(A25519_SCHNORR, sock, USDT_PROVER);
 		if( rc != 0 ){
 			//abort if fail
 			lerror("Failed to compute COMMIT\n");
 			return 1;
 		}
 		sendbuf( sock, (char *)buf , 2*RS_EPSZ); //send CMT
+		probe_move_send(A25519_SCHNORR, sock, USDT_PROVER, 2*RS_EPSZ);
 
 		//--------------------------------------------------------
 		//--------------RECEIVE CHALLENGE
@@ -94,6 +101,7 @@ namespace sch25519{
 			lerror("Failed to recv CHALLENGE from verifier\n");
 			return 1;
 		}
+		probe_move_recv(A25519_SCHNORR, sock, USDT_PROVER, RS_SCSZ);
 
 		//--------------COMPUTE AND SEND RESPONSE
 		// y = t + cs
@@ -112,6 +120,7 @@ namespace sch25519{
 		memset(t, 0, RS_SCSZ); //zero t
 		memset(buf, 0, 2*RS_EPSZ); //zero U,V and T
 		sendbuf(sock, (char *)y , RS_SCSZ);
+		probe_move_send(A25519_SCHNORR, sock, USDT_PROVER, RS_SCSZ);
 
 		buf[0] = 0x01;
 		rc = fixed_recvbuf(sock, (char *)buf, 1); //receive final result
@@ -119,6 +128,7 @@ namespace sch25519{
 			lerror("Failed to recv RESULT from verifier\n");
 			return 1;
 		}
+		probe_move_recv(A25519_SCHNORR, sock, USDT_PROVER, 1);
 		debug("Received: %02X\n",buf[0]);
 		//--------------------------TODO END
 
@@ -136,10 +146,11 @@ namespace sch25519{
 		int rc;
 
 		//--------------------------TODO START
-		unsigned char c[RS_SCSZ], y[RS_SCSZ], *xp;
+		unsigned char c[RS_SCSZ], y[RS_SCSZ], xp[RS_SCSZ];
 		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ];
 		unsigned char tmp1[RS_EPSZ], tmp2[RS_EPSZ];
 		unsigned char buf[TS_MAXSZ] = {0};
+		int hit;
 
 		//--------------------------------------------------------
 		//--------------RECEIVE COMMIT FROM PROVER
@@ -149,12 +160,14 @@ namespace sch25519{
 			lerror("Failed to recv COMMIT from prover\n");
 			return 1;
 		}
+		probe_move_recv(A25519_SCHNORR, sock, USDT_VERIFIER, 2*RS_EPSZ);
 
 		//--------------------------------------------------------
 		//---------------------SEND THE CHALLENGE
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(c);
+		rng::scalar(c);
 		sendbuf(sock, (char *)c , RS_SCSZ);
+		probe_move_send(A25519_SCHNORR, sock, USDT_VERIFIER, RS_SCSZ);
 		memset(y, 0, RS_SCSZ);
 		//--------------------------------------------------------
 		//---------------------RECEIVE RESPONSE
@@ -163,9 +176,18 @@ namespace sch25519{
 			lerror("Failed to recv RESPONSE from prover\n");
 			return 1;
 		}
+		probe_move_recv(A25519_SCHNORR, sock, USDT_VERIFIER, RS_SCSZ);
 
-		//hash
-		xp = hashexec(mbuffer, mlen, buf, par->P1);
+		probe_crypt_start(A25519_SCHNORR, sock, USDT_VERIFIER);
+		//x and U' - xP1 of an identity seen before come from the cache
+		rc = 0;
+		hit = vcache::lookup(A25519_SCHNORR, par->P1, mbuffer, mlen, buf, NULL, xp, tmp2) == 0;
+		if(!hit){
+			//hash
+			hashexec(xp, mbuffer, mlen, buf, par->P1);
+			rc += crypto_scalarmult_ristretto255( tmp1, xp, par->P1); // xP1
+			rc += crypto_core_ristretto255_sub( tmp2, buf, tmp1); // U' - xP1
+		}
 
 #ifdef DEBUG
 	pubprint(par);
@@ -177,24 +199,30 @@ namespace sch25519{
 #endif
 
 		// yB = T + c( U' - xP1 )
-		rc = crypto_scalarmult_ristretto255( tmp1, xp, par->P1); // xP1
-		//zero and free
-		hashfree(xp);
-		rc = 0;
 		rc += crypto_scalarmult_ristretto255_base( LHS, y); // yB
-		rc += crypto_core_ristretto255_sub( tmp2, buf, tmp1); // U' - xP1
 		rc += crypto_scalarmult_ristretto255( tmp1, c, tmp2); // c( U' - xP1 )
 		rc += crypto_core_ristretto255_add( RHS, tmp1, buf+RS_EPSZ);// T + c(U' - xP1)
-		if( rc != 0 ) return rc; //abort if fail
+		probe_crypt_done(A25519_SCHNORR, sock, USDT_VERIFIER);
+		if( rc != 0 ){
+			sodium_memzero(xp, RS_SCSZ);
+			return rc; //abort if fail
+		}
 
 		//check if tmp is equal to x from obuffer
 		rc = crypto_verify_32( LHS, RHS );
+		//only identities that proved themselves take up room
+		if( rc == 0 && !hit ){
+			vcache::insert(A25519_SCHNORR, par->P1, mbuffer, mlen, buf, NULL, xp, tmp2);
+		}
+		//zero
+		sodium_memzero(xp, RS_SCSZ);
 		if( rc == 0 ){
 			buf[0] = 0x00;
 		}else{
 			buf[0] = 0x01;
 		}
 		sendbuf(sock, (char *)buf , 1); //send back the results
+		probe_move_send(A25519_SCHNORR, sock, USDT_VERIFIER, 1);
 		debug("Replied: %02X\n",buf[0]);
 		//--------------------------TODO END
 
@@ -213,24 +241,24 @@ namespace sch25519{
 		struct pubkey *par = (struct pubkey *)vpar;
 		struct signat *usk = (struct signat *)vusk;
 		int rc;
-		unsigned char t[RS_SCSZ], c[RS_SCSZ], y[RS_SCSZ], *xp;
+		unsigned char t[RS_SCSZ], c[RS_SCSZ], y[RS_SCSZ], xp[RS_SCSZ];
 		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ], tmp[RS_EPSZ];
 
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(t);
+		rng::scalar(t);
 		//sample c (challenge)
-		crypto_core_ristretto255_scalar_random(c);
+		rng::scalar(c);
 
 		//compute response
 		crypto_core_ristretto255_scalar_mul( y , c, usk->s ); //
 		crypto_core_ristretto255_scalar_add( y, y, t ); // y = t + cs
 
-		xp = hashexec(mbuffer, mlen, usk->U, par->P1);
+		hashexec(xp, mbuffer, mlen, usk->U, par->P1);
 
 		rc = 0;
 		rc += crypto_scalarmult_ristretto255_base( LHS, y); // yB
 		rc += crypto_scalarmult_ristretto255( RHS, xp, par->P1); // xP1
-		hashfree(xp); //zero and free
+		sodium_memzero(xp, RS_SCSZ); //zero
 		rc += crypto_core_ristretto255_sub( RHS, usk->U, RHS); // U' - xP1
 		rc += crypto_scalarmult_ristretto255( RHS, c, RHS); // c( U' - xP1 )
 
@@ -243,4 +271,160 @@ namespace sch25519{
 		return rc;
 	}
 
+
+	//verifier session state for the sans-io core
+	struct vrfctx{
+		int stage;
+		struct pubkey *par;
+		const unsigned char *mbuffer; size_t mlen;
+		unsigned char c[RS_SCSZ];
+		unsigned char cmt[2*RS_EPSZ];
+	};
+
+	int vrfinit(
+		void *vpar,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	){
+		struct vrfctx *tmp = (struct vrfctx *)malloc(sizeof(struct vrfctx));
+		tmp->stage = 0;
+		tmp->par = (struct pubkey *)vpar;
+		tmp->mbuffer = mbuffer;
+		tmp->mlen = mlen;
+
+		//first move is the COMMIT from the prover
+		//CMT <- U', T
+		ps->need = 2*RS_EPSZ;
+		ps->heavy = 0;
+		*out = (void *)tmp; return 0;
+	}
+
+	int vrfstep(void *vctx, struct pstep *ps){
+		struct vrfctx *ctx = (struct vrfctx *)vctx;
+		unsigned char xp[RS_SCSZ];
+		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ];
+		unsigned char tmp1[RS_EPSZ], tmp2[RS_EPSZ];
+		int rc, hit;
+
+		if(ctx->stage++ == 0){
+			//--------------------------------------------------------
+			//---------------------RECEIVE COMMIT, SEND THE CHALLENGE
+			memcpy( ctx->cmt, ps->in, 2*RS_EPSZ);
+			rng::scalar(ctx->c);
+			memcpy( ps->out, ctx->c, RS_SCSZ);
+			ps->olen = RS_SCSZ;
+			ps->need = RS_SCSZ;
+			ps->heavy = 1;
+			return PS_CONT;
+		}
+
+		//--------------------------------------------------------
+		//---------------------RECEIVE RESPONSE, SEND THE RESULT
+		rc = 0;
+		hit = vcache::lookup(A25519_SCHNORR, ctx->par->P1, ctx->mbuffer, ctx->mlen,
+			ctx->cmt, NULL, xp, tmp2) == 0;
+		if(!hit){
+			hashexec(xp, ctx->mbuffer, ctx->mlen, ctx->cmt, ctx->par->P1);
+			rc += crypto_scalarmult_ristretto255( tmp1, xp, ctx->par->P1); // xP1
+			rc += crypto_core_ristretto255_sub( tmp2, ctx->cmt, tmp1); // U' - xP1
+		}
+
+		// yB = T + c( U' - xP1 )
+		rc += crypto_scalarmult_ristretto255_base( LHS, ps->in); // yB
+		rc += crypto_scalarmult_ristretto255( tmp1, ctx->c, tmp2); // c( U' - xP1 )
+		rc += crypto_core_ristretto255_add( RHS, tmp1, ctx->cmt+RS_EPSZ);// T + c(U' - xP1)
+
+		rc += crypto_verify_32( LHS, RHS );
+		if( rc == 0 && !hit ){
+			vcache::insert(A25519_SCHNORR, ctx->par->P1, ctx->mbuffer, ctx->mlen,
+				ctx->cmt, NULL, xp, tmp2);
+		}
+		sodium_memzero(xp, RS_SCSZ);
+		ps->out[0] = rc == 0 ? 0x00 : 0x01;
+		ps->olen = 1;
+		ps->need = 0;
+		ps->heavy = 0;
+		ps->rc = rc;
+		debug("Replied: %02X\n",ps->out[0]);
+		return PS_DONE;
+	}
+
+	void vrffree(void *vctx){
+		sodium_memzero(vctx, sizeof(struct vrfctx));
+		free(vctx); return;
+	}
+
+	//prover session state for the sans-io core
+	struct prvctx{
+		int stage;
+		struct signat *usk;
+		unsigned char t[RS_SCSZ];
+	};
+
+	int prvinit(
+		void *vusk,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	){
+		struct prvctx *tmp = (struct prvctx *)malloc(sizeof(struct prvctx));
+		tmp->stage = 0;
+		tmp->usk = (struct signat *)vusk;
+
+		//prover moves first with the COMMIT
+		ps->need = 0;
+		ps->heavy = 1;
+		*out = (void *)tmp; return 0;
+	}
+
+	int prvstep(void *vctx, struct pstep *ps){
+		struct prvctx *ctx = (struct prvctx *)vctx;
+		int rc;
+
+		switch(ctx->stage++){
+		case 0:
+			//--------------------------------------------------------
+			//--------------COMPUTE AND SEND COMMIT
+			//CMT <- U', T
+			// T = tB
+			rng::scalar(ctx->t);
+			memcpy( ps->out, ctx->usk->U, RS_EPSZ);
+			rc = crypto_scalarmult_ristretto255_base( ps->out+1*RS_EPSZ, ctx->t);
+			if( rc != 0 ){
+				lerror("Failed to compute COMMIT\n");
+				ps->olen = 0; ps->rc = 1;
+				return PS_DONE;
+			}
+			ps->olen = 2*RS_EPSZ;
+			ps->need = RS_SCSZ;
+			ps->heavy = 0;
+			return PS_CONT;
+		case 1:
+			//--------------------------------------------------------
+			//--------------RECEIVE CHALLENGE, SEND RESPONSE
+			// y = t + cs
+			crypto_core_ristretto255_scalar_mul( ps->out, ps->in, ctx->usk->s );
+			crypto_core_ristretto255_scalar_add( ps->out, ps->out, ctx->t );
+			//PREVENT RESET ATTACKS, clear the commit
+			sodium_memzero(ctx->t, RS_SCSZ);
+			ps->olen = RS_SCSZ;
+			ps->need = 1;
+			ps->heavy = 0;
+			return PS_CONT;
+		default:
+			//--------------------------------------------------------
+			//--------------RECEIVE RESULT
+			debug("Received: %02X\n",ps->in[0]);
+			ps->olen = 0;
+			ps->need = 0;
+			ps->rc = (int)ps->in[0];
+			return PS_DONE;
+		}
+	}
+
+	void prvfree(void *vctx){
+		sodium_memzero(vctx, sizeof(struct prvctx));
+		free(vctx); return;
+	}
 }
@@ -49,7 +49,20 @@ namespace <TEMPLATE>{
 		&sigprint,
 		&signatprv,
 		&signatvrf,
-		&prototest
+		&prototest,
+		&vrfinit,
+		&vrfstep,
+		&vrffree,
+		&prvinit,
+		&prvstep,
+		&prvfree,
+		NULL,	//signatgenv, optional
+		NULL,	//signatchkv, optional
+		&pubview,
+		&sigview,
+		NULL,
+		NULL,
+		NULL
 	};
 }
 
@@ -38,6 +38,7 @@
 // include general prototype and macro
 #include "../proto.hpp"
 #include "../cmacro.h"
+#include "../rng.hpp"
 
 //mini socket library
 #include "../../utils/bufhelp.h"
@@ -68,7 +69,7 @@ namespace <TEMPLATE>{
 
 		//-------------------------------------TODO START EDIT
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(t);
+		rng::scalar(t);
 
 		//--------------------------------------------------------
 		//--------------COMPUTE AND SEND COMMIT
@@ -150,7 +151,7 @@ namespace <TEMPLATE>{
 		//--------------------------------------------------------
 		//---------------------SEND THE CHALLENGE
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(c);
+		rng::scalar(c);
 		sendbuf(sock, (char *)c , RS_SCSZ);
 
 		//--------------------------------------------------------
@@ -216,9 +217,9 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 		//-------------------------------------TODO START EDIT
 
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(t);
+		rng::scalar(t);
 		//sample c (challenge)
-		crypto_core_ristretto255_scalar_random(c);
+		rng::scalar(c);
 
 		//compute response
 		crypto_core_ristretto255_scalar_mul( y , c, usk->s ); //
@@ -247,4 +248,153 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 		//-------------------------------------TODO END EDIT
 		return rc;
 	}
+
+	//verifier session state for the sans-io core
+	struct vrfctx{
+		int stage;
+		struct pubkey *par;
+		const unsigned char *mbuffer; size_t mlen;
+		unsigned char c[RS_SCSZ];
+		unsigned char cmt[3*RS_EPSZ];
+	};
+
+	int vrfinit(
+		void *vpar,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	){
+		struct vrfctx *tmp = (struct vrfctx *)malloc(sizeof(struct vrfctx));
+		tmp->stage = 0;
+		tmp->par = (struct pubkey *)vpar;
+		tmp->mbuffer = mbuffer;
+		tmp->mlen = mlen;
+
+		//first move is the COMMIT from the prover
+		//CMT <- U',V' T
+		ps->need = 3*RS_EPSZ;
+		ps->heavy = 0;
+		*out = (void *)tmp; return 0;
+	}
+
+	int vrfstep(void *vctx, struct pstep *ps){
+		struct vrfctx *ctx = (struct vrfctx *)vctx;
+		unsigned char *xp;
+		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ];
+		int rc;
+
+		if(ctx->stage++ == 0){
+			//--------------------------------------------------------
+			//---------------------RECEIVE COMMIT, SEND THE CHALLENGE
+			memcpy( ctx->cmt, ps->in, 3*RS_EPSZ);
+			rng::scalar(ctx->c);
+			memcpy( ps->out, ctx->c, RS_SCSZ);
+			ps->olen = RS_SCSZ;
+			ps->need = RS_SCSZ;
+			ps->heavy = 1;
+			return PS_CONT;
+		}
+
+		//--------------------------------------------------------
+		//---------------------RECEIVE RESPONSE, SEND THE RESULT
+		xp = hashexec(ctx->mbuffer, ctx->mlen, ctx->cmt, ctx->cmt+RS_EPSZ);
+
+		// yB = T + c( U' - xP1 )
+		rc = 0;
+		rc += crypto_scalarmult_ristretto255_base( LHS, ps->in ); // yB
+		rc += crypto_scalarmult_ristretto255( RHS, xp, ctx->par->P1); // xP1
+		rc += crypto_core_ristretto255_add( RHS, ctx->cmt, RHS); // U' - xP1
+		rc += crypto_scalarmult_ristretto255( RHS, ctx->c, RHS); // c( U' - xP1 )
+		// T + c(U' - xP1)
+		rc += crypto_core_ristretto255_add( RHS, RHS, ctx->cmt+2*RS_EPSZ);
+		hashfree(xp);
+
+		rc += crypto_verify_32( LHS, RHS );
+		ps->out[0] = rc == 0 ? 0x00 : 0x01;
+		ps->olen = 1;
+		ps->need = 0;
+		ps->heavy = 0;
+		ps->rc = rc;
+		debug("Replied: %02X\n",ps->out[0]);
+		return PS_DONE;
+	}
+
+	void vrffree(void *vctx){
+		sodium_memzero(vctx, sizeof(struct vrfctx));
+		free(vctx); return;
+	}
+
+	//prover session state for the sans-io core
+	struct prvctx{
+		int stage;
+		struct signat *usk;
+		unsigned char t[RS_SCSZ];
+	};
+
+	int prvinit(
+		void *vusk,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	){
+		struct prvctx *tmp = (struct prvctx *)malloc(sizeof(struct prvctx));
+		tmp->stage = 0;
+		tmp->usk = (struct signat *)vusk;
+
+		//prover moves first with the COMMIT
+		ps->need = 0;
+		ps->heavy = 1;
+		*out = (void *)tmp; return 0;
+	}
+
+	int prvstep(void *vctx, struct pstep *ps){
+		struct prvctx *ctx = (struct prvctx *)vctx;
+		int rc;
+
+		switch(ctx->stage++){
+		case 0:
+			//--------------------------------------------------------
+			//--------------COMPUTE AND SEND COMMIT
+			//CMT <- U',V' T
+			// T = tB
+			rng::scalar(ctx->t);
+			memcpy( ps->out, ctx->usk->U, RS_EPSZ);
+			memcpy( ps->out+RS_EPSZ, ctx->usk->V, RS_EPSZ);
+			rc = crypto_scalarmult_ristretto255_base( ps->out+2*RS_EPSZ, ctx->t);
+			if( rc != 0 ){
+				lerror("Failed to compute COMMIT\n");
+				ps->olen = 0; ps->rc = 1;
+				return PS_DONE;
+			}
+			ps->olen = 3*RS_EPSZ;
+			ps->need = RS_SCSZ;
+			ps->heavy = 0;
+			return PS_CONT;
+		case 1:
+			//--------------------------------------------------------
+			//--------------RECEIVE CHALLENGE, SEND RESPONSE
+			// y = t + cs
+			crypto_core_ristretto255_scalar_mul( ps->out, ps->in, ctx->usk->s );
+			crypto_core_ristretto255_scalar_add( ps->out, ps->out, ctx->t );
+			//PREVENT RESET ATTACKS, clear the commit
+			sodium_memzero(ctx->t, RS_SCSZ);
+			ps->olen = RS_SCSZ;
+			ps->need = 1;
+			ps->heavy = 0;
+			return PS_CONT;
+		default:
+			//--------------------------------------------------------
+			//--------------RECEIVE RESULT
+			debug("Received: %02X\n",ps->in[0]);
+			ps->olen = 0;
+			ps->need = 0;
+			ps->rc = (int)ps->in[0];
+			return PS_DONE;
+		}
+	}
+
+	void prvfree(void *vctx){
+		sodium_memzero(vctx, sizeof(struct prvctx));
+		free(vctx); return;
+	}
 }
@@ -37,6 +37,7 @@
 
 #include <stddef.h>
 #include "static.hpp"
+#include "../internal.hpp"
 
 namespace <TEMPLATE> {
 
@@ -60,6 +61,36 @@ namespace <TEMPLATE> {
 		void *vusk,
 		const unsigned char *mbuffer, size_t mlen
 	);
+
+	//sans-io verifier, prepares the session state for ID mbuffer
+	int vrfinit(
+		void *vpar,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	);
+
+	//sans-io verifier, consume a move and produce the reply
+	//return PS_DONE once the result is in ps->out and ps->rc
+	int vrfstep(void *vctx, struct pstep *ps);
+
+	//destroy the verifier session state
+	void vrffree(void *vctx);
+
+	//sans-io prover, prepares the session state for ID mbuffer
+	int prvinit(
+		void *vusk,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	);
+
+	//sans-io prover, consume a move and produce the reply
+	//return PS_DONE once the verifier's result is in ps->rc
+	int prvstep(void *vctx, struct pstep *ps);
+
+	//destroy the prover session state
+	void prvfree(void *vctx);
 }
 
 #endif
@@ -33,6 +33,8 @@
  */
 
 #include "static.hpp"
+#include "../internal.hpp"
+#include "../nonce.hpp"
 
 #include "../../utils/bufhelp.h"
 #include "../../utils/debug.h"
@@ -55,6 +57,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
+#include <new>
 
 /*
  * Key storage detail (as of 2020 Mar 22)
@@ -118,8 +121,8 @@ namespace <TEMPLATE>{
 		tmp->U = (unsigned char *)malloc( RS_EPSZ );
 		tmp->V = (unsigned char *)malloc( RS_EPSZ );
 
-		//sample r (MUST RANDOMIZE, else secret key a will be exposed)
-		crypto_core_ristretto255_scalar_random(nonce);
+		//r random, or derived from a and the ID (see nonce.hpp)
+		nonce::draw(nonce, 1, &key->a, 1, mbuffer, mlen);
 
 		rc = 0;
 		// U = rB ; V = rP1
@@ -305,6 +308,31 @@ namespace <TEMPLATE>{
 		*out = (void *) tmp; return;
 	}
 
+	static_assert( sizeof(struct pubkey) <= sizeof(struct kview), "view storage" );
+	static_assert( sizeof(struct signat) <= sizeof(struct kview), "view storage" );
+
+	int pubview(const unsigned char *pbuffer, size_t plen, struct kview *view){
+		struct pubkey *tmp;
+		if( pbuffer == NULL || plen != PKEY_SZ ) return 1;
+		//the struct lives in the view, its components in the buffer
+		tmp = new (view->b) pubkey;
+		tmp->P1 = (unsigned char *)pbuffer;
+		tmp->P2 = (unsigned char *)pbuffer + RS_EPSZ;
+		return 0;
+	}
+
+	int sigview(const unsigned char *obuffer, size_t olen, struct kview *view){
+		struct signat *tmp;
+		if( obuffer == NULL || olen != SGNT_SZ ) return 1;
+		//the struct lives in the view, its components in the buffer
+		tmp = new (view->b) signat;
+		tmp->s = (unsigned char *)obuffer;
+		tmp->x = (unsigned char *)obuffer + RS_SCSZ;
+		tmp->U = (unsigned char *)obuffer + 2*RS_SCSZ;
+		tmp->V = (unsigned char *)obuffer + 2*RS_SCSZ + RS_EPSZ;
+		return 0;
+	}
+
 	//destroy secret key
 	void secdestroy(void *in){
 		//key recast
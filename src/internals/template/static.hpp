@@ -38,6 +38,8 @@
 #include "../cmacro.h"
 #include <stddef.h>
 
+struct kview;
+
 namespace <TEMPLATE> {
 
 	// Size definitions TODO: please edit NEPC and NSCC accordingly
@@ -114,6 +116,11 @@ namespace <TEMPLATE> {
 	void pubstruct(const unsigned char *pbuffer, size_t plen, void **out);
 	void sigstruct(const unsigned char *obuffer, size_t olen, void **out);
 
+	//the same, parsed in place into a view (see internal.hpp) without
+	//copying or allocating, 1 if the length is not the scheme's
+	int pubview(const unsigned char *pbuffer, size_t plen, struct kview *view);
+	int sigview(const unsigned char *obuffer, size_t olen, struct kview *view);
+
 	//destroy secret,public and signature struct
 	void secdestroy(void *in);
 	void pubdestroy(void *in);
@@ -49,7 +49,20 @@ namespace tnc25519{
 		&sigprint,
 		&signatprv,
 		&signatvrf,
-		&prototest
+		&prototest,
+		&vrfinit,
+		&vrfstep,
+		&vrffree,
+		&prvinit,
+		&prvstep,
+		&prvfree,
+		&signatgenv,
+		&signatchkv,
+		&pubview,
+		&sigview,
+		&signatini,
+		&signatfin,
+		&signatchkp
 	};
 }
 
@@ -38,11 +38,15 @@
 // include general prototype and macro
 #include "../proto.hpp"
 #include "../cmacro.h"
+#include "../rng.hpp"
+#include "../ifcall.hpp"
+#include "../vcache.hpp"
 
 //mini socket library
 #include "../../utils/bufhelp.h"
 #include "../../utils/debug.h"
 #include "../../utils/simplesock.h"
+#include "../../utils/usdt.h"
 
 // implementation includes (archlinux os stored under /usr/include/sodium)
 //Nacl Finite Field Arithmetic on top of Curve25519
@@ -68,7 +72,7 @@ namespace tnc25519{
 
 		//-------------------------------------TODO START EDIT
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(t);
+		rng::scalar(t);
 
 		//--------------------------------------------------------
 		//--------------COMPUTE AND SEND COMMIT
@@ -76,13 +80,16 @@ namespace tnc25519{
 		// T = tB
 		memcpy( buf, usk->U, RS_EPSZ);
 		memcpy( buf+RS_EPSZ, usk->V, RS_EPSZ);
+		probe_crypt_start(A25519_TNC, sock, USDT_PROVER);
 		rc = crypto_scalarmult_ristretto255_base( buf+2*RS_EPSZ, t);
+		probe_crypt_done(A25519_TNC, sock, USDT_PROVER);
 		if( rc != 0 ){
 			//abort if fail
 			lerror("Failed to compute COMMIT\n");
 			return 1;
 		}
 		sendbuf( sock, (char *)buf , 3*RS_EPSZ); //send CMT
+		probe_move_send(A25519_TNC, sock, USDT_PROVER, 3*RS_EPSZ);
 
 		//--------------------------------------------------------
 		//--------------RECEIVE CHALLENGE
@@ -91,6 +98,7 @@ namespace tnc25519{
 			lerror("Failed to recv CHALLENGE from verifier\n");
 			return 1;
 		}
+		probe_move_recv(A25519_TNC, sock, USDT_PROVER, RS_SCSZ);
 
 		//--------------COMPUTE AND SEND RESPONSE
 		// y = t + cs
@@ -109,6 +117,7 @@ namespace tnc25519{
 		memset(t, 0, RS_SCSZ); //zero t
 		memset(buf, 0, TS_MAXSZ); //zero U,V and T
 		sendbuf(sock, (char *)y , RS_SCSZ);
+		probe_move_send(A25519_TNC, sock, USDT_PROVER, RS_SCSZ);
 
 		buf[0] = 0x01;
 		rc = fixed_recvbuf(sock, (char *)buf, 1); //receive final result
@@ -116,6 +125,7 @@ namespace tnc25519{
 			lerror("Failed to recv RESULT from verifier\n");
 			return 1;
 		}
+		probe_move_recv(A25519_TNC, sock, USDT_PROVER, 1);
 		debug("Received: %02X\n",buf[0]);
 
 		//-------------------------------------TODO END EDIT
@@ -131,10 +141,10 @@ namespace tnc25519{
 		//socket check and key recast
 		if(sock == -1){return 1;}
 		struct pubkey *par = (struct pubkey *)vpar;
-		unsigned char c[RS_SCSZ], y[RS_SCSZ], *xp;
-		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ];
+		unsigned char c[RS_SCSZ], y[RS_SCSZ], xp[RS_SCSZ];
+		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ], UX[RS_EPSZ];
 		unsigned char buf[TS_MAXSZ] = {0};
-		int rc;
+		int rc, hit;
 
 		//-------------------------------------TODO START EDIT
 
@@ -146,12 +156,14 @@ namespace tnc25519{
 			lerror("Failed to recv COMMIT from prover\n");
 			return 1;
 		}
+		probe_move_recv(A25519_TNC, sock, USDT_VERIFIER, 3*RS_EPSZ);
 
 		//--------------------------------------------------------
 		//---------------------SEND THE CHALLENGE
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(c);
+		rng::scalar(c);
 		sendbuf(sock, (char *)c , RS_SCSZ);
+		probe_move_send(A25519_TNC, sock, USDT_VERIFIER, RS_SCSZ);
 
 		//--------------------------------------------------------
 		//---------------------RECEIVE RESPONSE
@@ -160,9 +172,18 @@ namespace tnc25519{
 			lerror("Failed to recv RESPONSE from prover\n");
 			return 1;
 		}
+		probe_move_recv(A25519_TNC, sock, USDT_VERIFIER, RS_SCSZ);
 
-		//hash
-		xp = hashexec(mbuffer, mlen, buf, (buf+RS_EPSZ) );
+		probe_crypt_start(A25519_TNC, sock, USDT_VERIFIER);
+		//x and U' + xP1 of an identity seen before come from the cache
+		rc = 0;
+		hit = vcache::lookup(A25519_TNC, par->P1, mbuffer, mlen, buf, buf+RS_EPSZ, xp, UX) == 0;
+		if(!hit){
+			//hash
+			hashexec(xp, mbuffer, mlen, buf, (buf+RS_EPSZ) );
+			rc += crypto_scalarmult_ristretto255( RHS, xp, par->P1); // xP1
+			rc += crypto_core_ristretto255_add( UX, buf, RHS); // U' - xP1
+		}
 
 #ifdef DEBUG
 pubprint(par);
@@ -175,25 +196,28 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 #endif
 
 		// yB = T + c( U' - xP1 )
-		rc = 0;
 		rc += crypto_scalarmult_ristretto255_base( LHS, y ); // yB
-		rc += crypto_scalarmult_ristretto255( RHS, xp, par->P1); // xP1
-		rc += crypto_core_ristretto255_add( RHS, buf, RHS); // U' - xP1
-		rc += crypto_scalarmult_ristretto255( RHS, c, RHS); // c( U' - xP1 )
+		rc += crypto_scalarmult_ristretto255( RHS, c, UX); // c( U' - xP1 )
 		// T + c(U' - xP1)
 		rc += crypto_core_ristretto255_add( RHS, RHS, buf+2*RS_EPSZ);
-
-		//zero and free
-		hashfree(xp);
+		probe_crypt_done(A25519_TNC, sock, USDT_VERIFIER);
 
 		//check if tmp is equal to x from obuffer
 		rc += crypto_verify_32( LHS, RHS );
+		//only identities that proved themselves take up room
+		if( rc == 0 && !hit ){
+			vcache::insert(A25519_TNC, par->P1, mbuffer, mlen, buf, buf+RS_EPSZ, xp, UX);
+		}
+
+		//zero
+		sodium_memzero(xp, RS_SCSZ);
 		if( rc == 0 ){
 			buf[0] = 0x00;
 		}else{
 			buf[0] = 0x01;
 		}
 		sendbuf(sock, (char *)buf , 1); //send back the results
+		probe_move_send(A25519_TNC, sock, USDT_VERIFIER, 1);
 		debug("Replied: %02X\n",buf[0]);
 
 		//-------------------------------------TODO END EDIT
@@ -210,27 +234,27 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 		struct pubkey *par = (struct pubkey *)vpar;
 		struct signat *usk = (struct signat *)vusk;
 		int rc;
-		unsigned char t[RS_SCSZ], c[RS_SCSZ], y[RS_SCSZ], *xp;
+		unsigned char t[RS_SCSZ], c[RS_SCSZ], y[RS_SCSZ], xp[RS_SCSZ];
 		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ], tmp[RS_EPSZ];
 
 		//-------------------------------------TODO START EDIT
 
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(t);
+		rng::scalar(t);
 		//sample c (challenge)
-		crypto_core_ristretto255_scalar_random(c);
+		rng::scalar(c);
 
 		//compute response
 		crypto_core_ristretto255_scalar_mul( y , c, usk->s ); //
 		crypto_core_ristretto255_scalar_add( y, y, t ); // y = t + cs
 
-		xp = hashexec(mbuffer, mlen, usk->U, usk->V);
+		hashexec(xp, mbuffer, mlen, usk->U, usk->V);
 
 		// yB = T + c( U' - xP1 )
 		rc = 0;
 		rc += crypto_scalarmult_ristretto255_base( LHS, y); // yB
 		rc += crypto_scalarmult_ristretto255( RHS, xp, par->P1); // xP1
-		hashfree(xp);
+		sodium_memzero(xp, RS_SCSZ);
 		rc += crypto_core_ristretto255_add( RHS, usk->U, RHS); // U' - xP1
 		rc += crypto_scalarmult_ristretto255( RHS, c, RHS); // c( U' - xP1 )
 
@@ -247,4 +271,161 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 		//-------------------------------------TODO END EDIT
 		return rc;
 	}
+
+	//verifier session state for the sans-io core
+	struct vrfctx{
+		int stage;
+		struct pubkey *par;
+		const unsigned char *mbuffer; size_t mlen;
+		unsigned char c[RS_SCSZ];
+		unsigned char cmt[3*RS_EPSZ];
+	};
+
+	int vrfinit(
+		void *vpar,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	){
+		struct vrfctx *tmp = (struct vrfctx *)malloc(sizeof(struct vrfctx));
+		tmp->stage = 0;
+		tmp->par = (struct pubkey *)vpar;
+		tmp->mbuffer = mbuffer;
+		tmp->mlen = mlen;
+
+		//first move is the COMMIT from the prover
+		//CMT <- U',V' T
+		ps->need = 3*RS_EPSZ;
+		ps->heavy = 0;
+		*out = (void *)tmp; return 0;
+	}
+
+	int vrfstep(void *vctx, struct pstep *ps){
+		struct vrfctx *ctx = (struct vrfctx *)vctx;
+		unsigned char xp[RS_SCSZ];
+		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ], UX[RS_EPSZ];
+		int rc, hit;
+
+		if(ctx->stage++ == 0){
+			//--------------------------------------------------------
+			//---------------------RECEIVE COMMIT, SEND THE CHALLENGE
+			memcpy( ctx->cmt, ps->in, 3*RS_EPSZ);
+			rng::scalar(ctx->c);
+			memcpy( ps->out, ctx->c, RS_SCSZ);
+			ps->olen = RS_SCSZ;
+			ps->need = RS_SCSZ;
+			ps->heavy = 1;
+			return PS_CONT;
+		}
+
+		//--------------------------------------------------------
+		//---------------------RECEIVE RESPONSE, SEND THE RESULT
+		rc = 0;
+		hit = vcache::lookup(A25519_TNC, ctx->par->P1, ctx->mbuffer, ctx->mlen,
+			ctx->cmt, ctx->cmt+RS_EPSZ, xp, UX) == 0;
+		if(!hit){
+			hashexec(xp, ctx->mbuffer, ctx->mlen, ctx->cmt, ctx->cmt+RS_EPSZ);
+			rc += crypto_scalarmult_ristretto255( RHS, xp, ctx->par->P1); // xP1
+			rc += crypto_core_ristretto255_add( UX, ctx->cmt, RHS); // U' - xP1
+		}
+
+		// yB = T + c( U' - xP1 )
+		rc += crypto_scalarmult_ristretto255_base( LHS, ps->in ); // yB
+		rc += crypto_scalarmult_ristretto255( RHS, ctx->c, UX); // c( U' - xP1 )
+		// T + c(U' - xP1)
+		rc += crypto_core_ristretto255_add( RHS, RHS, ctx->cmt+2*RS_EPSZ);
+
+		rc += crypto_verify_32( LHS, RHS );
+		if( rc == 0 && !hit ){
+			vcache::insert(A25519_TNC, ctx->par->P1, ctx->mbuffer, ctx->mlen,
+				ctx->cmt, ctx->cmt+RS_EPSZ, xp, UX);
+		}
+		sodium_memzero(xp, RS_SCSZ);
+		ps->out[0] = rc == 0 ? 0x00 : 0x01;
+		ps->olen = 1;
+		ps->need = 0;
+		ps->heavy = 0;
+		ps->rc = rc;
+		debug("Replied: %02X\n",ps->out[0]);
+		return PS_DONE;
+	}
+
+	void vrffree(void *vctx){
+		sodium_memzero(vctx, sizeof(struct vrfctx));
+		free(vctx); return;
+	}
+
+	//prover session state for the sans-io core
+	struct prvctx{
+		int stage;
+		struct signat *usk;
+		unsigned char t[RS_SCSZ];
+	};
+
+	int prvinit(
+		void *vusk,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	){
+		struct prvctx *tmp = (struct prvctx *)malloc(sizeof(struct prvctx));
+		tmp->stage = 0;
+		tmp->usk = (struct signat *)vusk;
+
+		//prover moves first with the COMMIT
+		ps->need = 0;
+		ps->heavy = 1;
+		*out = (void *)tmp; return 0;
+	}
+
+	int prvstep(void *vctx, struct pstep *ps){
+		struct prvctx *ctx = (struct prvctx *)vctx;
+		int rc;
+
+		switch(ctx->stage++){
+		case 0:
+			//--------------------------------------------------------
+			//--------------COMPUTE AND SEND COMMIT
+			//CMT <- U',V' T
+			// T = tB
+			rng::scalar(ctx->t);
+			memcpy( ps->out, ctx->usk->U, RS_EPSZ);
+			memcpy( ps->out+RS_EPSZ, ctx->usk->V, RS_EPSZ);
+			rc = crypto_scalarmult_ristretto255_base( ps->out+2*RS_EPSZ, ctx->t);
+			if( rc != 0 ){
+				lerror("Failed to compute COMMIT\n");
+				ps->olen = 0; ps->rc = 1;
+				return PS_DONE;
+			}
+			ps->olen = 3*RS_EPSZ;
+			ps->need = RS_SCSZ;
+			ps->heavy = 0;
+			return PS_CONT;
+		case 1:
+			//--------------------------------------------------------
+			//--------------RECEIVE CHALLENGE, SEND RESPONSE
+			// y = t + cs
+			crypto_core_ristretto255_scalar_mul( ps->out, ps->in, ctx->usk->s );
+			crypto_core_ristretto255_scalar_add( ps->out, ps->out, ctx->t );
+			//PREVENT RESET ATTACKS, clear the commit
+			sodium_memzero(ctx->t, RS_SCSZ);
+			ps->olen = RS_SCSZ;
+			ps->need = 1;
+			ps->heavy = 0;
+			return PS_CONT;
+		default:
+			//--------------------------------------------------------
+			//--------------RECEIVE RESULT
+			debug("Received: %02X\n",ps->in[0]);
+			ps->olen = 0;
+			ps->need = 0;
+			ps->rc = (int)ps->in[0];
+			return PS_DONE;
+		}
+	}
+
+	void prvfree(void *vctx){
+		sodium_memzero(vctx, sizeof(struct prvctx));
+		free(vctx); return;
+	}
 }
@@ -33,9 +33,12 @@
  */
 
 #include "static.hpp"
+#include "../internal.hpp"
+#include "../nonce.hpp"
 
 #include "../../utils/bufhelp.h"
 #include "../../utils/debug.h"
+#include "../../utils/sha512mb.h"
 
 //include general constant and macros
 #include "../cmacro.h"
@@ -55,6 +58,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
+#include <new>
 
 /*
  * Key storage detail (as of 2020 Mar 22)
@@ -101,73 +105,143 @@ namespace tnc25519{
 		*out = (void *) tmp; return;
 	}
 
-	void signatgen(
-		void *vkey,
-		const unsigned char *mbuffer, size_t mlen,
-		void **out
-	){
-		//declare and allocate for signature struct, nonce
-		struct seckey *key = (struct seckey *)vkey; //recast key
-		struct signat *tmp = (struct signat *)malloc(sizeof(struct signat));
-		int rc; unsigned char nonce[RS_SCSZ];
+	//r random, or derived from a and the ID as it is absorbed (see nonce.hpp)
+	static void signonce(struct seckey *key, struct nonce::stream *nc){
+		nonce::init(nc, 1, &key->a, 1);
+	}
 
-		//-------------------------------------TODO START EDIT
+	//commitment of a new signature, its components allocated
+	static int sigcommit(struct seckey *key, struct signat *tmp, unsigned char *nonce,
+		struct nonce::stream *nc){
+		int rc;
 		//allocate for components
 		tmp->s = (unsigned char *)sodium_malloc( RS_SCSZ );
-		//tmp->x = (unsigned char *)malloc( RS_SCSZ ); //hashexec takes care
+		tmp->x = (unsigned char *)malloc( RS_SCSZ );
 		tmp->U = (unsigned char *)malloc( RS_EPSZ );
 		tmp->V = (unsigned char *)malloc( RS_EPSZ );
 
-		//sample r (MUST RANDOMIZE, else secret key a will be exposed)
-		crypto_core_ristretto255_scalar_random(nonce);
+		//r, the ID absorbed by now
+		nonce::final(nc, nonce);
 
 		rc = 0;
 		// U = rB ; V = rP1
 		rc += crypto_scalarmult_ristretto255_base(tmp->U,nonce);
 		rc += crypto_scalarmult_ristretto255( tmp->V, nonce, key->pub->P1);
-		if( rc != 0 ){ //abort if fail
-			*out = NULL; return;
-		}
-
-		tmp->x = hashexec(mbuffer, mlen,tmp->U, tmp->V);
+		return rc;
+	}
 
+	//response once x is known
+	static void sigrespond(struct seckey *key, struct signat *tmp, const unsigned char *nonce){
 		// s = r + xa
 		crypto_core_ristretto255_scalar_mul( tmp->s , tmp->x, key->a );
 		crypto_core_ristretto255_scalar_add( tmp->s, tmp->s, nonce );
+	}
+
+	void signatini(void *vkey, struct sigstream *ss){
+		struct seckey *key = (struct seckey *)vkey; //recast key
+		hashpre(&ss->pre, NULL, 0);
+		signonce(key, &ss->nc);
+	}
+
+	void signatfin(void *vkey, struct sigstream *ss, void **out){
+		//declare and allocate for signature struct, nonce
+		struct seckey *key = (struct seckey *)vkey; //recast key
+		struct signat *tmp = (struct signat *)malloc(sizeof(struct signat));
+		unsigned char nonce[RS_SCSZ];
+
+		//-------------------------------------TODO START EDIT
+		if( sigcommit(key, tmp, nonce, &ss->nc) != 0 ){ //abort if fail
+			sigdestroy(tmp);
+			*out = NULL; return;
+		}
+
+		hashfrom(tmp->x, &ss->pre, tmp->U, tmp->V);
+
+		sigrespond(key, tmp, nonce);
+		sodium_memzero(nonce, RS_SCSZ);
 
 		//-------------------------------------TODO END EDIT
 		*out = (void *) tmp; return;
 	}
 
-	int signatchk(
-		void *vpar,
-		void *vsig,
-		const unsigned char *mbuffer, size_t mlen
+	void signatgen(
+		void *vkey,
+		const unsigned char *mbuffer, size_t mlen,
+		void **out
 	){
-		//key recast
-		struct pubkey *par = (struct pubkey *)vpar;
-		struct signat *sig = (struct signat *)vsig;
-		int rc;
+		struct sigstream ss;
+		signatini(vkey, &ss);
+		sigabsorb(&ss, mbuffer, mlen);
+		signatfin(vkey, &ss, out);
+	}
 
-		//-------------------------------------TODO START EDIT
+	void signatgenv(
+		void *vkey, size_t n,
+		const unsigned char *const *mbuffer, const size_t *mlen,
+		void **out
+	){
+		struct seckey *key = (struct seckey *)vkey; //recast key
+		struct signat *tmp[SHA512MB_LANES];
+		unsigned char nonce[SHA512MB_LANES][RS_SCSZ];
+		unsigned char *x[SHA512MB_LANES];
+		const unsigned char *u[SHA512MB_LANES], *v[SHA512MB_LANES];
+		int rc[SHA512MB_LANES];
+		struct nonce::stream nc;
+		size_t i, k, c;
+
+		for(i = 0; i < n; i += c){
+			c = n - i < SHA512MB_LANES ? n - i : SHA512MB_LANES;
+			for(k = 0; k < c; k++){
+				tmp[k] = (struct signat *)malloc(sizeof(struct signat));
+				signonce(key, &nc);
+				nonce::update(&nc, mbuffer[i+k], mlen[i+k]);
+				rc[k] = sigcommit(key, tmp[k], nonce[k], &nc);
+				x[k] = tmp[k]->x; u[k] = tmp[k]->U; v[k] = tmp[k]->V;
+			}
+			//the challenges of the group in one pass
+			hashexecv(x, mbuffer+i, mlen+i, u, v, c);
+			for(k = 0; k < c; k++){
+				sigrespond(key, tmp[k], nonce[k]);
+				if( rc[k] != 0 ){ sigdestroy(tmp[k]); tmp[k] = NULL; }
+				out[i+k] = (void *) tmp[k];
+			}
+		}
+		sodium_memzero(nonce, sizeof(nonce));
+	}
+
+	//U' = sB - xP1, V' = sP1 - xP2, the commitment a signature implies
+	static int chkcommit(struct pubkey *par, struct signat *sig, unsigned char *u, unsigned char *v){
 		unsigned char tmp1[RS_EPSZ]; //tmp array
 		unsigned char tmp2[RS_EPSZ]; //tmp array
-		unsigned char tmp3[RS_EPSZ]; //tmp array
-		unsigned char *xp;
+		int rc = 0;
 
 		// U' = sB - xP1
-		rc = 0;
 		rc += crypto_scalarmult_ristretto255_base(tmp1,sig->s);
 		rc += crypto_scalarmult_ristretto255(tmp2,sig->x,par->P1);
-		rc += crypto_core_ristretto255_sub( tmp3, tmp1, tmp2 ); //tmp3 U'
+		rc += crypto_core_ristretto255_sub( u, tmp1, tmp2 );
 
 		// V' = sP1 - xP2
 		rc += crypto_scalarmult_ristretto255(tmp1,sig->s,par->P1);
 		rc += crypto_scalarmult_ristretto255(tmp2,sig->x,par->P2);
-		rc += crypto_core_ristretto255_sub( tmp2, tmp1, tmp2 ); //tmp4 V'
+		rc += crypto_core_ristretto255_sub( v, tmp1, tmp2 );
+		return rc;
+	}
+
+	int signatchkp(void *vpar, void *vsig, const struct sigstream *ss){
+		//key recast
+		struct pubkey *par = (struct pubkey *)vpar;
+		struct signat *sig = (struct signat *)vsig;
+		int rc;
+
+		//-------------------------------------TODO START EDIT
+		unsigned char tmp2[RS_EPSZ]; //tmp array
+		unsigned char tmp3[RS_EPSZ]; //tmp array
+		unsigned char xp[RS_SCSZ];
+
+		rc = chkcommit(par, sig, tmp3, tmp2); //tmp3 U', tmp2 V'
 		if( rc != 0 ) return rc; //abort if fail
 
-		xp = hashexec(mbuffer, mlen, tmp3, tmp2);
+		hashfrom(xp, &ss->pre, tmp3, tmp2);
 
 		//check if tmp is equal to x from obuffer
 		rc = crypto_verify_32( xp, sig->x );
@@ -180,36 +254,111 @@ namespace tnc25519{
 		printf("V':"); ucbprint(tmp2, RS_EPSZ); printf("\n");
 #endif
 		//free any allocated stuff
-		hashfree(xp);
+		sodium_memzero(xp, RS_SCSZ);
 
 		//-------------------------------------TODO START EDIT
 		return rc;
 	}
 
-	unsigned char *hashexec(
+	int signatchk(
+		void *vpar,
+		void *vsig,
+		const unsigned char *mbuffer, size_t mlen
+	){
+		struct sigstream ss;
+		hashpre(&ss.pre, mbuffer, mlen);
+		return signatchkp(vpar, vsig, &ss);
+	}
+
+	void signatchkv(
+		void *vpar, size_t n,
+		void *const *vsig,
+		const unsigned char *const *mbuffer, const size_t *mlen,
+		int *rc
+	){
+		struct pubkey *par = (struct pubkey *)vpar;
+		unsigned char uv[SHA512MB_LANES][2*RS_EPSZ];
+		unsigned char xp[SHA512MB_LANES][RS_SCSZ];
+		unsigned char *x[SHA512MB_LANES];
+		const unsigned char *u[SHA512MB_LANES], *v[SHA512MB_LANES];
+		size_t i, k, c;
+
+		for(i = 0; i < n; i += c){
+			c = n - i < SHA512MB_LANES ? n - i : SHA512MB_LANES;
+			for(k = 0; k < c; k++){
+				rc[i+k] = chkcommit(par, (struct signat *)vsig[i+k], uv[k], uv[k]+RS_EPSZ);
+				x[k] = xp[k]; u[k] = uv[k]; v[k] = uv[k]+RS_EPSZ;
+			}
+			hashexecv(x, mbuffer+i, mlen+i, u, v, c);
+			for(k = 0; k < c; k++){
+				if( rc[i+k] != 0 ) continue;
+				rc[i+k] = crypto_verify_32( xp[k], ((struct signat *)vsig[i+k])->x );
+			}
+		}
+		sodium_memzero(xp, sizeof(xp));
+	}
+
+	void hashexec(
+		unsigned char *out,
 		const unsigned char *mbuffer, size_t mlen,
-		unsigned char *ubuffer,
-		unsigned char *vbuffer
+		const unsigned char *ubuffer,
+		const unsigned char *vbuffer
 	){
-		crypto_hash_sha512_state eh_state;
+		crypto_hash_sha512_state pre;
+		hashpre( &pre, mbuffer, mlen);
+		hashfrom( out, &pre, ubuffer, vbuffer);
+	}
+
+	void hashpre(crypto_hash_sha512_state *pre, const unsigned char *mbuffer, size_t mlen){
+		crypto_hash_sha512_init( pre );
+		crypto_hash_sha512_update( pre, mbuffer, mlen);
+	}
+
+	void hashfrom(
+		unsigned char *out,
+		const crypto_hash_sha512_state *pre,
+		const unsigned char *ubuffer,
+		const unsigned char *vbuffer
+	){
+		crypto_hash_sha512_state eh_state = *pre; //the midstate is reused
 		unsigned char hshe[RS_HSSZ]; //hash
-		unsigned char *out = (unsigned char *)malloc( RS_SCSZ );
 
 		//compute hash
-		crypto_hash_sha512_init( &eh_state );
-		crypto_hash_sha512_update( &eh_state, mbuffer, mlen);
 		crypto_hash_sha512_update( &eh_state, ubuffer, RS_EPSZ);
 		crypto_hash_sha512_update( &eh_state, vbuffer, RS_EPSZ);
 		crypto_hash_sha512_final( &eh_state, hshe);
 		crypto_core_ristretto255_scalar_reduce(
 			out, (const unsigned char *)hshe
 		);
-		return out;
 	}
 
-	void hashfree(unsigned char *hash){
-		sodium_memzero(hash, RS_SCSZ);
-		free(hash); return;
+	void hashexecv(
+		unsigned char *const *out,
+		const unsigned char *const *mbuffer, const size_t *mlen,
+		const unsigned char *const *ubuffer,
+		const unsigned char *const *vbuffer,
+		size_t n
+	){
+		struct sha512mb_msg msg[SHA512MB_LANES];
+		unsigned char hshe[SHA512MB_LANES][RS_HSSZ]; //hashes
+		size_t i, k, c;
+
+		for(i = 0; i < n; i += c){
+			c = n - i < SHA512MB_LANES ? n - i : SHA512MB_LANES;
+			for(k = 0; k < c; k++){
+				msg[k].part[0] = mbuffer[i+k]; msg[k].plen[0] = mlen[i+k];
+				msg[k].part[1] = ubuffer[i+k]; msg[k].plen[1] = RS_EPSZ;
+				msg[k].part[2] = vbuffer[i+k]; msg[k].plen[2] = RS_EPSZ;
+				msg[k].nparts = 3;
+				msg[k].out = hshe[k];
+			}
+			sha512mb(msg, c);
+			for(k = 0; k < c; k++){
+				crypto_core_ristretto255_scalar_reduce(
+					out[i+k], (const unsigned char *)hshe[k]
+				);
+			}
+		}
 	}
 
 	size_t secserial(void *in, unsigned char **sbuffer, size_t *slen){
@@ -305,6 +454,31 @@ namespace tnc25519{
 		*out = (void *) tmp; return;
 	}
 
+	static_assert( sizeof(struct pubkey) <= sizeof(struct kview), "view storage" );
+	static_assert( sizeof(struct signat) <= sizeof(struct kview), "view storage" );
+
+	int pubview(const unsigned char *pbuffer, size_t plen, struct kview *view){
+		struct pubkey *tmp;
+		if( pbuffer == NULL || plen != PKEY_SZ ) return 1;
+		//the struct lives in the view, its components in the buffer
+		tmp = new (view->b) pubkey;
+		tmp->P1 = (unsigned char *)pbuffer;
+		tmp->P2 = (unsigned char *)pbuffer + RS_EPSZ;
+		return 0;
+	}
+
+	int sigview(const unsigned char *obuffer, size_t olen, struct kview *view){
+		struct signat *tmp;
+		if( obuffer == NULL || olen != SGNT_SZ ) return 1;
+		//the struct lives in the view, its components in the buffer
+		tmp = new (view->b) signat;
+		tmp->s = (unsigned char *)obuffer;
+		tmp->x = (unsigned char *)obuffer + RS_SCSZ;
+		tmp->U = (unsigned char *)obuffer + 2*RS_SCSZ;
+		tmp->V = (unsigned char *)obuffer + 2*RS_SCSZ + RS_EPSZ;
+		return 0;
+	}
+
 	//destroy secret key
 	void secdestroy(void *in){
 		//key recast
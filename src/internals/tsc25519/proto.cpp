@@ -38,11 +38,14 @@
 // include general prototype and macro
 #include "../proto.hpp"
 #include "../cmacro.h"
+#include "../rng.hpp"
+#include "../ifcall.hpp"
 
 //mini socket library
 #include "../../utils/bufhelp.h"
 #include "../../utils/debug.h"
 #include "../../utils/simplesock.h"
+#include "../../utils/usdt.h"
 
 // implementation includes (archlinux os stored under /usr/include/sodium)
 //Nacl Finite Field Arithmetic on top of Curve25519
@@ -71,7 +74,7 @@ namespace tsc25519{
 		unsigned char buf[TS_MAXSZ] = {0};
 
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(t);
+		rng::scalar(t);
 
 		//--------------------------------------------------------
 		//--------------COMPUTE AND SEND COMMIT
@@ -79,13 +82,16 @@ namespace tsc25519{
 		// T = tB
 		memcpy( buf, usk->U, RS_EPSZ);
 		memcpy( buf+RS_EPSZ, usk->V, RS_EPSZ);
+		probe_crypt_start(A25519_TSCHNORR, sock, USDT_PROVER);
 		rc = crypto_scalarmult_ristretto255_base( buf+2*RS_EPSZ, t);
+		probe_crypt_done(A25519_TSCHNORR, sock, USDT_PROVER);
 		if( rc != 0 ){
 			//abort if fail
 			lerror("Failed to compute COMMIT\n");
 			return 1;
 		}
 		sendbuf( sock, (char *)buf , 3*RS_EPSZ); //send CMT
+		probe_move_send(A25519_TSCHNORR, sock, USDT_PROVER, 3*RS_EPSZ);
 
 		//--------------------------------------------------------
 		//--------------RECEIVE CHALLENGE
@@ -95,6 +101,7 @@ namespace tsc25519{
 			lerror("Failed to recv CHALLENGE from verifier\n");
 			return 1;
 		}
+		probe_move_recv(A25519_TSCHNORR, sock, USDT_PROVER, RS_SCSZ);
 
 		//--------------COMPUTE AND SEND RESPONSE
 		// y = t + cs
@@ -113,6 +120,7 @@ namespace tsc25519{
 		memset(t, 0, RS_SCSZ); //zero t
 		memset(buf, 0, 3*RS_EPSZ); //zero U,V and T
 		sendbuf(sock, (char *)y , RS_SCSZ);
+		probe_move_send(A25519_TSCHNORR, sock, USDT_PROVER, RS_SCSZ);
 
 		buf[0] = 0x01;
 		rc = fixed_recvbuf(sock, (char *)buf, 1); //receive final result
@@ -120,6 +128,7 @@ namespace tsc25519{
 			lerror("Failed to recv RESULT from verifier\n");
 			return 1;
 		}
+		probe_move_recv(A25519_TSCHNORR, sock, USDT_PROVER, 1);
 		debug("Received: %02X\n",buf[0]);
 		//--------------------------TODO END
 
@@ -137,7 +146,7 @@ namespace tsc25519{
 		int rc;
 
 		//--------------------------TODO START
-		unsigned char c[RS_SCSZ], y[RS_SCSZ], *xp;
+		unsigned char c[RS_SCSZ], y[RS_SCSZ], xp[RS_SCSZ];
 		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ];
 		unsigned char tmp1[RS_EPSZ], tmp2[RS_EPSZ];
 		unsigned char buf[TS_MAXSZ] = {0};
@@ -150,12 +159,14 @@ namespace tsc25519{
 			lerror("Failed to recv COMMIT from prover\n");
 			return 1;
 		}
+		probe_move_recv(A25519_TSCHNORR, sock, USDT_VERIFIER, 3*RS_EPSZ);
 
 		//--------------------------------------------------------
 		//---------------------SEND THE CHALLENGE
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(c);
+		rng::scalar(c);
 		sendbuf(sock, (char *)c , RS_SCSZ);
+		probe_move_send(A25519_TSCHNORR, sock, USDT_VERIFIER, RS_SCSZ);
 		memset(y, 0, RS_SCSZ);
 		//--------------------------------------------------------
 		//---------------------RECEIVE RESPONSE
@@ -164,9 +175,11 @@ namespace tsc25519{
 			lerror("Failed to recv RESPONSE from prover\n");
 			return 1;
 		}
+		probe_move_recv(A25519_TSCHNORR, sock, USDT_VERIFIER, RS_SCSZ);
 
+		probe_crypt_start(A25519_TSCHNORR, sock, USDT_VERIFIER);
 		//hash
-		xp = hashexec(mbuffer, mlen, buf, (buf+RS_EPSZ), par->P1, par->P2 );
+		hashexec(xp, mbuffer, mlen, buf, (buf+RS_EPSZ), par->P1, par->P2 );
 
 #ifdef DEBUG
 pubprint(par);
@@ -180,13 +193,14 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 
 		// yB = T + c( U' - xP1 )
 		rc = crypto_scalarmult_ristretto255( tmp1, xp, par->P1); // xP1
-		//zero and free
-		hashfree(xp);
+		//zero
+		sodium_memzero(xp, RS_SCSZ);
 		rc = 0;
 		rc += crypto_scalarmult_ristretto255_base( LHS, y); // yB
 		rc += crypto_core_ristretto255_sub( tmp2, buf, tmp1); // U' - xP1
 		rc += crypto_scalarmult_ristretto255( tmp1, c, tmp2); // c( U' - xP1 )
 		rc += crypto_core_ristretto255_add( RHS, tmp1, buf+2*RS_EPSZ);// T + c(U' - xP1)
+		probe_crypt_done(A25519_TSCHNORR, sock, USDT_VERIFIER);
 		if( rc != 0 ) return rc; //abort if fail
 
 		//check if tmp is equal to x from obuffer
@@ -197,6 +211,7 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 			buf[0] = 0x01;
 		}
 		sendbuf(sock, (char *)buf , 1); //send back the results
+		probe_move_send(A25519_TSCHNORR, sock, USDT_VERIFIER, 1);
 		debug("Replied: %02X\n",buf[0]);
 		//--------------------------TODO END
 
@@ -217,19 +232,19 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 
 		//--------------------------TODO START
 		unsigned char tmp[RS_EPSZ];
-		unsigned char t[RS_SCSZ], c[RS_SCSZ], y[RS_SCSZ], *xp;
+		unsigned char t[RS_SCSZ], c[RS_SCSZ], y[RS_SCSZ], xp[RS_SCSZ];
 		unsigned char tmp1[RS_EPSZ], LHS[RS_EPSZ], RHS[RS_EPSZ], tmp2[RS_EPSZ];
 
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(t);
+		rng::scalar(t);
 		//sample c (challenge)
-		crypto_core_ristretto255_scalar_random(c);
+		rng::scalar(c);
 
 		//compute response
 		crypto_core_ristretto255_scalar_mul( tmp , c, usk->s ); //
 		crypto_core_ristretto255_scalar_add( y, tmp, t ); // y = t + cs
 
-		xp = hashexec(mbuffer, mlen, usk->U, usk->V, par->P1, par->P2);
+		hashexec(xp, mbuffer, mlen, usk->U, usk->V, par->P1, par->P2);
 
 		//T = tB
 		rc = 0;
@@ -246,10 +261,160 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 		//check LHS == RHS
 		rc = crypto_verify_32( LHS, RHS );
 
-		hashfree(xp);
+		sodium_memzero(xp, RS_SCSZ);
 		//--------------------------TODO END
 
 		return rc;
 	}
 
+
+	//verifier session state for the sans-io core
+	struct vrfctx{
+		int stage;
+		struct pubkey *par;
+		const unsigned char *mbuffer; size_t mlen;
+		unsigned char c[RS_SCSZ];
+		unsigned char cmt[3*RS_EPSZ];
+	};
+
+	int vrfinit(
+		void *vpar,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	){
+		struct vrfctx *tmp = (struct vrfctx *)malloc(sizeof(struct vrfctx));
+		tmp->stage = 0;
+		tmp->par = (struct pubkey *)vpar;
+		tmp->mbuffer = mbuffer;
+		tmp->mlen = mlen;
+
+		//first move is the COMMIT from the prover
+		//CMT <- U',V' T
+		ps->need = 3*RS_EPSZ;
+		ps->heavy = 0;
+		*out = (void *)tmp; return 0;
+	}
+
+	int vrfstep(void *vctx, struct pstep *ps){
+		struct vrfctx *ctx = (struct vrfctx *)vctx;
+		unsigned char xp[RS_SCSZ];
+		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ];
+		unsigned char tmp1[RS_EPSZ], tmp2[RS_EPSZ];
+		int rc;
+
+		if(ctx->stage++ == 0){
+			//--------------------------------------------------------
+			//---------------------RECEIVE COMMIT, SEND THE CHALLENGE
+			memcpy( ctx->cmt, ps->in, 3*RS_EPSZ);
+			rng::scalar(ctx->c);
+			memcpy( ps->out, ctx->c, RS_SCSZ);
+			ps->olen = RS_SCSZ;
+			ps->need = RS_SCSZ;
+			ps->heavy = 1;
+			return PS_CONT;
+		}
+
+		//--------------------------------------------------------
+		//---------------------RECEIVE RESPONSE, SEND THE RESULT
+		hashexec(xp, ctx->mbuffer, ctx->mlen, ctx->cmt, ctx->cmt+RS_EPSZ,
+				ctx->par->P1, ctx->par->P2);
+
+		// yB = T + c( U' - xP1 )
+		rc = 0;
+		rc += crypto_scalarmult_ristretto255( tmp1, xp, ctx->par->P1); // xP1
+		sodium_memzero(xp, RS_SCSZ);
+		rc += crypto_scalarmult_ristretto255_base( LHS, ps->in); // yB
+		rc += crypto_core_ristretto255_sub( tmp2, ctx->cmt, tmp1); // U' - xP1
+		rc += crypto_scalarmult_ristretto255( tmp1, ctx->c, tmp2); // c( U' - xP1 )
+		rc += crypto_core_ristretto255_add( RHS, tmp1, ctx->cmt+2*RS_EPSZ);// T + c(U' - xP1)
+
+		rc += crypto_verify_32( LHS, RHS );
+		ps->out[0] = rc == 0 ? 0x00 : 0x01;
+		ps->olen = 1;
+		ps->need = 0;
+		ps->heavy = 0;
+		ps->rc = rc;
+		debug("Replied: %02X\n",ps->out[0]);
+		return PS_DONE;
+	}
+
+	void vrffree(void *vctx){
+		sodium_memzero(vctx, sizeof(struct vrfctx));
+		free(vctx); return;
+	}
+
+	//prover session state for the sans-io core
+	struct prvctx{
+		int stage;
+		struct signat *usk;
+		unsigned char t[RS_SCSZ];
+	};
+
+	int prvinit(
+		void *vusk,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	){
+		struct prvctx *tmp = (struct prvctx *)malloc(sizeof(struct prvctx));
+		tmp->stage = 0;
+		tmp->usk = (struct signat *)vusk;
+
+		//prover moves first with the COMMIT
+		ps->need = 0;
+		ps->heavy = 1;
+		*out = (void *)tmp; return 0;
+	}
+
+	int prvstep(void *vctx, struct pstep *ps){
+		struct prvctx *ctx = (struct prvctx *)vctx;
+		int rc;
+
+		switch(ctx->stage++){
+		case 0:
+			//--------------------------------------------------------
+			//--------------COMPUTE AND SEND COMMIT
+			//CMT <- U',V' T
+			// T = tB
+			rng::scalar(ctx->t);
+			memcpy( ps->out, ctx->usk->U, RS_EPSZ);
+			memcpy( ps->out+RS_EPSZ, ctx->usk->V, RS_EPSZ);
+			rc = crypto_scalarmult_ristretto255_base( ps->out+2*RS_EPSZ, ctx->t);
+			if( rc != 0 ){
+				lerror("Failed to compute COMMIT\n");
+				ps->olen = 0; ps->rc = 1;
+				return PS_DONE;
+			}
+			ps->olen = 3*RS_EPSZ;
+			ps->need = RS_SCSZ;
+			ps->heavy = 0;
+			return PS_CONT;
+		case 1:
+			//--------------------------------------------------------
+			//--------------RECEIVE CHALLENGE, SEND RESPONSE
+			// y = t + cs
+			crypto_core_ristretto255_scalar_mul( ps->out, ps->in, ctx->usk->s );
+			crypto_core_ristretto255_scalar_add( ps->out, ps->out, ctx->t );
+			//PREVENT RESET ATTACKS, clear the commit
+			sodium_memzero(ctx->t, RS_SCSZ);
+			ps->olen = RS_SCSZ;
+			ps->need = 1;
+			ps->heavy = 0;
+			return PS_CONT;
+		default:
+			//--------------------------------------------------------
+			//--------------RECEIVE RESULT
+			debug("Received: %02X\n",ps->in[0]);
+			ps->olen = 0;
+			ps->need = 0;
+			ps->rc = (int)ps->in[0];
+			return PS_DONE;
+		}
+	}
+
+	void prvfree(void *vctx){
+		sodium_memzero(vctx, sizeof(struct prvctx));
+		free(vctx); return;
+	}
 }
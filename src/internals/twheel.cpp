@@ -0,0 +1,98 @@
+/*
+ * internals/twheel.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Hashed timer wheel
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "twheel.hpp"
+
+namespace twheel{
+
+	void init(struct wheel *w, unsigned int tick, uint64_t now){
+		size_t i;
+		for(i=0;i<TW_SLOTS;i++){
+			w->slot[i].prev = &w->slot[i];
+			w->slot[i].next = &w->slot[i];
+		}
+		w->tick = tick > 0 ? tick : 1;
+		w->now = now / w->tick;
+		w->count = 0;
+	}
+
+	void node(struct tnode *n){
+		n->prev = NULL;
+		n->next = NULL;
+		n->expire = 0;
+	}
+
+	void disarm(struct wheel *w, struct tnode *n){
+		if(n->next == NULL) return;
+		n->prev->next = n->next;
+		n->next->prev = n->prev;
+		n->prev = NULL;
+		n->next = NULL;
+		w->count--;
+	}
+
+	void arm(struct wheel *w, struct tnode *n, unsigned int ms){
+		struct tnode *head;
+		uint64_t ticks = (ms + w->tick - 1) / w->tick;
+		disarm(w, n);
+		n->expire = w->now + (ticks > 0 ? ticks : 1);
+		//deadlines beyond one revolution stay in their slot for several passes
+		head = &w->slot[n->expire & (TW_SLOTS - 1)];
+		n->next = head->next;
+		n->prev = head;
+		head->next->prev = n;
+		head->next = n;
+		w->count++;
+	}
+
+	void advance(
+		struct wheel *w, uint64_t now,
+		void (*fire)(struct tnode *, void *), void *arg
+	){
+		struct tnode *head, *n, *nx;
+		uint64_t target = now / w->tick;
+		while(w->now < target){
+			w->now++;
+			if(w->count == 0){
+				w->now = target;
+				break;
+			}
+			head = &w->slot[w->now & (TW_SLOTS - 1)];
+			for(n = head->next; n != head; n = nx){
+				nx = n->next;
+				if(n->expire > w->now) continue;
+				disarm(w, n);
+				fire(n, arg);
+			}
+		}
+	}
+}
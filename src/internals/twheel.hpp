@@ -0,0 +1,79 @@
+/*
+ * internals/twheel.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Hashed timer wheel for session deadlines, nodes are intrusive
+ * and arming/disarming is O(1). Single threaded (event loop only).
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _TWHEEL_HPP_
+#define _TWHEEL_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TW_SLOTS 256 //power of 2
+
+namespace twheel{
+
+	//embed in the object that owns the deadline
+	struct tnode{
+		struct tnode *prev, *next;
+		uint64_t expire; //tick
+	};
+
+	struct wheel{
+		struct tnode slot[TW_SLOTS];
+		uint64_t now; //current tick
+		unsigned int tick; //tick length (ms)
+		size_t count; //armed nodes
+	};
+
+	//initialize the wheel at time now (ms)
+	void init(struct wheel *w, unsigned int tick, uint64_t now);
+
+	//initialize a node (disarmed)
+	void node(struct tnode *n);
+
+	//(re)arm a node to fire in ms milliseconds
+	void arm(struct wheel *w, struct tnode *n, unsigned int ms);
+
+	//disarm a node, no-op if not armed
+	void disarm(struct wheel *w, struct tnode *n);
+
+	//advance the wheel to time now (ms), calling fire on every expired node
+	//(expired nodes are disarmed before fire is called)
+	void advance(
+		struct wheel *w, uint64_t now,
+		void (*fire)(struct tnode *, void *), void *arg
+	);
+}
+
+#endif
@@ -38,11 +38,14 @@
 // include general prototype and macro
 #include "../proto.hpp"
 #include "../cmacro.h"
+#include "../rng.hpp"
+#include "../ifcall.hpp"
 
 //mini socket library
 #include "../../utils/bufhelp.h"
 #include "../../utils/debug.h"
 #include "../../utils/simplesock.h"
+#include "../../utils/usdt.h"
 
 // implementation includes (archlinux os stored under /usr/include/sodium)
 //Nacl Finite Field Arithmetic on top of Curve25519
@@ -71,17 +74,19 @@ namespace twn25519{
 		unsigned char buf[TS_MAXSZ] = {0};
 
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(t1);
-		crypto_core_ristretto255_scalar_random(t2);
+		rng::scalar(t1);
+		rng::scalar(t2);
 
 		//--------------------------------------------------------
 		//--------------COMPUTE AND SEND COMMIT
 		//CMT <- U',V' T
 		// T = tB
+		probe_crypt_start(A25519_TWINSCHNORR, sock, USDT_PROVER);
 		rc = 0;
 		rc += crypto_scalarmult_ristretto255_base( tb1, t1);
 		rc += crypto_scalarmult_ristretto255( tb2, t2, usk->B2);
 		rc += crypto_core_ristretto255_add( buf, tb1, tb2);
+		probe_crypt_done(A25519_TWINSCHNORR, sock, USDT_PROVER);
 		if( rc != 0 ){
 			//abort if fail
 			lerror("Failed to compute COMMIT\n");
@@ -89,6 +94,7 @@ namespace twn25519{
 		}
 		memcpy( buf+RS_EPSZ, usk->U, RS_EPSZ);
 		sendbuf( sock, (char *)buf , 2*RS_EPSZ); //send CMT
+		probe_move_send(A25519_TWINSCHNORR, sock, USDT_PROVER, 2*RS_EPSZ);
 
 		//--------------------------------------------------------
 		//--------------RECEIVE CHALLENGE
@@ -98,6 +104,7 @@ namespace twn25519{
 			lerror("Failed to recv CHALLENGE from verifier\n");
 			return 1;
 		}
+		probe_move_recv(A25519_TWINSCHNORR, sock, USDT_PROVER, RS_SCSZ);
 
 		//--------------COMPUTE AND SEND RESPONSE
 		// y = t + cs
@@ -123,6 +130,7 @@ namespace twn25519{
 		memset(tb2, 0, RS_EPSZ); //zero tb2
 		memset(buf, 0, TS_MAXSZ); //zero the buffer
 		sendbuf(sock, (char *)y , 2*RS_SCSZ);
+		probe_move_send(A25519_TWINSCHNORR, sock, USDT_PROVER, 2*RS_SCSZ);
 
 		buf[0] = 0x01;
 		rc = fixed_recvbuf(sock, (char *)buf, 1); //receive final result
@@ -130,6 +138,7 @@ namespace twn25519{
 			lerror("Failed to recv RESULT from verifier\n");
 			return 1;
 		}
+		probe_move_recv(A25519_TWINSCHNORR, sock, USDT_PROVER, 1);
 		debug("Received: %02X\n",buf[0]);
 		//--------------------------TODO END
 
@@ -147,7 +156,7 @@ namespace twn25519{
 		int rc;
 
 		//--------------------------TODO START
-		unsigned char c[RS_SCSZ], y[2*RS_SCSZ], *xp;
+		unsigned char c[RS_SCSZ], y[2*RS_SCSZ], xp[RS_SCSZ];
 		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ];
 		unsigned char tmp1[RS_EPSZ], tmp2[RS_EPSZ];
 		unsigned char buf[TS_MAXSZ] = {0};
@@ -160,12 +169,14 @@ namespace twn25519{
 			lerror("Failed to recv COMMIT from prover\n");
 			return 1;
 		}
+		probe_move_recv(A25519_TWINSCHNORR, sock, USDT_VERIFIER, 2*RS_EPSZ);
 
 		//--------------------------------------------------------
 		//---------------------SEND THE CHALLENGE
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(c);
+		rng::scalar(c);
 		sendbuf(sock, (char *)c , RS_SCSZ);
+		probe_move_send(A25519_TWINSCHNORR, sock, USDT_VERIFIER, RS_SCSZ);
 		memset(y, 0, 2*RS_SCSZ);
 		//--------------------------------------------------------
 		//---------------------RECEIVE RESPONSE
@@ -174,9 +185,11 @@ namespace twn25519{
 			lerror("Failed to recv RESPONSE from prover\n");
 			return 1;
 		}
+		probe_move_recv(A25519_TWINSCHNORR, sock, USDT_VERIFIER, 2*RS_SCSZ);
 
+		probe_crypt_start(A25519_TWINSCHNORR, sock, USDT_VERIFIER);
 		//hash
-		xp = hashexec(mbuffer, mlen, buf+RS_EPSZ, par->P);
+		hashexec(xp, mbuffer, mlen, buf+RS_EPSZ, par->P);
 
 #ifdef DEBUG
 pubprint(par);
@@ -191,8 +204,8 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 		// yB = T + c( U' - xP1 )
 		rc = 0;
 		rc += crypto_scalarmult_ristretto255( tmp1, xp, par->P); // xP1
-		//zero and free
-		hashfree(xp);
+		//zero
+		sodium_memzero(xp, RS_SCSZ);
 
 		rc += crypto_scalarmult_ristretto255_base( LHS, y);
 		rc += crypto_scalarmult_ristretto255( tmp2, y+RS_SCSZ, par->B2);
@@ -201,6 +214,7 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 		rc += crypto_core_ristretto255_sub( tmp2, buf+RS_EPSZ, tmp1); // U' - xP
 		rc += crypto_scalarmult_ristretto255( tmp1, c, tmp2); // c( U' - xP )
 		rc += crypto_core_ristretto255_add( RHS, tmp1, buf);// T + c(U' - xP)
+		probe_crypt_done(A25519_TWINSCHNORR, sock, USDT_VERIFIER);
 		if( rc != 0 ) return rc; //abort if fail
 
 		//check if tmp is equal to x from obuffer
@@ -211,6 +225,7 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 			buf[0] = 0x01;
 		}
 		sendbuf(sock, (char *)buf , 1); //send back the results
+		probe_move_send(A25519_TWINSCHNORR, sock, USDT_VERIFIER, 1);
 		debug("Replied: %02X\n",buf[0]);
 		//--------------------------TODO END
 
@@ -231,14 +246,14 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 
 		//--------------------------TODO START
 		unsigned char tmp[RS_EPSZ];
-		unsigned char t1[RS_SCSZ], t2[RS_SCSZ], c[RS_SCSZ], y[2*RS_SCSZ], *xp;
+		unsigned char t1[RS_SCSZ], t2[RS_SCSZ], c[RS_SCSZ], y[2*RS_SCSZ], xp[RS_SCSZ];
 		unsigned char tmp1[RS_EPSZ], LHS[RS_EPSZ], RHS[RS_EPSZ], tmp2[RS_EPSZ];
 
 		//sample t (commit secret)
-		crypto_core_ristretto255_scalar_random(t1);
-		crypto_core_ristretto255_scalar_random(t2);
+		rng::scalar(t1);
+		rng::scalar(t2);
 		//sample c (challenge)
-		crypto_core_ristretto255_scalar_random(c);
+		rng::scalar(c);
 
 		//compute response
 		crypto_core_ristretto255_scalar_mul( y , c, usk->s1 );
@@ -246,7 +261,7 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 		crypto_core_ristretto255_scalar_mul( y+RS_SCSZ , c, usk->s2 );
 		crypto_core_ristretto255_scalar_add( y+RS_SCSZ, y+RS_SCSZ, t2 );
 
-		xp = hashexec(mbuffer, mlen, usk->U, par->P);
+		hashexec(xp, mbuffer, mlen, usk->U, par->P);
 
 		//T = tB
 		rc = 0;
@@ -267,9 +282,170 @@ printf("x':"); ucbprint( xp, RS_SCSZ ); printf("\n");
 		//check LHS == RHS
 		rc = crypto_verify_32( LHS, RHS );
 
-		hashfree(xp);
+		sodium_memzero(xp, RS_SCSZ);
 
 		return rc;
 	}
 
+
+	//verifier session state for the sans-io core
+	struct vrfctx{
+		int stage;
+		struct pubkey *par;
+		const unsigned char *mbuffer; size_t mlen;
+		unsigned char c[RS_SCSZ];
+		unsigned char cmt[2*RS_EPSZ];
+	};
+
+	int vrfinit(
+		void *vpar,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	){
+		struct vrfctx *tmp = (struct vrfctx *)malloc(sizeof(struct vrfctx));
+		tmp->stage = 0;
+		tmp->par = (struct pubkey *)vpar;
+		tmp->mbuffer = mbuffer;
+		tmp->mlen = mlen;
+
+		//first move is the COMMIT from the prover
+		//CMT <- T, U'
+		ps->need = 2*RS_EPSZ;
+		ps->heavy = 0;
+		*out = (void *)tmp; return 0;
+	}
+
+	int vrfstep(void *vctx, struct pstep *ps){
+		struct vrfctx *ctx = (struct vrfctx *)vctx;
+		unsigned char xp[RS_SCSZ];
+		unsigned char LHS[RS_EPSZ], RHS[RS_EPSZ];
+		unsigned char tmp1[RS_EPSZ], tmp2[RS_EPSZ];
+		int rc;
+
+		if(ctx->stage++ == 0){
+			//--------------------------------------------------------
+			//---------------------RECEIVE COMMIT, SEND THE CHALLENGE
+			memcpy( ctx->cmt, ps->in, 2*RS_EPSZ);
+			rng::scalar(ctx->c);
+			memcpy( ps->out, ctx->c, RS_SCSZ);
+			ps->olen = RS_SCSZ;
+			ps->need = 2*RS_SCSZ;
+			ps->heavy = 1;
+			return PS_CONT;
+		}
+
+		//--------------------------------------------------------
+		//---------------------RECEIVE RESPONSE, SEND THE RESULT
+		hashexec(xp, ctx->mbuffer, ctx->mlen, ctx->cmt+RS_EPSZ, ctx->par->P);
+
+		rc = 0;
+		rc += crypto_scalarmult_ristretto255( tmp1, xp, ctx->par->P); // xP1
+		sodium_memzero(xp, RS_SCSZ);
+
+		rc += crypto_scalarmult_ristretto255_base( LHS, ps->in);
+		rc += crypto_scalarmult_ristretto255( tmp2, ps->in+RS_SCSZ, ctx->par->B2);
+		rc += crypto_core_ristretto255_add( LHS, LHS, tmp2); //z1G1, z2G2 LHS
+
+		rc += crypto_core_ristretto255_sub( tmp2, ctx->cmt+RS_EPSZ, tmp1); // U' - xP
+		rc += crypto_scalarmult_ristretto255( tmp1, ctx->c, tmp2); // c( U' - xP )
+		rc += crypto_core_ristretto255_add( RHS, tmp1, ctx->cmt);// T + c(U' - xP)
+
+		rc += crypto_verify_32( LHS, RHS );
+		ps->out[0] = rc == 0 ? 0x00 : 0x01;
+		ps->olen = 1;
+		ps->need = 0;
+		ps->heavy = 0;
+		ps->rc = rc;
+		debug("Replied: %02X\n",ps->out[0]);
+		return PS_DONE;
+	}
+
+	void vrffree(void *vctx){
+		sodium_memzero(vctx, sizeof(struct vrfctx));
+		free(vctx); return;
+	}
+
+	//prover session state for the sans-io core
+	struct prvctx{
+		int stage;
+		struct signat *usk;
+		unsigned char t1[RS_SCSZ], t2[RS_SCSZ];
+	};
+
+	int prvinit(
+		void *vusk,
+		const unsigned char *mbuffer, size_t mlen,
+		struct pstep *ps,
+		void **out
+	){
+		struct prvctx *tmp = (struct prvctx *)malloc(sizeof(struct prvctx));
+		tmp->stage = 0;
+		tmp->usk = (struct signat *)vusk;
+
+		//prover moves first with the COMMIT
+		ps->need = 0;
+		ps->heavy = 1;
+		*out = (void *)tmp; return 0;
+	}
+
+	int prvstep(void *vctx, struct pstep *ps){
+		struct prvctx *ctx = (struct prvctx *)vctx;
+		unsigned char tb1[RS_EPSZ], tb2[RS_EPSZ];
+		int rc;
+
+		switch(ctx->stage++){
+		case 0:
+			//--------------------------------------------------------
+			//--------------COMPUTE AND SEND COMMIT
+			//CMT <- T, U'
+			// T = t1B + t2B2
+			rng::scalar(ctx->t1);
+			rng::scalar(ctx->t2);
+			rc = 0;
+			rc += crypto_scalarmult_ristretto255_base( tb1, ctx->t1);
+			rc += crypto_scalarmult_ristretto255( tb2, ctx->t2, ctx->usk->B2);
+			rc += crypto_core_ristretto255_add( ps->out, tb1, tb2);
+			sodium_memzero(tb1, RS_EPSZ);
+			sodium_memzero(tb2, RS_EPSZ);
+			if( rc != 0 ){
+				lerror("Failed to compute COMMIT\n");
+				ps->olen = 0; ps->rc = 1;
+				return PS_DONE;
+			}
+			memcpy( ps->out+RS_EPSZ, ctx->usk->U, RS_EPSZ);
+			ps->olen = 2*RS_EPSZ;
+			ps->need = RS_SCSZ;
+			ps->heavy = 0;
+			return PS_CONT;
+		case 1:
+			//--------------------------------------------------------
+			//--------------RECEIVE CHALLENGE, SEND RESPONSE
+			// y = t + cs
+			crypto_core_ristretto255_scalar_mul( ps->out, ps->in, ctx->usk->s1 );
+			crypto_core_ristretto255_scalar_add( ps->out, ps->out, ctx->t1 );
+			crypto_core_ristretto255_scalar_mul( ps->out+RS_SCSZ, ps->in, ctx->usk->s2 );
+			crypto_core_ristretto255_scalar_add( ps->out+RS_SCSZ, ps->out+RS_SCSZ, ctx->t2 );
+			//PREVENT RESET ATTACKS, clear the commit trace
+			sodium_memzero(ctx->t1, RS_SCSZ);
+			sodium_memzero(ctx->t2, RS_SCSZ);
+			ps->olen = 2*RS_SCSZ;
+			ps->need = 1;
+			ps->heavy = 0;
+			return PS_CONT;
+		default:
+			//--------------------------------------------------------
+			//--------------RECEIVE RESULT
+			debug("Received: %02X\n",ps->in[0]);
+			ps->olen = 0;
+			ps->need = 0;
+			ps->rc = (int)ps->in[0];
+			return PS_DONE;
+		}
+	}
+
+	void prvfree(void *vctx){
+		sodium_memzero(vctx, sizeof(struct prvctx));
+		free(vctx); return;
+	}
 }
@@ -33,9 +33,12 @@
  */
 
 #include "static.hpp"
+#include "../internal.hpp"
+#include "../nonce.hpp"
 
 #include "../../utils/bufhelp.h"
 #include "../../utils/debug.h"
+#include "../../utils/sha512mb.h"
 
 //include general constant and macros
 #include "../cmacro.h"
@@ -55,6 +58,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
+#include <new>
 
 /*
  * Key storage detail (as of 2020 Mar 22)
@@ -100,61 +104,121 @@ namespace twn25519{
 		*out = (void *) tmp; return;
 	}
 
-	void signatgen(
-		void *vkey,
-		const unsigned char *mbuffer, size_t mlen,
-		void **out
-	){
-		//declare and allocate for signature struct, nonce
-		struct seckey *key = (struct seckey *)vkey; //recast key
-		struct signat *tmp = (struct signat *)malloc(sizeof(struct signat));
-		int rc;
-		unsigned char n1[RS_SCSZ], n2[RS_SCSZ];
+	//r1 and r2 random, or derived from a1, a2 and the ID as it is absorbed
+	//(see nonce.hpp)
+	static void signonce(struct seckey *key, struct nonce::stream *nc){
+		const unsigned char *sec[] = { key->a1, key->a2 };
+		nonce::init(nc, 2, sec, 2);
+	}
 
+	//commitment of a new signature, its components allocated
+	static int sigcommit(struct seckey *key, struct signat *tmp, unsigned char *nonce,
+		struct nonce::stream *nc){
+		int rc;
 		//allocate for components
 		tmp->s1 = (unsigned char *)sodium_malloc( RS_SCSZ );
 		tmp->s2 = (unsigned char *)sodium_malloc( RS_SCSZ );
-		//tmp->x = (unsigned char *)malloc( RS_SCSZ ); //hashexec takes care
+		tmp->x = (unsigned char *)malloc( RS_SCSZ );
 		tmp->U = (unsigned char *)malloc( RS_EPSZ );
 		tmp->B2 = (unsigned char *)malloc( RS_EPSZ );
 
-		//sample r1 and r2 (MUST RANDOMIZE, else secret key a will be exposed)
-		crypto_core_ristretto255_scalar_random(n1);
-		crypto_core_ristretto255_scalar_random(n2);
+		//r1 and r2, the ID absorbed by now
+		nonce::final(nc, nonce);
 
 		rc = 0;
-		rc += crypto_scalarmult_ristretto255_base(
-				tmp->U,
-				n1
-				); // U = rB
-
-		rc += crypto_scalarmult_ristretto255(
-				tmp->B2,
-				n2,
-				key->pub->B2
-				); // V = rP1
-
+		// U = r1B + r2B2
+		rc += crypto_scalarmult_ristretto255_base( tmp->U, nonce);
+		rc += crypto_scalarmult_ristretto255( tmp->B2, nonce+RS_SCSZ, key->pub->B2);
 		rc += crypto_core_ristretto255_add(tmp->U, tmp->U, tmp->B2);
-		tmp->x = hashexec(mbuffer, mlen, tmp->U, key->pub->P);
 
+		//store B2 on the signature
+		memcpy( tmp->B2, key->pub->B2, RS_EPSZ );
+		return rc;
+	}
+
+	//response once x is known
+	static void sigrespond(struct seckey *key, struct signat *tmp, const unsigned char *nonce){
 		// s1 = r1 + xa1
 		crypto_core_ristretto255_scalar_mul( tmp->s1 , tmp->x, key->a1 );
-		crypto_core_ristretto255_scalar_add( tmp->s1, tmp->s1, n1 );
+		crypto_core_ristretto255_scalar_add( tmp->s1, tmp->s1, nonce );
 
 		// s2 = r2 + xa2
 		crypto_core_ristretto255_scalar_mul( tmp->s2 , tmp->x, key->a2 );
-		crypto_core_ristretto255_scalar_add( tmp->s2, tmp->s2, n2 );
+		crypto_core_ristretto255_scalar_add( tmp->s2, tmp->s2, nonce+RS_SCSZ );
+	}
 
-		if( rc != 0 ){ //abort if fail
+	void signatini(void *vkey, struct sigstream *ss){
+		struct seckey *key = (struct seckey *)vkey; //recast key
+		hashpre(&ss->pre, NULL, 0);
+		signonce(key, &ss->nc);
+	}
+
+	void signatfin(void *vkey, struct sigstream *ss, void **out){
+		//declare and allocate for signature struct, nonce
+		struct seckey *key = (struct seckey *)vkey; //recast key
+		struct signat *tmp = (struct signat *)malloc(sizeof(struct signat));
+		unsigned char nonce[2*RS_SCSZ];
+
+		//--------------------------TODO START
+		if( sigcommit(key, tmp, nonce, &ss->nc) != 0 ){ //abort if fail
+			sigdestroy(tmp);
 			*out = NULL; return;
 		}
 
-		//store B2 on the signature
-		memcpy( tmp->B2, key->pub->B2, RS_EPSZ );
+		hashfrom(tmp->x, &ss->pre, tmp->U, key->pub->P);
+
+		sigrespond(key, tmp, nonce);
+		sodium_memzero(nonce, sizeof(nonce));
+		//--------------------------TODO END
 
 		*out = (void *) tmp; return;
 	}
 
+	void signatgen(
+		void *vkey,
+		const unsigned char *mbuffer, size_t mlen,
+		void **out
+	){
+		struct sigstream ss;
+		signatini(vkey, &ss);
+		sigabsorb(&ss, mbuffer, mlen);
+		signatfin(vkey, &ss, out);
+	}
+
+	void signatgenv(
+		void *vkey, size_t n,
+		const unsigned char *const *mbuffer, const size_t *mlen,
+		void **out
+	){
+		struct seckey *key = (struct seckey *)vkey; //recast key
+		struct signat *tmp[SHA512MB_LANES];
+		unsigned char nonce[SHA512MB_LANES][2*RS_SCSZ];
+		unsigned char *x[SHA512MB_LANES];
+		const unsigned char *u[SHA512MB_LANES], *v[SHA512MB_LANES];
+		int rc[SHA512MB_LANES];
+		struct nonce::stream nc;
+		size_t i, k, c;
+
+		for(i = 0; i < n; i += c){
+			c = n - i < SHA512MB_LANES ? n - i : SHA512MB_LANES;
+			for(k = 0; k < c; k++){
+				tmp[k] = (struct signat *)malloc(sizeof(struct signat));
+				signonce(key, &nc);
+				nonce::update(&nc, mbuffer[i+k], mlen[i+k]);
+				rc[k] = sigcommit(key, tmp[k], nonce[k], &nc);
+				x[k] = tmp[k]->x; u[k] = tmp[k]->U; v[k] = key->pub->P;
+			}
+			//the challenges of the group in one pass
+			hashexecv(x, mbuffer+i, mlen+i, u, v, c);
+			for(k = 0; k < c; k++){
+				sigrespond(key, tmp[k], nonce[k]);
+				if( rc[k] != 0 ){ sigdestroy(tmp[k]); tmp[k] = NULL; }
+				out[i+k] = (void *) tmp[k];
+			}
+		}
+		sodium_memzero(nonce, sizeof(nonce));
+	}
+
 	int signatchk(
 		void *vpar,
 		void *vsig,
@@ -164,30 +228,72 @@ namespace twn25519{
 		return 1;
 	}
 
-	unsigned char *hashexec(
+	int signatchkp(void *vpar, void *vsig, const struct sigstream *ss){
+		// NOT IMPLEMENTED
+		return 1;
+	}
+
+	void hashexec(
+		unsigned char *out,
 		const unsigned char *mbuffer, size_t mlen,
-		unsigned char *ubuffer,
-		unsigned char *vbuffer
+		const unsigned char *ubuffer,
+		const unsigned char *vbuffer
+	){
+		crypto_hash_sha512_state pre;
+		hashpre( &pre, mbuffer, mlen);
+		hashfrom( out, &pre, ubuffer, vbuffer);
+	}
+
+	void hashpre(crypto_hash_sha512_state *pre, const unsigned char *mbuffer, size_t mlen){
+		crypto_hash_sha512_init( pre );
+		crypto_hash_sha512_update( pre, mbuffer, mlen);
+	}
+
+	void hashfrom(
+		unsigned char *out,
+		const crypto_hash_sha512_state *pre,
+		const unsigned char *ubuffer,
+		const unsigned char *vbuffer
 	){
-		crypto_hash_sha512_state eh_state;
+		crypto_hash_sha512_state eh_state = *pre; //the midstate is reused
 		unsigned char hshe[RS_HSSZ]; //hash
-		unsigned char *out = (unsigned char *)malloc( RS_SCSZ );
 
 		//compute hash
-		crypto_hash_sha512_init( &eh_state );
-		crypto_hash_sha512_update( &eh_state, mbuffer, mlen);
 		crypto_hash_sha512_update( &eh_state, ubuffer, RS_EPSZ);
 		crypto_hash_sha512_update( &eh_state, vbuffer, RS_EPSZ);
 		crypto_hash_sha512_final( &eh_state, hshe);
 		crypto_core_ristretto255_scalar_reduce(
 			out, (const unsigned char *)hshe
 		);
-		return out;
 	}
 
-	void hashfree(unsigned char *hash){
-		sodium_memzero(hash, RS_SCSZ);
-		free(hash); return;
+	void hashexecv(
+		unsigned char *const *out,
+		const unsigned char *const *mbuffer, const size_t *mlen,
+		const unsigned char *const *ubuffer,
+		const unsigned char *const *vbuffer,
+		size_t n
+	){
+		struct sha512mb_msg msg[SHA512MB_LANES];
+		unsigned char hshe[SHA512MB_LANES][RS_HSSZ]; //hashes
+		size_t i, k, c;
+
+		for(i = 0; i < n; i += c){
+			c = n - i < SHA512MB_LANES ? n - i : SHA512MB_LANES;
+			for(k = 0; k < c; k++){
+				msg[k].part[0] = mbuffer[i+k]; msg[k].plen[0] = mlen[i+k];
+				msg[k].part[1] = ubuffer[i+k]; msg[k].plen[1] = RS_EPSZ;
+				msg[k].part[2] = vbuffer[i+k]; msg[k].plen[2] = RS_EPSZ;
+				msg[k].nparts = 3;
+				msg[k].out = hshe[k];
+			}
+			sha512mb(msg, c);
+			for(k = 0; k < c; k++){
+				crypto_core_ristretto255_scalar_reduce(
+					out[i+k], (const unsigned char *)hshe[k]
+				);
+			}
+		}
 	}
 
 	size_t secserial(void *in, unsigned char **sbuffer, size_t *slen){
@@ -295,6 +401,32 @@ namespace twn25519{
 		*out = (void *) tmp; return;
 	}
 
+	static_assert( sizeof(struct pubkey) <= sizeof(struct kview), "view storage" );
+	static_assert( sizeof(struct signat) <= sizeof(struct kview), "view storage" );
+
+	int pubview(const unsigned char *pbuffer, size_t plen, struct kview *view){
+		struct pubkey *tmp;
+		if( pbuffer == NULL || plen != PKEY_SZ ) return 1;
+		//the struct lives in the view, its components in the buffer
+		tmp = new (view->b) pubkey;
+		tmp->B2 = (unsigned char *)pbuffer;
+		tmp->P = (unsigned char *)pbuffer + RS_EPSZ;
+		return 0;
+	}
+
+	int sigview(const unsigned char *obuffer, size_t olen, struct kview *view){
+		struct signat *tmp;
+		if( obuffer == NULL || olen != SGNT_SZ ) return 1;
+		//the struct lives in the view, its components in the buffer
+		tmp = new (view->b) signat;
+		tmp->s1 = (unsigned char *)obuffer;
+		tmp->s2 = (unsigned char *)obuffer + RS_SCSZ;
+		tmp->x = (unsigned char *)obuffer + 2*RS_SCSZ;
+		tmp->U = (unsigned char *)obuffer + 3*RS_SCSZ;
+		tmp->B2 = (unsigned char *)obuffer + 3*RS_SCSZ + RS_EPSZ;
+		return 0;
+	}
+
 	//destroy secret key
 	void secdestroy(void *in){
 		//key recast
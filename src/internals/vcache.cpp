@@ -0,0 +1,310 @@
+/*
+ * internals/vcache.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Verifier cache
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "vcache.hpp"
+#include "../utils/mclock.h"
+
+#include <sodium.h>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#define VC_WAYS 4	//entries per set
+#define VC_SHARDS 64	//writer locks and counters, sets map onto them
+#define VC_PTSZ 32	//a point or a scalar
+#define VC_PW (VC_PTSZ / 8)
+#define VC_KW (3*VC_PW + VC_IDMAX / 8)	//P1, U, V and the ID
+#define VC_VW (2*VC_PW)			//x and w
+
+typedef std::atomic<uint64_t> vword;
+
+//every field is an atomic word so a reader racing a writer is well
+//defined, the sequence number (odd while written) tells it to miss
+struct alignas(64) entry{
+	std::atomic<uint32_t> seq;
+	std::atomic<uint32_t> meta;	//0 - empty, else valid | mlen | algotype
+	vword used;			//last hit, least recent goes first
+	vword tag;
+	vword key[VC_KW];
+	vword val[VC_VW];
+};
+
+struct alignas(64) shard{
+	std::mutex mtx;
+	std::atomic<uint64_t> hits, misses, inserts, evictions;
+};
+
+struct table{
+	size_t nsets;			//power of 2
+	struct entry *e;
+	std::atomic<size_t> used;	//valid entries
+	unsigned char skey[crypto_shorthash_KEYBYTES];
+};
+
+//what a lookup compares an entry against
+struct query{
+	uint64_t tag;
+	uint32_t meta;
+	uint64_t key[VC_KW];
+};
+
+//lookups and inserts in flight, by the parity of the epoch they entered
+struct alignas(64) gate{
+	std::atomic<size_t> n;
+};
+
+//counters are cumulative across resizes
+static struct shard gsh[VC_SHARDS];
+static std::mutex gcfg;
+static std::atomic<struct table *> gtab(NULL);
+static std::atomic<unsigned int> gepoch(0);
+static struct gate ggate[2];
+
+namespace vcache{
+
+	//pin the current table, it is not freed before the matching leave
+	static struct table *enter(unsigned int *ep){
+		unsigned int e;
+		for(;;){
+			e = gepoch.load();
+			ggate[e & 1].n.fetch_add(1);
+			if(gepoch.load() == e) break;
+			//a resize moved on meanwhile, enter its epoch instead
+			ggate[e & 1].n.fetch_sub(1);
+		}
+		*ep = e;
+		return gtab.load();
+	}
+
+	static inline void leave(unsigned int e){
+		ggate[e & 1].n.fetch_sub(1, std::memory_order_release);
+	}
+
+	static int mkquery(
+		const struct table *t, unsigned int a, const unsigned char *p1,
+		const unsigned char *mbuffer, size_t mlen,
+		const unsigned char *u, const unsigned char *v,
+		struct query *q
+	){
+		unsigned char *k = (unsigned char *)q->key;
+		if(mlen > VC_IDMAX) return 1;
+		memset(q->key, 0, sizeof(q->key));
+		memcpy(k, p1, VC_PTSZ);
+		memcpy(k + VC_PTSZ, u, VC_PTSZ);
+		if(v != NULL) memcpy(k + 2*VC_PTSZ, v, VC_PTSZ);
+		memcpy(k + 3*VC_PTSZ, mbuffer, mlen);
+		q->meta = 0x80000000u | (uint32_t)mlen << 8 | (a & 0xff);
+		//keyed, so IDs cannot be picked to crowd one set
+		crypto_shorthash((unsigned char *)&q->tag, k, sizeof(q->key), t->skey);
+		q->tag ^= (uint64_t)q->meta * 0x9e3779b97f4a7c15ULL;
+		return 0;
+	}
+
+	static inline size_t setof(const struct table *t, const struct query *q){
+		return (size_t)(q->tag >> 8) & (t->nsets - 1);
+	}
+
+	static inline struct shard *shardof(size_t set){
+		return &gsh[set & (VC_SHARDS - 1)];
+	}
+
+	static int matches(const struct entry *e, const struct query *q){
+		int i;
+		if(e->meta.load(std::memory_order_relaxed) != q->meta) return 0;
+		if(e->tag.load(std::memory_order_relaxed) != q->tag) return 0;
+		for(i = 0; i < VC_KW; i++)
+			if(e->key[i].load(std::memory_order_relaxed) != q->key[i]) return 0;
+		return 1;
+	}
+
+	//seqlock read, copy out only what was not written meanwhile
+	static int readout(const struct entry *e, const struct query *q, unsigned char *x, unsigned char *w){
+		uint64_t val[VC_VW];
+		uint32_t s = e->seq.load(std::memory_order_acquire);
+		int i;
+		if(s & 1) return 1;
+		if(!matches(e, q)) return 1;
+		for(i = 0; i < VC_VW; i++) val[i] = e->val[i].load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(e->seq.load(std::memory_order_relaxed) != s) return 1;
+		memcpy(x, val, VC_PTSZ);
+		memcpy(w, val + VC_PW, VC_PTSZ);
+		return 0;
+	}
+
+	int lookup(
+		unsigned int a, const unsigned char *p1,
+		const unsigned char *mbuffer, size_t mlen,
+		const unsigned char *u, const unsigned char *v,
+		unsigned char *x, unsigned char *w
+	){
+		struct table *t;
+		struct query q;
+		struct entry *set;
+		struct shard *sh;
+		size_t s;
+		unsigned int e;
+		int i, rc = 1;
+
+		t = enter(&e);
+		if(t == NULL || mkquery(t, a, p1, mbuffer, mlen, u, v, &q) != 0){
+			leave(e);
+			return 1;
+		}
+		s = setof(t, &q);
+		set = &t->e[s * VC_WAYS];
+		sh = shardof(s);
+		for(i = 0; i < VC_WAYS && rc != 0; i++){
+			if(readout(&set[i], &q, x, w) == 0){
+				set[i].used.store(mclock_ns(), std::memory_order_relaxed);
+				rc = 0;
+			}
+		}
+		leave(e);
+		if(rc == 0) sh->hits.fetch_add(1, std::memory_order_relaxed);
+		else sh->misses.fetch_add(1, std::memory_order_relaxed);
+		return rc;
+	}
+
+	//insert into a pinned table
+	static void store(
+		struct table *t, unsigned int a, const unsigned char *p1,
+		const unsigned char *mbuffer, size_t mlen,
+		const unsigned char *u, const unsigned char *v,
+		const unsigned char *x, const unsigned char *w
+	){
+		struct query q;
+		struct entry *set, *e = NULL;
+		struct shard *sh;
+		uint64_t val[VC_VW];
+		uint32_t s;
+		size_t n;
+		int i;
+
+		if(mkquery(t, a, p1, mbuffer, mlen, u, v, &q) != 0) return;
+		n = setof(t, &q);
+		set = &t->e[n * VC_WAYS];
+		sh = shardof(n);
+		memcpy(val, x, VC_PTSZ);
+		memcpy(val + VC_PW, w, VC_PTSZ);
+
+		std::lock_guard<std::mutex> lk(sh->mtx);
+		//another session of the same identity got here first
+		for(i = 0; i < VC_WAYS; i++) if(matches(&set[i], &q)) return;
+		//an empty way, else the least recently used one
+		for(i = 0; i < VC_WAYS && e == NULL; i++)
+			if(set[i].meta.load(std::memory_order_relaxed) == 0) e = &set[i];
+		if(e == NULL){
+			e = &set[0];
+			for(i = 1; i < VC_WAYS; i++)
+				if(set[i].used.load(std::memory_order_relaxed) < e->used.load(std::memory_order_relaxed)) e = &set[i];
+			sh->evictions.fetch_add(1, std::memory_order_relaxed);
+		}else{
+			t->used.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		s = e->seq.load(std::memory_order_relaxed);
+		e->seq.store(s + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		e->meta.store(q.meta, std::memory_order_relaxed);
+		e->tag.store(q.tag, std::memory_order_relaxed);
+		for(i = 0; i < VC_KW; i++) e->key[i].store(q.key[i], std::memory_order_relaxed);
+		for(i = 0; i < VC_VW; i++) e->val[i].store(val[i], std::memory_order_relaxed);
+		e->used.store(mclock_ns(), std::memory_order_relaxed);
+		e->seq.store(s + 2, std::memory_order_release);
+		sh->inserts.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void insert(
+		unsigned int a, const unsigned char *p1,
+		const unsigned char *mbuffer, size_t mlen,
+		const unsigned char *u, const unsigned char *v,
+		const unsigned char *x, const unsigned char *w
+	){
+		struct table *t;
+		unsigned int e;
+
+		t = enter(&e);
+		if(t != NULL) store(t, a, p1, mbuffer, mlen, u, v, x, w);
+		leave(e);
+	}
+
+	int resize(size_t bytes){
+		struct table *t = NULL, *old;
+		size_t nsets = 1;
+		unsigned int e;
+
+		std::lock_guard<std::mutex> lk(gcfg);
+		if(bytes > 0){
+			while(nsets * 2 * VC_WAYS * sizeof(struct entry) <= bytes) nsets *= 2;
+			t = new (std::nothrow) struct table;
+			if(t == NULL) return 1;
+			t->e = new (std::nothrow) struct entry[nsets * VC_WAYS]();
+			if(t->e == NULL){ delete t; return 1; }
+			t->nsets = nsets;
+			t->used.store(0, std::memory_order_relaxed);
+			randombytes_buf(t->skey, sizeof(t->skey));
+		}
+		old = gtab.exchange(t);
+		//whoever entered before the swap may still hold the old table,
+		//later arrivals see the new one; wait the former out
+		e = gepoch.fetch_add(1);
+		while(ggate[e & 1].n.load(std::memory_order_acquire) != 0) std::this_thread::yield();
+		if(old != NULL){
+			delete[] old->e;
+			delete old;
+		}
+		return 0;
+	}
+
+	void stats(struct a25519_vcstat *out){
+		struct table *t;
+		int i;
+
+		memset(out, 0, sizeof(struct a25519_vcstat));
+		for(i = 0; i < VC_SHARDS; i++){
+			out->hits += gsh[i].hits.load(std::memory_order_relaxed);
+			out->misses += gsh[i].misses.load(std::memory_order_relaxed);
+			out->inserts += gsh[i].inserts.load(std::memory_order_relaxed);
+			out->evictions += gsh[i].evictions.load(std::memory_order_relaxed);
+		}
+		std::lock_guard<std::mutex> lk(gcfg);
+		t = gtab.load(std::memory_order_acquire);
+		if(t == NULL) return;
+		out->capacity = t->nsets * VC_WAYS;
+		out->entries = t->used.load(std::memory_order_relaxed);
+		out->bytes = out->capacity * sizeof(struct entry);
+	}
+
+}
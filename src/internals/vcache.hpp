@@ -0,0 +1,80 @@
+/*
+ * internals/vcache.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Verifier cache, for TNC and Schnorr IBI the challenge hash x = H(ID, U, V)
+ * and the point U +/- xP1 depend only on the identity and its user key, so
+ * once an identity identified the verifier keeps both and a repeat login
+ * skips a hash and a variable-base scalar multiplication.
+ * The cache is bounded, entries live in 4-way sets replaced least recently
+ * used first; reads take no lock (per entry sequence counter), writers lock
+ * one of a few shards of sets. a resize waits out the lookups and inserts
+ * that entered before it (two epoch counters) before freeing the old table
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _VCACHE_HPP_
+#define _VCACHE_HPP_
+
+#include "../a25519.h"
+#include <stddef.h>
+
+#define VC_IDMAX 128	//longer IDs are not cached
+
+namespace vcache{
+
+	//look up (algotype, master key P1, ID, U, V), V is NULL for schemes
+	//without one. return 0 and fill x and w on a hit
+	int lookup(
+		unsigned int a, const unsigned char *p1,
+		const unsigned char *mbuffer, size_t mlen,
+		const unsigned char *u, const unsigned char *v,
+		unsigned char *x, unsigned char *w
+	);
+
+	//keep x and w of an identity that just identified, a no-op while the
+	//cache is off
+	void insert(
+		unsigned int a, const unsigned char *p1,
+		const unsigned char *mbuffer, size_t mlen,
+		const unsigned char *u, const unsigned char *v,
+		const unsigned char *x, const unsigned char *w
+	);
+
+	//hold at most bytes of entries (0 turns the cache off), dropping what
+	//is cached. safe while identifications are being verified, the old
+	//table is freed once no lookup or insert can still be using it
+	int resize(size_t bytes);
+
+	//counters since start and the current size
+	void stats(struct a25519_vcstat *out);
+
+}
+
+#endif
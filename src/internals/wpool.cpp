@@ -0,0 +1,156 @@
+/*
+ * internals/wpool.cpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Bounded worker pool
+ *
+ * id2 project
+ * chia_jason96@live.com
+ */
+
+#include "wpool.hpp"
+#include "mpmc.hpp"
+
+#include "../a25519.h"
+#include "../utils/debug.h"
+#include "../utils/mclock.h"
+
+#include <atomic>
+#include <thread>
+#include <new>
+#include <semaphore.h>
+
+namespace wpool{
+
+	struct pool{
+		mpmc<struct job *> *q;
+		std::thread *thr;
+		unsigned int workers;
+		sem_t avail; //one post per queued job
+		std::atomic<int> stop;
+
+		//statistics
+		std::atomic<size_t> qdepth_max;
+		std::atomic<unsigned long long> jobs;
+		std::atomic<unsigned long long> wait_ns;
+		std::atomic<unsigned long long> wait_ns_max;
+		std::atomic<unsigned long long> run_ns;
+	};
+
+	template <typename T>
+	static void atomic_max(std::atomic<T> &a, T v){
+		T cur = a.load(std::memory_order_relaxed);
+		while(v > cur && !a.compare_exchange_weak(cur, v, std::memory_order_relaxed));
+	}
+
+	static void worker(struct pool *p){
+		struct job *j; uint64_t tq, t0, t1;
+		for(;;){
+			while( sem_wait(&p->avail) != 0 ); //EINTR
+			if(p->stop.load(std::memory_order_acquire)) return;
+			//a post always follows a completed push, but the slot may
+			//not be visible to this consumer yet
+			while( !p->q->pop(j) ) std::this_thread::yield();
+
+			tq = j->tq;
+			t0 = mclock_ns();
+			j->run(j); //j may be freed by run
+			t1 = mclock_ns();
+
+			p->jobs.fetch_add(1, std::memory_order_relaxed);
+			p->wait_ns.fetch_add(t0 - tq, std::memory_order_relaxed);
+			p->run_ns.fetch_add(t1 - t0, std::memory_order_relaxed);
+			atomic_max<unsigned long long>(p->wait_ns_max, t0 - tq);
+		}
+	}
+
+	struct pool *create(unsigned int workers, size_t qdepth){
+		struct pool *p;
+		unsigned int i;
+		if(workers == 0 || qdepth == 0){
+			lerror("invalid pool dimensions\n");
+			return NULL;
+		}
+
+		p = new (std::nothrow) struct pool;
+		if(p == NULL){
+			lerror("failed to allocate pool\n");
+			return NULL;
+		}
+		p->q = new (std::nothrow) mpmc<struct job *>(qdepth);
+		p->thr = new (std::nothrow) std::thread[workers];
+		if(p->q == NULL || p->thr == NULL || sem_init(&p->avail, 0, 0) != 0){
+			lerror("failed to allocate pool queue\n");
+			delete p->q; delete[] p->thr; delete p;
+			return NULL;
+		}
+		p->workers = workers;
+		p->stop.store(0);
+		p->qdepth_max.store(0);
+		p->jobs.store(0);
+		p->wait_ns.store(0);
+		p->wait_ns_max.store(0);
+		p->run_ns.store(0);
+
+		for(i=0;i<workers;i++) p->thr[i] = std::thread(worker, p);
+		debug("worker pool started (%u workers, %zu slots)\n", workers, p->q->capacity());
+		return p;
+	}
+
+	int submit(struct pool *p, struct job *j){
+		j->tq = mclock_ns();
+		if( !p->q->push(j) ) return 1;
+		atomic_max<size_t>(p->qdepth_max, p->q->depth());
+		sem_post(&p->avail);
+		return 0;
+	}
+
+	size_t depth(struct pool *p){
+		return p->q->depth();
+	}
+
+	void destroy(struct pool *p){
+		unsigned int i;
+		if(p == NULL) return;
+		p->stop.store(1, std::memory_order_release);
+		for(i=0;i<p->workers;i++) sem_post(&p->avail);
+		for(i=0;i<p->workers;i++) p->thr[i].join();
+		sem_destroy(&p->avail);
+		delete[] p->thr;
+		delete p->q;
+		delete p;
+	}
+
+	void stats(struct pool *p, struct a25519_poolstat *out){
+		out->workers = p->workers;
+		out->qcap = p->q->capacity();
+		out->qdepth = p->q->depth();
+		out->qdepth_max = p->qdepth_max.load(std::memory_order_relaxed);
+		out->jobs = p->jobs.load(std::memory_order_relaxed);
+		out->wait_ns = p->wait_ns.load(std::memory_order_relaxed);
+		out->wait_ns_max = p->wait_ns_max.load(std::memory_order_relaxed);
+		out->run_ns = p->run_ns.load(std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,71 @@
+/*
+ * internals/wpool.hpp - id2 library
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Chia Jason
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Bounded worker pool, takes crypto and user callbacks off the I/O thread
+ * jobs are queued on a lock-free mpmc ring, idle workers sleep on a semaphore
+ *
+ * id2 project
+ * chia_jason96@live.com
+ *
+ * this is for internal use only!
+ */
+
+#ifndef _WPOOL_HPP_
+#define _WPOOL_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct a25519_poolstat;
+
+namespace wpool{
+
+	//embed this as the FIRST member of the job's owner and recast in run
+	struct job{
+		void (*run)(struct job *);
+		uint64_t tq; //enqueue timestamp (ns)
+	};
+
+	struct pool;
+
+	//spawn workers, qdepth is rounded up to a power of 2
+	//return NULL on fail
+	struct pool *create(unsigned int workers, size_t qdepth);
+
+	//queue a job, return 0 on success, 1 if the queue is full
+	int submit(struct pool *p, struct job *j);
+
+	//current number of queued jobs
+	size_t depth(struct pool *p);
+
+	//stop and join the workers, queued jobs are dropped
+	void destroy(struct pool *p);
+
+	//read out the pool statistics
+	void stats(struct pool *p, struct a25519_poolstat *out);
+}
+
+#endif
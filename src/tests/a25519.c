@@ -7,6 +7,7 @@
 #include "../id2.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 #include <sys/types.h>
@@ -134,6 +135,103 @@ int main(int argc, char *argv[]){
 			free(obuf);
 			free(mbuf);
 
+		}else if( strcmp(argv[2],"kstore") == 0){
+			//bulk extract, one ID per line of argv[3] into the keystore argv[4]
+			if( argc < 5 ){
+				lerror("Please specify <idlist> <keystore> for kstore !\n");
+				return 1;
+			}
+			secretfile = fopen( str_secretfile, "r");
+			idfile = fopen( argv[3], "r");
+			if( secretfile == NULL || idfile == NULL ){
+				lerror("Missing %s or %s\n",str_secretfile,argv[3]);
+				return 1;
+			}
+			sbuf = read_b64( secretfile, &slen );
+			char *list = fileread( idfile, &mlen );
+			size_t n = 0, cap = 1024, idmax = 0;
+			unsigned char **ids = (unsigned char **)malloc(cap * sizeof(unsigned char *));
+			size_t *idlens = (size_t *)malloc(cap * sizeof(size_t));
+			char *line = strtok(list, "\r\n");
+			while( line != NULL ){
+				if( n == cap ){
+					cap *= 2;
+					ids = (unsigned char **)realloc(ids, cap * sizeof(unsigned char *));
+					idlens = (size_t *)realloc(idlens, cap * sizeof(size_t));
+				}
+				ids[n] = (unsigned char *)line;
+				idlens[n] = strlen(line);
+				if( idlens[n] > idmax ) idmax = idlens[n];
+				n++;
+				line = strtok(NULL, "\r\n");
+			}
+
+			start = clock();
+			rc = a25519_sig_sign_store(algo, sbuf, slen, n, ids, idlens, idmax, argv[4]);
+			end = clock();
+			cpu_time_use0 = (((double) (end - start)) / CLOCKS_PER_SEC) * 1000; //record time
+			if(rc != 0){ lerror("Keystore Error\n"); }
+			printf("extract of %zu keys took %.4f ms\n", n, cpu_time_use0);
+
+			fclose(secretfile);
+			fclose(idfile);
+			free(ids);
+			free(idlens);
+			free(list);
+			free(sbuf);
+
+		}else if( strcmp(argv[2],"kprove") == 0){
+			//prove the ID of id.txt with its key from the keystore argv[3]
+			if( argc < 4 ){
+				lerror("Please specify <keystore> [server] for kprove !\n");
+				return 1;
+			}
+			idfile = fopen( str_idfile, "r");
+			struct kstore *ks = kstore_open( argv[3] );
+			if( idfile == NULL || ks == NULL ){
+				lerror("Missing %s or %s\n",str_idfile,argv[3]);
+				return 1;
+			}
+			mbuf = (unsigned char *) fileread( idfile, &mlen );
+			//fileread counts the terminator
+			mlen = strlen((char *)mbuf);
+			obuf = (unsigned char *) kstore_find( ks, mbuf, mlen );
+			if( obuf == NULL || kstore_algo(ks) != algo ){
+				lerror("No key for [%s] in %s\n", mbuf, argv[3]);
+				return 1;
+			}
+			rc = a25519_ibi_oclient(algo, mbuf, mlen, obuf, kstore_recsz(ks),
+				argc > 4 ? argv[4] : "127.0.0.1", PORT, 60);
+			if(rc==0){
+				printf("prove success [%s] 0x%02x\n", mbuf, rc);
+			}else{
+				printf("prove fail [%s] 0x%02x\n", mbuf, rc);
+			}
+
+			fclose(idfile);
+			kstore_close(ks);
+			free(mbuf);
+
+		}else if( strcmp(argv[2],"kimport") == 0 || strcmp(argv[2],"kexport") == 0 ){
+			//base64 key archive (<ID> TAB <key> per line) to keystore and back
+			if( argc < 5 ){
+				lerror("Please specify <from> <to> [threads] for %s !\n", argv[2]);
+				return 1;
+			}
+			struct kconv_stat kst;
+			if( argv[2][1] == 'i' ){
+				rc = kconv_import(argv[3], argv[4], algo,
+					argc > 5 ? strtoul(argv[5],NULL,10) : 0, &kst);
+			}else{
+				rc = kconv_export(argv[3], argv[4], &kst);
+			}
+			if(rc != 0){
+				lerror("Conversion of %s failed\n", argv[3]);
+				return 1;
+			}
+			printf("%llu keys (%.1f MB) in %.3f s, %.0f keys/sec\n", kst.keys, kst.bytes / 1e6,
+				kst.seconds, kst.seconds > 0 ? kst.keys / kst.seconds : 0.0);
+
 		}else if( strcmp(argv[2],"test") == 0){
 			publicfile = fopen( str_publicfile, "r");
 			idfile = fopen( str_idfile, "r");
@@ -339,7 +437,7 @@ int main(int argc, char *argv[]){
 			}
 		}else{
 			//echo an error
-			lerror("Invalid mode %s, please specify either:\n	<keygen/setup|sign/ext|check|prove|verify|server|client|test|runtest> !\n", argv[2]);
+			lerror("Invalid mode %s, please specify either:\n	<keygen/setup|sign/ext|check|kstore|kprove|kimport|kexport|prove|verify|server|client|test|runtest> !\n", argv[2]);
 			return 1;
 		}
 
@@ -347,7 +445,7 @@ int main(int argc, char *argv[]){
 		return 0;
 	}else{
 		//echo an error
-		lerror("Insufficient args, please specify either:\n<mode>\t<keygen/setup|sign/ext|check|prove|verify|server|client|test|runtest> !\n\nmodes:\n0 - tnc25519\n1 - cli25519\n2 - sch25519\n");
+		lerror("Insufficient args, please specify either:\n<mode>\t<keygen/setup|sign/ext|check|kstore|kprove|kimport|kexport|prove|verify|server|client|test|runtest> !\n\nmodes:\n0 - tnc25519\n1 - cli25519\n2 - sch25519\n");
 		return 1;
 	}
 
@@ -0,0 +1,165 @@
+/*
+ * Final Year Project scheme
+ * ToraNova 2019
+ * chia_jason96@live.com
+ * allocation budgets of every scheme (needs --enable-alloccount)
+*/
+#include "../id2.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#define str_teststr "alice@example.com"
+
+#define OP_KEYGEN	0
+#define OP_SIGN		1
+#define OP_VERIFY	2
+#define OP_PROVE	3
+#define OP_IBIVERIFY	4
+#define OP_NBVERIFY	5
+#define NOPS		6
+
+static const char *opname[NOPS] = {
+	"keygen", "sign", "verify", "prove", "ibi_verify", "nbverify"
+};
+
+//most allocations (heap and sodium_malloc) a call may make, per algotype.
+//lower these when an allocation is taken off a path, never raise them
+//without a reason in the commit
+static const unsigned long long budget[7][NOPS] = {
+	{ 7, 11,  0, 5, 1, 7 },	//tnc25519
+	{ 0,  0,  0, 0, 0, 0 },
+	{ 6,  9,  0, 4, 1, 6 },	//sch25519
+	{ 8, 12,  0, 5, 1, 8 },	//tsc25519
+	{ 8, 13,  0, 6, 1, 7 },	//twn25519
+	{ 7, 11,  0, 5, 1, 7 },	//rss25519
+	{ 9, 15,  0, 7, 1, 8 },	//rtw25519
+};
+
+struct prover{
+	unsigned int algo;
+	unsigned char *obuf;
+	size_t olen;
+	int sock;
+	struct a25519_allocstat st;
+};
+
+static void *prove(void *arg){
+	struct prover *p = (struct prover *)arg;
+	a25519_alloc_count(NULL, 1);
+	a25519_ibi_prove(p->algo, (unsigned char *)str_teststr, strlen(str_teststr),
+		p->obuf, p->olen, p->sock);
+	a25519_alloc_count(&p->st, 1);
+	return NULL;
+}
+
+//drive a non-blocking verifier session to the end
+static int nbverify(unsigned int algo, unsigned char *pbuf, size_t plen, int sock){
+	struct a25519_nbsess *s;
+	struct pollfd pf;
+	int r;
+	fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+	s = a25519_ibi_nbverify(algo, pbuf, plen, sock);
+	if(s == NULL) return 1;
+	pf.fd = sock;
+	while( (r = a25519_ibi_nbstep(s)) != A25519_NB_DONE && r != A25519_NB_ERROR ){
+		pf.events = r == A25519_NB_WANTWR ? POLLOUT : POLLIN;
+		poll(&pf, 1, 5000);
+	}
+	r = r == A25519_NB_DONE ? a25519_ibi_nbresult(s, NULL, NULL) : 1;
+	a25519_ibi_nbfree(s);
+	return r;
+}
+
+static unsigned long long total(const struct a25519_allocstat *st){
+	return st->calls + st->sodium_calls;
+}
+
+//run a full identification, the verifier side measured on this thread
+static int identify(
+	unsigned int algo, int nb,
+	unsigned char *pbuf, size_t plen, unsigned char *obuf, size_t olen,
+	struct a25519_allocstat *vst, struct a25519_allocstat *pst
+){
+	int sv[2], rc;
+	unsigned char *mbuf = NULL;
+	size_t mlen;
+	pthread_t thr;
+	struct prover p;
+
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) return 1;
+	p.algo = algo; p.obuf = obuf; p.olen = olen; p.sock = sv[0];
+	pthread_create(&thr, NULL, prove, &p);
+	a25519_alloc_count(NULL, 1);
+	if(nb){
+		rc = nbverify(algo, pbuf, plen, sv[1]);
+	}else{
+		rc = a25519_ibi_verify(algo, pbuf, plen, &mbuf, &mlen, sv[1]);
+		free(mbuf);
+	}
+	a25519_alloc_count(vst, 1);
+	pthread_join(thr, NULL);
+	*pst = p.st;
+	close(sv[0]); close(sv[1]);
+	return rc;
+}
+
+int main(int argc, char *argv[]){
+	unsigned int algo, op;
+	unsigned char *pbuf, *sbuf, *obuf;
+	size_t plen, slen, olen;
+	struct a25519_allocstat st[NOPS], pst;
+	int rc = 0;
+
+	if(id2_initialize()){
+		lerror("Unable to initialize libsodium\n");
+		return 1;
+	}
+	if( a25519_alloc_count(NULL, 1) != 0 ){
+		printf("allocation accounting not compiled in (--enable-alloccount), skipped\n");
+		return 77;
+	}
+
+	printf("%-10s %-11s %8s %10s %8s\n", "scheme", "op", "allocs", "bytes", "budget");
+	for(algo = 0; algo < 7; algo++){
+		if(algo == 1) continue;
+		a25519_alloc_count(NULL, 1);
+		if( a25519_keygen(algo, &pbuf, &plen, &sbuf, &slen) != 0 ){
+			lerror("Setup Error (algo %u)\n", algo);
+			return 1;
+		}
+		a25519_alloc_count(&st[OP_KEYGEN], 1);
+		a25519_sig_sign(algo, sbuf, slen, (unsigned char *)str_teststr,
+			strlen(str_teststr), &obuf, &olen);
+		a25519_alloc_count(&st[OP_SIGN], 1);
+		a25519_sig_verify(algo, pbuf, plen, (unsigned char *)str_teststr,
+			strlen(str_teststr), obuf, olen);
+		a25519_alloc_count(&st[OP_VERIFY], 1);
+		//once untimed, a thread's first session also sets up its metrics shard
+		identify(algo, 0, pbuf, plen, obuf, olen, &st[OP_IBIVERIFY], &st[OP_PROVE]);
+		if( identify(algo, 0, pbuf, plen, obuf, olen, &st[OP_IBIVERIFY], &st[OP_PROVE]) != 0 ){
+			lerror("Identification failed (algo %u)\n", algo);
+			rc = 1;
+		}
+		if( identify(algo, 1, pbuf, plen, obuf, olen, &st[OP_NBVERIFY], &pst) != 0 ){
+			lerror("Non-blocking identification failed (algo %u)\n", algo);
+			rc = 1;
+		}
+
+		for(op = 0; op < NOPS; op++){
+			printf("%-10u %-11s %8llu %10llu %8llu%s\n", algo, opname[op],
+				total(&st[op]), st[op].bytes + st[op].sodium_bytes, budget[algo][op],
+				total(&st[op]) > budget[algo][op] ? "  OVER BUDGET" : "");
+			if( total(&st[op]) > budget[algo][op] ) rc = 1;
+		}
+		free(pbuf);
+		free(sbuf);
+		free(obuf);
+	}
+	return rc;
+}
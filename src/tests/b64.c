@@ -0,0 +1,200 @@
+/*
+ * Final Year Project scheme
+ * ToraNova 2019
+ * chia_jason96@live.com
+ * base64 kernels agree with the byte at a time codec, and their throughput (-b)
+*/
+#include "../id2.h"
+#include "../utils/mclock.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define int_maxlen 700
+#define int_benchmb 16
+
+//arbitrary bytes, reproducible from run to run
+static void fill(unsigned char *b, size_t len){
+	unsigned long long x = 0x9e3779b97f4a7c15ULL;
+	size_t i;
+	for(i = 0; i < len; i++){
+		x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+		b[i] = (unsigned char)(x >> 56);
+	}
+}
+
+static const char *kname[] = { "scalar", "ssse3", "avx2" };
+
+/*
+ * the codec as it was before the vector kernels, the reference the
+ * output is checked against and the baseline of the benchmark
+ */
+static const char refchars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const int refinvs[] = { 62, -1, -1, -1, 63, 52, 53, 54, 55, 56, 57, 58,
+	59, 60, 61, -1, -1, -1, -1, -1, -1, -1, 0, 1, 2, 3, 4, 5,
+	6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+	21, 22, 23, 24, 25, -1, -1, -1, -1, -1, -1, 26, 27, 28,
+	29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42,
+	43, 44, 45, 46, 47, 48, 49, 50, 51 };
+
+static char *ref_encode(const unsigned char *in, size_t len, size_t wrap){
+	char *out;
+	size_t i, j, v, wc = wrap;
+
+	out = (char *)calloc(b64_encoded_size(len, wrap) + 1, sizeof(char));
+	for(i = 0, j = 0; i < len; i += 3, j += 4){
+		if(wrap > 0 && wc <= 0){
+			out[j++] = '\n';
+			wc = wrap;
+		}
+		v = in[i];
+		v = i+1 < len ? v << 8 | in[i+1] : v << 8;
+		v = i+2 < len ? v << 8 | in[i+2] : v << 8;
+		out[j]   = refchars[(v >> 18) & 0x3F];
+		out[j+1] = refchars[(v >> 12) & 0x3F];
+		out[j+2] = i+1 < len ? refchars[(v >> 6) & 0x3F] : '=';
+		out[j+3] = i+2 < len ? refchars[v & 0x3F] : '=';
+		wc -= 4;
+	}
+	return out;
+}
+
+static unsigned char *ref_decode(const char *in){
+	unsigned char *out;
+	size_t len, i, j;
+	int v;
+
+	len = strlen(in);
+	for(i = 0; i < len; i++) if(!b64_isvalidchar(in[i])) return NULL;
+	out = (unsigned char *)malloc(b64_decoded_size(in) + 1);
+	for(i = 0, j = 0; (i+3) < len; i += 4, j += 3){
+		if(in[i] == '\n'){
+			i++;
+			if((i+3) >= len) break;
+		}
+		v = refinvs[in[i]-43];
+		v = (v << 6) | refinvs[in[i+1]-43];
+		v = in[i+2]=='=' ? v << 6 : (v << 6) | refinvs[in[i+2]-43];
+		v = in[i+3]=='=' ? v << 6 : (v << 6) | refinvs[in[i+3]-43];
+		out[j] = (v >> 16) & 0xFF;
+		if(in[i+2] != '=') out[j+1] = (v >> 8) & 0xFF;
+		if(in[i+3] != '=') out[j+2] = v & 0xFF;
+	}
+	return out;
+}
+
+//every length up to int_maxlen, wrapped and not, through one kernel
+static int check(int level){
+	static const size_t wraps[] = { 0, 76, 64 };
+	unsigned char in[int_maxlen], out[int_maxlen + 4];
+	char enc[2 * int_maxlen], *ref;
+	size_t len, elen, w, n;
+	int rc = 0;
+
+	fill(in, sizeof(in));
+	for(len = 1; len < int_maxlen; len++){
+		for(w = 0; w < sizeof(wraps) / sizeof(wraps[0]); w++){
+			ref = ref_encode(in, len, wraps[w]);
+			elen = b64_encode_into(enc, in, len, wraps[w]);
+			if(elen != strlen(ref) || elen > b64_encoded_size(len, wraps[w]) ||
+				memcmp(enc, ref, elen) != 0){
+				lerror("%s: encoding %lu bytes (wrap %lu) differs\n", kname[level], len, wraps[w]);
+				rc = 1;
+			}
+			free(ref);
+			n = b64_decode_into(out, sizeof(out), enc, elen);
+			if(n != len || memcmp(out, in, len) != 0){
+				lerror("%s: %lu bytes (wrap %lu) do not decode back\n", kname[level], len, wraps[w]);
+				rc = 1;
+			}
+			//one byte short of room is refused, not overrun
+			if(b64_decode_into(out, len - 1, enc, elen) != (size_t)-1){
+				lerror("%s: decoding %lu bytes into %lu accepted\n", kname[level], len, len - 1);
+				rc = 1;
+			}
+			//a stray character anywhere is refused
+			enc[(len * 7) % elen] = enc[(len * 7) % elen] == '\n' ? '\n' : '*';
+			if(enc[(len * 7) % elen] == '*' && b64_decode_into(out, sizeof(out), enc, elen) != (size_t)-1){
+				lerror("%s: damaged encoding of %lu bytes accepted\n", kname[level], len);
+				rc = 1;
+			}
+		}
+	}
+	return rc;
+}
+
+static double mbs(size_t bytes, uint64_t ns){
+	return (double)bytes / ((double)ns * 1e-9) / (1 << 20);
+}
+
+//throughput over a buffer of mb MiB, the reference first
+static void bench(size_t mb, size_t wrap, int best){
+	size_t len = mb << 20, elen = b64_encoded_size(len, wrap);
+	unsigned char *in = (unsigned char *)malloc(len), *out = (unsigned char *)malloc(len + 4);
+	char *enc = (char *)malloc(elen + 1), *ref;
+	unsigned char *dec;
+	uint64_t t0, te, td;
+	int level;
+
+	fill(in, len);
+	t0 = mclock_ns();
+	ref = ref_encode(in, len, wrap);
+	te = mclock_ns() - t0;
+	t0 = mclock_ns();
+	dec = ref_decode(ref);
+	td = mclock_ns() - t0;
+	printf("%-10s wrap %-3lu encode %8.1f MB/s  decode %8.1f MB/s\n",
+		"reference", wrap, mbs(len, te), mbs(len, td));
+	free(dec);
+
+	for(level = B64_SIMD_NONE; level <= best; level++){
+		b64_simd(level);
+		t0 = mclock_ns();
+		elen = b64_encode_into(enc, in, len, wrap);
+		te = mclock_ns() - t0;
+		t0 = mclock_ns();
+		b64_decode_into(out, len, enc, elen);
+		td = mclock_ns() - t0;
+		printf("%-10s wrap %-3lu encode %8.1f MB/s  decode %8.1f MB/s%s\n",
+			kname[level], wrap, mbs(len, te), mbs(len, td),
+			memcmp(enc, ref, elen) != 0 || memcmp(out, in, len) != 0 ? "  MISMATCH" : "");
+	}
+	b64_simd(-1);
+	free(ref); free(in); free(out); free(enc);
+}
+
+int main(int argc, char *argv[]){
+	size_t mb = int_benchmb;
+	int run = 0, best, level, rc = 0, opt;
+
+	while( (opt = getopt(argc, argv, "bn:")) != -1 ){
+		switch(opt){
+			case 'b': run = 1; break;
+			case 'n': mb = strtoul(optarg,NULL,10); break;
+			default:
+				lerror("usage: %s [-b] [-n MiB]\n\n"
+					"  -b  benchmark every kernel against the reference\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if(id2_initialize()){
+		lerror("Unable to initialize libsodium\n");
+		return 1;
+	}
+
+	best = b64_simd(-1);
+	if(run){
+		bench(mb, 0, best);
+		bench(mb, BASE64_DEFAULT_WRAP, best);
+		return 0;
+	}
+	for(level = B64_SIMD_NONE; level <= best; level++){
+		if(b64_simd(level) != level) return 1;
+		if(check(level) != 0) rc = 1;
+		else printf("%s: lengths 1 to %d agree with the reference\n", kname[level], int_maxlen - 1);
+	}
+	b64_simd(-1);
+	return rc;
+}
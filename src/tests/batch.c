@@ -0,0 +1,179 @@
+/*
+ * Final Year Project scheme
+ * ToraNova 2019
+ * chia_jason96@live.com
+ * batched and deterministic signing agree with the one by one paths
+*/
+#include "../id2.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+//not a multiple of the 8 lanes, IDs long enough to span several blocks
+#define int_batch 19
+#define int_maxid 300
+
+struct prover{
+	unsigned int algo;
+	unsigned char *mbuf;
+	size_t mlen;
+	unsigned char *obuf;
+	size_t olen;
+	int sock;
+};
+
+static void *prove(void *arg){
+	struct prover *p = (struct prover *)arg;
+	a25519_ibi_prove(p->algo, p->mbuf, p->mlen, p->obuf, p->olen, p->sock);
+	return NULL;
+}
+
+//identification with a user key, its ID checked on the verifier
+static int identify(unsigned int algo, unsigned char *pbuf, size_t plen,
+	unsigned char *mbuf, size_t mlen, unsigned char *obuf, size_t olen){
+	int sv[2], rc;
+	unsigned char *rbuf = NULL;
+	size_t rlen = 0;
+	pthread_t thr;
+	struct prover p;
+
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) return 1;
+	p.algo = algo; p.mbuf = mbuf; p.mlen = mlen;
+	p.obuf = obuf; p.olen = olen; p.sock = sv[0];
+	pthread_create(&thr, NULL, prove, &p);
+	rc = a25519_ibi_verify(algo, pbuf, plen, &rbuf, &rlen, sv[1]);
+	pthread_join(thr, NULL);
+	close(sv[0]); close(sv[1]);
+	if(rc == 0 && (rlen != mlen || memcmp(rbuf, mbuf, mlen) != 0)) rc = 1;
+	free(rbuf);
+	return rc;
+}
+
+int main(int argc, char *argv[]){
+	unsigned char *mbuf[int_batch], *obuf[int_batch], *sobuf[int_batch], *rbuf[int_batch];
+	size_t mlen[int_batch], olen[int_batch], solen[int_batch], rlen[int_batch];
+	unsigned char *dobuf[int_batch], *pbuf, *sbuf, *tbuf;
+	size_t dolen[int_batch], plen, slen, tlen;
+	int vrc[int_batch], wrc[int_batch];
+	unsigned int algo, i, j;
+	int rc = 0, bad;
+
+	if(id2_initialize()){
+		lerror("Unable to initialize libsodium\n");
+		return 1;
+	}
+
+	for(i = 0; i < int_batch; i++){
+		mlen[i] = 1 + (i * 97) % int_maxid;
+		mbuf[i] = (unsigned char *)malloc(mlen[i]);
+		for(j = 0; j < mlen[i]; j++) mbuf[i][j] = (unsigned char)('a' + (i + j) % 26);
+	}
+
+	for(algo = 0; algo < 7; algo++){
+		if(algo == 1) continue;
+		if( a25519_keygen(algo, &pbuf, &plen, &sbuf, &slen) != 0 ){
+			lerror("Setup Error (algo %u)\n", algo);
+			return 1;
+		}
+		if( a25519_sig_sign_batch(algo, sbuf, slen, int_batch, mbuf, mlen, obuf, olen) != 0 ){
+			lerror("Batch signing failed (algo %u)\n", algo);
+			return 1;
+		}
+		for(i = 0; i < int_batch; i++){
+			a25519_sig_sign(algo, sbuf, slen, mbuf[i], mlen[i], &sobuf[i], &solen[i]);
+		}
+
+		//keys from the batch identify their ID
+		for(i = 0; i < int_batch; i++){
+			if( identify(algo, pbuf, plen, mbuf[i], mlen[i], obuf[i], olen[i]) != 0 ){
+				lerror("Identification with batch key %u failed (algo %u)\n", i, algo);
+				rc = 1;
+			}
+		}
+
+		//the batch verifies as the single calls do, either way round
+		bad = a25519_sig_verify_batch(algo, pbuf, plen, int_batch, mbuf, mlen, sobuf, solen, vrc);
+		for(i = 0; i < int_batch; i++){
+			if( (vrc[i] != 0) != (a25519_sig_verify(algo, pbuf, plen,
+				mbuf[i], mlen[i], sobuf[i], solen[i]) != 0) ){
+				lerror("Batch verification %u disagrees (algo %u)\n", i, algo);
+				rc = 1;
+			}
+			if( (vrc[i] != 0) != (a25519_sig_verify(algo, pbuf, plen,
+				mbuf[i], mlen[i], obuf[i], olen[i]) != 0) ){
+				lerror("Batch signature %u does not verify alike (algo %u)\n", i, algo);
+				rc = 1;
+			}
+		}
+
+		//and none passes for another ID
+		for(i = 0; i < int_batch; i++){
+			rbuf[i] = obuf[(i + 1) % int_batch];
+			rlen[i] = olen[(i + 1) % int_batch];
+		}
+		if( a25519_sig_verify_batch(algo, pbuf, plen, int_batch, mbuf, mlen, rbuf, rlen, NULL) != int_batch ){
+			lerror("Batch verification accepted a wrong ID (algo %u)\n", algo);
+			rc = 1;
+		}
+
+		//a short signature is refused on its own, the others verify as before
+		memcpy(wrc, vrc, sizeof(vrc));
+		solen[0]--;
+		if( a25519_sig_verify(algo, pbuf, plen, mbuf[0], mlen[0], sobuf[0], solen[0]) == 0 ){
+			lerror("Short signature accepted (algo %u)\n", algo);
+			rc = 1;
+		}
+		a25519_sig_verify_batch(algo, pbuf, plen, int_batch, mbuf, mlen, sobuf, solen, vrc);
+		for(i = 0; i < int_batch; i++){
+			if( i == 0 ? vrc[i] == 0 : (vrc[i] != 0) != (wrc[i] != 0) ){
+				lerror("Batch with a short signature, %u wrong (algo %u)\n", i, algo);
+				rc = 1;
+			}
+		}
+		solen[0]++;
+
+		//deterministic nonces sign an ID to the same bytes every time, batched
+		//or not, and those keys work as random ones do
+		a25519_nonce(A25519_NONCE_DETERMINISTIC);
+		a25519_sig_sign_batch(algo, sbuf, slen, int_batch, mbuf, mlen, dobuf, dolen);
+		for(i = 0; i < int_batch; i++){
+			a25519_sig_sign(algo, sbuf, slen, mbuf[i], mlen[i], &tbuf, &tlen);
+			if( dobuf[i] == NULL || tlen != dolen[i] || memcmp(tbuf, dobuf[i], tlen) != 0 ){
+				lerror("Deterministic signature %u differs (algo %u)\n", i, algo);
+				rc = 1;
+			}
+			if( (a25519_sig_verify(algo, pbuf, plen, mbuf[i], mlen[i], tbuf, tlen) != 0) != (wrc[i] != 0) ){
+				lerror("Deterministic signature %u does not verify alike (algo %u)\n", i, algo);
+				rc = 1;
+			}
+			free(tbuf);
+		}
+		if( identify(algo, pbuf, plen, mbuf[0], mlen[0], dobuf[0], dolen[0]) != 0 ){
+			lerror("Identification with a deterministic key failed (algo %u)\n", algo);
+			rc = 1;
+		}
+		for(i = 0; i < int_batch; i++) free(dobuf[i]);
+		a25519_nonce(A25519_NONCE_RANDOM);
+		//while random ones never repeat
+		if( olen[0] == solen[0] && memcmp(obuf[0], sobuf[0], olen[0]) == 0 ){
+			lerror("Random signatures repeat (algo %u)\n", algo);
+			rc = 1;
+		}
+
+		printf("algo %u: %u batch keys identified, %d of %u verify failed\n",
+			algo, int_batch, bad, int_batch);
+
+		for(i = 0; i < int_batch; i++){
+			free(obuf[i]);
+			free(sobuf[i]);
+		}
+		free(pbuf);
+		free(sbuf);
+	}
+
+	for(i = 0; i < int_batch; i++) free(mbuf[i]);
+	return rc;
+}
@@ -0,0 +1,85 @@
+/*
+ * Final Year Project scheme
+ * ToraNova 2019
+ * chia_jason96@live.com
+ * wall-clock identification benchmark (prover and verifier on loopback)
+*/
+#include "../id2.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#define PORT 8051
+
+#define str_teststr "alice@example.com"
+
+static void usage(const char *prog){
+	lerror("usage: %s <algo> [-n count|-d seconds] [-w warmup] [-p port] [-j]\n\n"
+		"  -n  timed runs (overrides -d)\n"
+		"  -d  seconds to run (default 5)\n"
+		"  -w  untimed warmup runs (default 100)\n"
+		"  -p  loopback port (default %d)\n"
+		"  -j  report as JSON lines\n", prog, PORT);
+}
+
+int main(int argc, char *argv[]){
+	int rc, vrc, port, opt; unsigned int algo;
+	unsigned char *pbuf, *sbuf, *obuf;
+	size_t plen, slen, olen;
+	struct a25519_benchopt bopt;
+	pid_t vpid;
+
+	if(argc < 2){ usage(argv[0]); return 1; }
+	algo = strtol(argv[1],NULL,10);
+	port = PORT;
+	a25519_test_benchopt_init(&bopt);
+
+	optind = 2;
+	while( (opt = getopt(argc, argv, "n:d:w:p:j")) != -1 ){
+		switch(opt){
+			case 'n': bopt.count = strtoul(optarg,NULL,10); break;
+			case 'd': bopt.duration = strtoul(optarg,NULL,10); break;
+			case 'w': bopt.warmup = strtoul(optarg,NULL,10); break;
+			case 'p': port = strtol(optarg,NULL,10); break;
+			case 'j': bopt.json = 1; break;
+			default: usage(argv[0]); return 1;
+		}
+	}
+
+	if(id2_initialize()){
+		lerror("Unable to initialize libsodium\n");
+		return 1;
+	}
+
+	//key material is made in memory, nothing touches the disk
+	if( a25519_keygen(algo, &pbuf, &plen, &sbuf, &slen) != 0 ){
+		lerror("Setup Error (algo %u)\n", algo);
+		return 1;
+	}
+	if( a25519_sig_sign(algo, sbuf, slen, (unsigned char *)str_teststr,
+		strlen(str_teststr), &obuf, &olen) != 0 ){
+		lerror("Extract Error (algo %u)\n", algo);
+		return 1;
+	}
+
+	//verifier in a child, it exits once the prover closes
+	vpid = fork();
+	if(vpid < 0){ lerror("fork failed\n"); return 1; }
+	if(vpid == 0){
+		rc = a25519_test_bverify(algo, pbuf, plen, port, &bopt);
+		_exit(rc);
+	}
+
+	rc = a25519_test_bprove(algo, (unsigned char *)str_teststr, strlen(str_teststr),
+		obuf, olen, "127.0.0.1", port, &bopt);
+
+	waitpid(vpid, &vrc, 0);
+	if(!WIFEXITED(vrc) || WEXITSTATUS(vrc) != 0) rc = 1;
+
+	free(pbuf);
+	free(sbuf);
+	free(obuf);
+	return rc;
+}
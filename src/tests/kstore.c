@@ -0,0 +1,171 @@
+/*
+ * Final Year Project scheme
+ * ToraNova 2019
+ * chia_jason96@live.com
+ * keystore build, lookup by ID, archive conversion and refusal of damaged stores
+*/
+#include "../id2.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define int_ids 3000
+#define int_idmax 40
+#define str_store "kstore.test"
+#define str_store2 "kstore2.test"
+#define str_archive "kstore.b64.test"
+
+//export to a base64 archive and import it back, key for key the same
+static int roundtrip(struct kstore *ks, unsigned char **mbuf, size_t *mlen){
+	struct kconv_stat st;
+	struct kstore *back;
+	const unsigned char *k1, *k2;
+	unsigned int i, bad = 0;
+	FILE *f;
+
+	if( kconv_export(str_store, str_archive, &st) != 0 || st.keys != int_ids ) return 1;
+	if( kconv_import(str_archive, str_store2, kstore_algo(ks), 3, &st) != 0 || st.keys != int_ids ) return 1;
+	back = kstore_open(str_store2);
+	if( back == NULL || kstore_recsz(back) != kstore_recsz(ks) ) return 1;
+	for(i = 0; i < int_ids; i++){
+		k1 = kstore_find(ks, mbuf[i], mlen[i]);
+		k2 = kstore_find(back, mbuf[i], mlen[i]);
+		if( k1 == NULL || k2 == NULL || memcmp(k1, k2, kstore_recsz(ks)) != 0 ) bad++;
+	}
+	kstore_close(back);
+	printf("archive round trip: %u keys, %u bad\n", int_ids, bad);
+
+	//a damaged line fails the import
+	f = fopen(str_archive, "r+b");
+	if( f != NULL ){
+		fseek(f, (long)mlen[0] + 3, SEEK_SET);
+		fputc('*', f);
+		fclose(f);
+	}
+	if( kconv_import(str_archive, str_store2, kstore_algo(ks), 3, &st) == 0 ) bad++;
+	//and leaves no store that opens
+	if( (back = kstore_open(str_store2)) != NULL ){
+		lerror("Keystore of a damaged archive opened\n");
+		kstore_close(back);
+		bad++;
+	}
+	unlink(str_archive);
+	unlink(str_store2);
+	return bad != 0;
+}
+
+int main(int argc, char *argv[]){
+	unsigned char *mbuf[int_ids], *pbuf, *sbuf;
+	const unsigned char *key, *id;
+	size_t mlen[int_ids], plen, slen, idlen;
+	unsigned int algos[3] = { A25519_TNC, A25519_SCHNORR, A25519_RESETSCHNORR };
+	unsigned int a, i, bad;
+	struct kstore *ks;
+	struct kconv_stat kst;
+	FILE *f;
+	int rc = 0;
+
+	if(id2_initialize()){
+		lerror("Unable to initialize libsodium\n");
+		return 1;
+	}
+
+	for(i = 0; i < int_ids; i++){
+		mbuf[i] = (unsigned char *)malloc(int_idmax);
+		mlen[i] = (size_t)snprintf((char *)mbuf[i], int_idmax, "user%u@example.com", i * 7919u);
+	}
+
+	for(a = 0; a < 3; a++){
+		if( a25519_keygen(algos[a], &pbuf, &plen, &sbuf, &slen) != 0 ){
+			lerror("Setup Error (algo %u)\n", algos[a]);
+			return 1;
+		}
+		if( a25519_sig_sign_store(algos[a], sbuf, slen, int_ids, mbuf, mlen, int_idmax, str_store) != 0 ){
+			lerror("Keystore build failed (algo %u)\n", algos[a]);
+			return 1;
+		}
+		ks = kstore_open(str_store);
+		if( ks == NULL || kstore_algo(ks) != algos[a] || kstore_count(ks) != int_ids ){
+			lerror("Keystore does not open as built (algo %u)\n", algos[a]);
+			return 1;
+		}
+
+		//every ID finds its own record, and its key checks out in place
+		bad = 0;
+		for(i = 0; i < int_ids; i++){
+			key = kstore_find(ks, mbuf[i], mlen[i]);
+			if( key == NULL || kstore_at(ks, i, &id, &idlen) != key ||
+				idlen != mlen[i] || memcmp(id, mbuf[i], idlen) != 0 ){
+				bad++; continue;
+			}
+			if( algos[a] != A25519_RESETSCHNORR && a25519_sig_verify(algos[a], pbuf, plen,
+				mbuf[i], mlen[i], (unsigned char *)key, kstore_recsz(ks)) != 0 ) bad++;
+		}
+		//nor does anything that is not an ID in it
+		if( kstore_find(ks, mbuf[0], mlen[0] - 1) != NULL ||
+			kstore_find(ks, (const unsigned char *)"nobody", 6) != NULL ) bad++;
+		printf("algo %u: %u keys of %zu bytes, %u bad\n", algos[a], int_ids, kstore_recsz(ks), bad);
+		if(bad) rc = 1;
+		if( algos[a] == A25519_TNC && roundtrip(ks, mbuf, mlen) != 0 ){
+			lerror("Archive round trip failed\n");
+			rc = 1;
+		}
+		kstore_close(ks);
+
+		free(pbuf);
+		free(sbuf);
+	}
+
+	//an ID given twice or one too long fails the build, and leaves no store
+	a25519_keygen(A25519_TNC, &pbuf, &plen, &sbuf, &slen);
+	memcpy(mbuf[1], mbuf[0], mlen[0]); mlen[1] = mlen[0];
+	ks = NULL;
+	if( a25519_sig_sign_store(A25519_TNC, sbuf, slen, 2, mbuf, mlen, int_idmax, str_store) == 0 ||
+		(ks = kstore_open(str_store)) != NULL ){
+		lerror("Duplicate ID accepted\n");
+		kstore_close(ks);
+		rc = 1;
+	}
+	ks = NULL;
+	if( a25519_sig_sign_store(A25519_TNC, sbuf, slen, 1, mbuf, mlen, mlen[0] - 1, str_store) == 0 ||
+		(ks = kstore_open(str_store)) != NULL ){
+		lerror("Overlong ID accepted\n");
+		kstore_close(ks);
+		rc = 1;
+	}
+
+	//an ID holding a TAB is kept in a store but refused by the archive
+	memcpy(mbuf[1], "two\tcolumns", 11); mlen[1] = 11;
+	if( a25519_sig_sign_store(A25519_TNC, sbuf, slen, 1, mbuf + 1, mlen + 1, int_idmax, str_store) != 0 ||
+		kconv_export(str_store, str_archive, &kst) == 0 || access(str_archive, F_OK) == 0 ){
+		lerror("ID with a TAB archived\n");
+		unlink(str_archive);
+		rc = 1;
+	}
+	free(pbuf);
+	free(sbuf);
+
+	//a cut short or overwritten store is refused
+	a25519_keygen(A25519_TNC, &pbuf, &plen, &sbuf, &slen);
+	a25519_sig_sign_store(A25519_TNC, sbuf, slen, 64, mbuf + 2, mlen + 2, int_idmax, str_store);
+	if( truncate(str_store, 1000) != 0 || (ks = kstore_open(str_store)) != NULL ){
+		lerror("Truncated keystore opened\n");
+		kstore_close(ks);
+		rc = 1;
+	}
+	a25519_sig_sign_store(A25519_TNC, sbuf, slen, 64, mbuf + 2, mlen + 2, int_idmax, str_store);
+	f = fopen(str_store, "r+b");
+	if( f != NULL ){ fputc('X', f); fclose(f); }
+	if( (ks = kstore_open(str_store)) != NULL ){
+		lerror("Keystore without its magic opened\n");
+		kstore_close(ks);
+		rc = 1;
+	}
+	free(pbuf);
+	free(sbuf);
+
+	unlink(str_store);
+	for(i = 0; i < int_ids; i++) free(mbuf[i]);
+	return rc;
+}
@@ -0,0 +1,133 @@
+/*
+ * Final Year Project scheme
+ * ToraNova 2019
+ * chia_jason96@live.com
+ * open-loop load generator against a verifier server
+*/
+#include "../id2.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#define PORT 8051
+
+#define str_idfile 	"id.txt"
+#define str_uskfile 	"user.key"
+#define str_teststr	"alice@example.com"
+
+static void usage(const char *prog){
+	lerror("usage: %s <algo> [-L] [-s server] [-p port] [-r rate] [-d seconds]\n"
+		"       [-c maxconn] [-t threads] [-T timeout_ms] [-w workers] [-m port] [-C bytes] [-j]\n\n"
+		"  -L  start a local verifier (in-memory keys, admission limits lifted),\n"
+		"      otherwise prove with %s/%s against the server\n"
+		"  -w  worker threads of the local verifier\n"
+		"  -m  serve the local verifier's metrics on 127.0.0.1:port/metrics\n"
+		"  -C  verifier cache of the local verifier (tnc and sch, repeat logins)\n", prog, str_idfile, str_uskfile);
+}
+
+static void quiet_callback(int rc, int csock, const unsigned char *mbuffer, size_t mlen){
+	return;
+}
+
+int main(int argc, char *argv[]){
+	int rc, opt, local = 0, workers = -1, mport = 0, port = PORT;
+	size_t vcbytes = 0;
+	const char *srv = "127.0.0.1";
+	unsigned int algo;
+	unsigned char *pbuf, *sbuf, *obuf, *mbuf;
+	size_t plen, slen, olen, mlen;
+	FILE *idfile, *uskfile;
+	struct a25519_loadopt lopt;
+	struct a25519_srvopt sopt;
+	struct rlimit rl;
+	pid_t vpid = 0;
+
+	if(argc < 2){ usage(argv[0]); return 1; }
+	algo = strtol(argv[1],NULL,10);
+	a25519_test_loadopt_init(&lopt);
+
+	optind = 2;
+	while( (opt = getopt(argc, argv, "Ls:p:r:d:c:t:T:w:m:C:j")) != -1 ){
+		switch(opt){
+			case 'L': local = 1; break;
+			case 's': srv = optarg; break;
+			case 'p': port = strtol(optarg,NULL,10); break;
+			case 'r': lopt.rate = strtoul(optarg,NULL,10); break;
+			case 'd': lopt.duration = strtoul(optarg,NULL,10); break;
+			case 'c': lopt.maxconn = strtoul(optarg,NULL,10); break;
+			case 't': lopt.threads = strtoul(optarg,NULL,10); break;
+			case 'T': lopt.timeout = strtol(optarg,NULL,10); break;
+			case 'w': workers = strtol(optarg,NULL,10); break;
+			case 'm': mport = strtol(optarg,NULL,10); break;
+			case 'C': vcbytes = strtoul(optarg,NULL,10); break;
+			case 'j': lopt.json = 1; break;
+			default: usage(argv[0]); return 1;
+		}
+	}
+
+	if(id2_initialize()){
+		lerror("Unable to initialize libsodium\n");
+		return 1;
+	}
+
+	//thousands of connections need the descriptors
+	if(getrlimit(RLIMIT_NOFILE, &rl) == 0){
+		rl.rlim_cur = rl.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &rl);
+	}
+
+	if(local){
+		if( a25519_keygen(algo, &pbuf, &plen, &sbuf, &slen) != 0 ){
+			lerror("Setup Error (algo %u)\n", algo);
+			return 1;
+		}
+		mlen = strlen(str_teststr);
+		mbuf = (unsigned char *)malloc(mlen);
+		memcpy(mbuf, str_teststr, mlen);
+		a25519_sig_sign(algo, sbuf, slen, mbuf, mlen, &obuf, &olen);
+		free(sbuf);
+
+		//the verifier is what is being measured, let it take the load
+		a25519_ibi_srvopt_init(&sopt);
+		if(workers >= 0) sopt.workers = workers;
+		sopt.maxcq = 4096;
+		sopt.maxsess = lopt.maxconn;
+		sopt.rate = 0;
+		sopt.metrics_port = mport;
+		sopt.vcache_bytes = vcbytes;
+		vpid = fork();
+		if(vpid < 0){ lerror("fork failed\n"); return 1; }
+		if(vpid == 0){
+			a25519_ibi_pserver(algo, pbuf, plen, port, &sopt, quiet_callback);
+			_exit(1);
+		}
+		free(pbuf);
+		usleep(200000);
+		srv = "127.0.0.1";
+	}else{
+		idfile = fopen( str_idfile, "r");
+		uskfile = fopen( str_uskfile, "r");
+		if( idfile == NULL || uskfile == NULL ){
+			lerror("Missing %s/%s\n",str_idfile,str_uskfile);
+			return 1;
+		}
+		obuf = read_b64( uskfile, &olen );
+		mbuf = (unsigned char *) fileread( idfile, &mlen );
+		fclose(idfile);
+		fclose(uskfile);
+	}
+
+	rc = a25519_test_loadgen(algo, mbuf, mlen, obuf, olen, srv, port, &lopt);
+
+	if(vpid > 0){
+		kill(vpid, SIGTERM);
+		waitpid(vpid, NULL, 0);
+	}
+	free(obuf);
+	free(mbuf);
+	return rc;
+}
@@ -0,0 +1,71 @@
+/*
+ * Final Year Project scheme
+ * ToraNova 2019
+ * chia_jason96@live.com
+ * per-operation and in-process protocol microbenchmarks of every scheme
+*/
+#include "../id2.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#define int_testcnt 1000
+
+//glibc's allocator proper, the definitions below interpose on it for
+//the library and libsodium as well
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+
+static unsigned long long nalloc;
+
+void *malloc(size_t sz){
+	__atomic_add_fetch(&nalloc, 1, __ATOMIC_RELAXED);
+	return __libc_malloc(sz);
+}
+
+void *calloc(size_t n, size_t sz){
+	__atomic_add_fetch(&nalloc, 1, __ATOMIC_RELAXED);
+	return __libc_calloc(n, sz);
+}
+
+void *realloc(void *p, size_t sz){
+	__atomic_add_fetch(&nalloc, 1, __ATOMIC_RELAXED);
+	return __libc_realloc(p, sz);
+}
+
+static unsigned long long allocs(void){
+	return __atomic_load_n(&nalloc, __ATOMIC_RELAXED);
+}
+
+int main(int argc, char *argv[]){
+	unsigned int count = int_testcnt;
+	int json = 0, proto = 0, det = 0, sys = 0, opt;
+
+	while( (opt = getopt(argc, argv, "n:ijDS")) != -1 ){
+		switch(opt){
+			case 'n': count = strtoul(optarg,NULL,10); break;
+			case 'i': proto = 1; break;
+			case 'j': json = 1; break;
+			case 'D': det = 1; break;
+			case 'S': sys = 1; break;
+			default:
+				lerror("usage: %s [-n iterations] [-i] [-j] [-D] [-S]\n\n"
+					"  -i  complete identifications (socketpair and memory)\n"
+					"      instead of single operations\n"
+					"  -D  deterministic signature nonces\n"
+					"  -S  nonces and challenges from the system generator\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if(id2_initialize()){
+		lerror("Unable to initialize libsodium\n");
+		return 1;
+	}
+
+	if(det) a25519_nonce(A25519_NONCE_DETERMINISTIC);
+	if(sys) a25519_rng(A25519_RNG_SYSTEM);
+	if(proto) return a25519_test_inproc(count, json, allocs);
+	return a25519_test_microbench(count, json, allocs);
+}
@@ -0,0 +1,154 @@
+/*
+ * Final Year Project scheme
+ * ToraNova 2019
+ * chia_jason96@live.com
+ * the buffered generator apart across threads and forks, and its cost (-b)
+*/
+#include "../id2.h"
+#include "../utils/mclock.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#define int_threads 4
+#define int_draw 64		//one scalar's worth
+#define int_benchcnt 1000000
+
+static unsigned char tout[int_threads][int_draw];
+
+static void *draw(void *arg){
+	a25519_randombytes((unsigned char *)arg, int_draw);
+	return NULL;
+}
+
+//a draw through a fork: the child must not repeat what the parent draws next
+static int forked(void){
+	unsigned char p[int_draw], c[int_draw];
+	int fd[2], st;
+	pid_t pid;
+
+	if(pipe(fd) != 0) return 1;
+	a25519_randombytes(p, int_draw);	//the parent's stream is in use
+	pid = fork();
+	if(pid < 0) return 1;
+	if(pid == 0){
+		a25519_randombytes(c, int_draw);
+		_exit(write(fd[1], c, int_draw) == int_draw ? 0 : 1);
+	}
+	a25519_randombytes(p, int_draw);
+	if(read(fd[0], c, int_draw) != int_draw) return 1;
+	waitpid(pid, &st, 0);
+	close(fd[0]); close(fd[1]);
+	return memcmp(p, c, int_draw) == 0;
+}
+
+static double nsper(uint64_t ns, unsigned long n){
+	return (double)ns / (double)n;
+}
+
+//per draw of len bytes, the system generator then the buffered one
+static void bench(unsigned long n, size_t len){
+	unsigned char b[256];
+	uint64_t t0, ts, tb;
+	unsigned long i;
+
+	a25519_rng(A25519_RNG_SYSTEM);
+	t0 = mclock_ns();
+	for(i = 0; i < n; i++) a25519_randombytes(b, len);
+	ts = mclock_ns() - t0;
+	a25519_rng(A25519_RNG_BUFFERED);
+	t0 = mclock_ns();
+	for(i = 0; i < n; i++) a25519_randombytes(b, len);
+	tb = mclock_ns() - t0;
+	printf("%3lu bytes: system %8.1f ns  buffered %8.1f ns  (%.1fx)\n",
+		len, nsper(ts, n), nsper(tb, n), (double)ts / (double)tb);
+}
+
+int main(int argc, char *argv[]){
+	unsigned char a[int_draw], b[int_draw], *big;
+	unsigned long n = int_benchcnt;
+	pthread_t thr[int_threads];
+	size_t i, j, len;
+	int run = 0, rc = 0, opt;
+
+	while( (opt = getopt(argc, argv, "bn:")) != -1 ){
+		switch(opt){
+			case 'b': run = 1; break;
+			case 'n': n = strtoul(optarg,NULL,10); break;
+			default:
+				lerror("usage: %s [-b] [-n draws]\n\n"
+					"  -b  time the buffered generator against the system one\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if(id2_initialize()){
+		lerror("Unable to initialize libsodium\n");
+		return 1;
+	}
+
+	if(run){
+		bench(n, 32);
+		bench(n, 64);
+		bench(n, 128);
+		return 0;
+	}
+
+	if(a25519_rng(-1) != A25519_RNG_BUFFERED){
+		lerror("The buffered generator is not the default\n");
+		rc = 1;
+	}
+
+	//draws follow on from one another
+	a25519_randombytes(a, int_draw);
+	a25519_randombytes(b, int_draw);
+	if(memcmp(a, b, int_draw) == 0){
+		lerror("Consecutive draws repeat\n");
+		rc = 1;
+	}
+
+	//every thread has a stream of its own
+	for(i = 0; i < int_threads; i++) pthread_create(&thr[i], NULL, draw, tout[i]);
+	for(i = 0; i < int_threads; i++) pthread_join(thr[i], NULL);
+	for(i = 0; i < int_threads; i++){
+		if(memcmp(tout[i], a, int_draw) == 0 || memcmp(tout[i], b, int_draw) == 0) rc = 1;
+		for(j = 0; j < i; j++) if(memcmp(tout[i], tout[j], int_draw) == 0) rc = 1;
+	}
+	if(rc) lerror("Threads share a stream\n");
+
+	if(forked() != 0){
+		lerror("A forked child repeats its parent\n");
+		rc = 1;
+	}
+
+	//past the reseed in odd pieces, refills land mid draw
+	len = (17 << 20) + 3;
+	big = (unsigned char *)calloc(len, 1);
+	for(i = 0; i < len; i += j){
+		j = len - i < 4093 ? len - i : 4093;
+		a25519_randombytes(big + i, j);
+	}
+	for(i = 0, j = 0; i < len; i++) j += big[i] == 0;
+	//a stretch of zeroes would be a block left unfilled
+	if(j > len / 128){
+		lerror("%lu of %lu bytes drawn are zero\n", j, len);
+		rc = 1;
+	}
+	free(big);
+
+	//the system generator still serves on request
+	if(a25519_rng(A25519_RNG_SYSTEM) != A25519_RNG_BUFFERED || a25519_rng(-1) != A25519_RNG_SYSTEM){
+		lerror("The generator mode does not stick\n");
+		rc = 1;
+	}
+	a25519_randombytes(a, int_draw);
+	a25519_randombytes(b, int_draw);
+	if(memcmp(a, b, int_draw) == 0) rc = 1;
+	a25519_rng(A25519_RNG_BUFFERED);
+
+	if(rc == 0) printf("%d threads, a fork and %lu bytes drawn apart\n", int_threads, len);
+	return rc;
+}
@@ -0,0 +1,52 @@
+/*
+ * Final Year Project scheme
+ * ToraNova 2019
+ * chia_jason96@live.com
+ * identification latency of every scheme across round trip times
+*/
+#include "../id2.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define int_testcnt 10
+#define str_rtts "0,1,10,50,100"
+
+int main(int argc, char *argv[]){
+	unsigned int count = int_testcnt;
+	char *rtts = NULL, *tok, *save;
+	struct a25519_linkopt lo;
+	int json = 0, rc = 0, opt;
+
+	memset(&lo, 0, sizeof(lo));
+	while( (opt = getopt(argc, argv, "n:r:J:b:j")) != -1 ){
+		switch(opt){
+			case 'n': count = strtoul(optarg,NULL,10); break;
+			case 'r': rtts = optarg; break;
+			case 'J': lo.jitter_us = (unsigned int)(strtod(optarg,NULL) * 1000); break;
+			case 'b': lo.bandwidth = strtoull(optarg,NULL,10) * 1000ULL; break;
+			case 'j': json = 1; break;
+			default:
+				lerror("usage: %s [-n count] [-r rtt_ms,...] [-J jitter_ms] [-b kbit/s] [-j]\n\n"
+					"  -r  round trip times to run (default %s)\n"
+					"  -J  one-way jitter, uniform +/-\n"
+					"  -b  bandwidth each way (default unlimited)\n", argv[0], str_rtts);
+				return 1;
+		}
+	}
+
+	if(id2_initialize()){
+		lerror("Unable to initialize libsodium\n");
+		return 1;
+	}
+
+	rtts = strdup(rtts != NULL ? rtts : str_rtts);
+	for(tok = strtok_r(rtts, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)){
+		//the link delays each way by half the round trip
+		lo.delay_us = (unsigned int)(strtod(tok,NULL) * 500);
+		rc |= a25519_test_rtt(count, json, &lo);
+	}
+	free(rtts);
+	return rc;
+}
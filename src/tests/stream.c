@@ -0,0 +1,130 @@
+/*
+ * Final Year Project scheme
+ * ToraNova 2019
+ * chia_jason96@live.com
+ * IDs signed and verified piece by piece, and from a file, as they are whole
+*/
+#include "../id2.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define int_idlen ((3 << 20) + 77)	//over a few read chunks, not a multiple of them
+
+static const size_t pieces[] = { 1, 7, 128, 1000, 65536 };
+
+//the ID through a signing session, pieces of every size in turn
+static int sign_pieces(unsigned int algo, unsigned char *sbuf, size_t slen,
+	const unsigned char *mbuf, size_t mlen, unsigned char **obuf, size_t *olen){
+	struct a25519_sigsess *s = a25519_sig_sign_init(algo, sbuf, slen);
+	size_t i, n, p = 0;
+	if(s == NULL) return 1;
+	for(i = 0; i < mlen; i += n){
+		n = pieces[p++ % (sizeof(pieces) / sizeof(pieces[0]))];
+		if(n > mlen - i) n = mlen - i;
+		a25519_sig_update(s, mbuf + i, n);
+	}
+	return a25519_sig_sign_final(s, obuf, olen);
+}
+
+static int verify_pieces(unsigned int algo, unsigned char *pbuf, size_t plen,
+	const unsigned char *mbuf, size_t mlen, unsigned char *obuf, size_t olen){
+	struct a25519_sigsess *s = a25519_sig_verify_init(algo, pbuf, plen);
+	size_t i, n;
+	if(s == NULL) return 1;
+	for(i = 0; i < mlen; i += n){
+		n = mlen - i < 4093 ? mlen - i : 4093;
+		a25519_sig_update(s, mbuf + i, n);
+	}
+	return a25519_sig_verify_final(s, obuf, olen);
+}
+
+int main(int argc, char *argv[]){
+	unsigned char *mbuf, *pbuf, *sbuf, *obuf, *tbuf;
+	size_t mlen, plen, slen, olen, tlen, i;
+	char path[] = "/tmp/a25519streamXXXXXX";
+	unsigned int algo;
+	int rc = 0, fd, ok;
+
+	if(id2_initialize()){
+		lerror("Unable to initialize libsodium\n");
+		return 1;
+	}
+
+	mlen = int_idlen;
+	mbuf = (unsigned char *)malloc(mlen);
+	for(i = 0; i < mlen; i++) mbuf[i] = (unsigned char)(i * 131 + (i >> 9));
+	fd = mkstemp(path);
+	if(fd < 0 || write(fd, mbuf, mlen) != (ssize_t)mlen){
+		lerror("Unable to write %s\n", path);
+		return 1;
+	}
+	unlink(path);
+
+	for(algo = 0; algo < 7; algo++){
+		if(algo == 1) continue;
+		if( a25519_keygen(algo, &pbuf, &plen, &sbuf, &slen) != 0 ){
+			lerror("Setup Error (algo %u)\n", algo);
+			return 1;
+		}
+
+		//deterministic nonces, so a streamed signature must match byte for byte
+		a25519_nonce(A25519_NONCE_DETERMINISTIC);
+		a25519_sig_sign(algo, sbuf, slen, mbuf, mlen, &obuf, &olen);
+		if( sign_pieces(algo, sbuf, slen, mbuf, mlen, &tbuf, &tlen) != 0 ||
+			tlen != olen || memcmp(tbuf, obuf, olen) != 0 ){
+			lerror("Streamed signature differs (algo %u)\n", algo);
+			rc = 1;
+		}
+		free(tbuf);
+		lseek(fd, 0, SEEK_SET);
+		if( a25519_sig_sign_fd(algo, sbuf, slen, fd, &tbuf, &tlen) != 0 ||
+			tlen != olen || memcmp(tbuf, obuf, olen) != 0 ){
+			lerror("Signature from a file differs (algo %u)\n", algo);
+			rc = 1;
+		}
+		free(tbuf);
+		a25519_nonce(A25519_NONCE_RANDOM);
+
+		//verification agrees with the one shot call, right ID or not
+		ok = a25519_sig_verify(algo, pbuf, plen, mbuf, mlen, obuf, olen) == 0;
+		if( (verify_pieces(algo, pbuf, plen, mbuf, mlen, obuf, olen) == 0) != ok ){
+			lerror("Streamed verification disagrees (algo %u)\n", algo);
+			rc = 1;
+		}
+		lseek(fd, 0, SEEK_SET);
+		if( (a25519_sig_verify_fd(algo, pbuf, plen, fd, obuf, olen) == 0) != ok ){
+			lerror("Verification from a file disagrees (algo %u)\n", algo);
+			rc = 1;
+		}
+		if( verify_pieces(algo, pbuf, plen, mbuf, mlen - 1, obuf, olen) == 0 ){
+			lerror("Streamed verification accepted a wrong ID (algo %u)\n", algo);
+			rc = 1;
+		}
+		if( verify_pieces(algo, pbuf, plen, mbuf, mlen, obuf, olen - 1) == 0 ){
+			lerror("Streamed verification accepted a short signature (algo %u)\n", algo);
+			rc = 1;
+		}
+
+		//random nonces sign alike, the streamed key verifies as a whole one
+		sign_pieces(algo, sbuf, slen, mbuf, mlen, &tbuf, &tlen);
+		if( (a25519_sig_verify(algo, pbuf, plen, mbuf, mlen, tbuf, tlen) == 0) != ok ){
+			lerror("Streamed signature does not verify alike (algo %u)\n", algo);
+			rc = 1;
+		}
+		free(tbuf);
+
+		//an abandoned session
+		a25519_sig_free(a25519_sig_sign_init(algo, sbuf, slen));
+
+		printf("algo %u: %lu byte ID streamed, verify %s\n", algo, mlen, ok ? "ok" : "fails (scheme)");
+		free(obuf);
+		free(pbuf);
+		free(sbuf);
+	}
+
+	close(fd);
+	free(mbuf);
+	return rc;
+}
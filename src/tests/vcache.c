@@ -0,0 +1,182 @@
+/*
+ * Final Year Project scheme
+ * ToraNova 2019
+ * chia_jason96@live.com
+ * the verifier cache answers repeat logins alike, never a wrong key
+*/
+#include "../id2.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#define int_ids 12
+#define int_cache (64*1024)
+
+struct prover{
+	unsigned int algo;
+	unsigned char *mbuf;
+	size_t mlen;
+	unsigned char *obuf;
+	size_t olen;
+	int sock;
+};
+
+static void *prove(void *arg){
+	struct prover *p = (struct prover *)arg;
+	a25519_ibi_prove(p->algo, p->mbuf, p->mlen, p->obuf, p->olen, p->sock);
+	return NULL;
+}
+
+static volatile int stop;
+
+//keep resizing the cache under the verifiers
+static void *resizer(void *arg){
+	size_t sz[3] = { int_cache, 1, 0 };
+	unsigned int i = 0;
+	(void)arg;
+	while(!stop) a25519_vcache(sz[i++ % 3]);
+	return NULL;
+}
+
+//drive a non-blocking verifier session to the end
+static int nbverify(unsigned int algo, unsigned char *pbuf, size_t plen, int sock){
+	struct a25519_nbsess *s;
+	struct pollfd pf;
+	int r;
+	fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+	s = a25519_ibi_nbverify(algo, pbuf, plen, sock);
+	if(s == NULL) return 1;
+	pf.fd = sock;
+	while( (r = a25519_ibi_nbstep(s)) != A25519_NB_DONE && r != A25519_NB_ERROR ){
+		pf.events = r == A25519_NB_WANTWR ? POLLOUT : POLLIN;
+		poll(&pf, 1, 5000);
+	}
+	r = r == A25519_NB_DONE ? a25519_ibi_nbresult(s, NULL, NULL) : 1;
+	a25519_ibi_nbfree(s);
+	return r;
+}
+
+//identification of mbuf with the user key obuf, blocking or not
+static int identify(unsigned int algo, int nb, unsigned char *pbuf, size_t plen,
+	unsigned char *mbuf, size_t mlen, unsigned char *obuf, size_t olen){
+	int sv[2], rc;
+	unsigned char *rbuf = NULL;
+	size_t rlen = 0;
+	pthread_t thr;
+	struct prover p;
+
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) return 1;
+	p.algo = algo; p.mbuf = mbuf; p.mlen = mlen;
+	p.obuf = obuf; p.olen = olen; p.sock = sv[0];
+	pthread_create(&thr, NULL, prove, &p);
+	if(nb){
+		rc = nbverify(algo, pbuf, plen, sv[1]);
+	}else{
+		rc = a25519_ibi_verify(algo, pbuf, plen, &rbuf, &rlen, sv[1]);
+		free(rbuf);
+	}
+	pthread_join(thr, NULL);
+	close(sv[0]); close(sv[1]);
+	return rc;
+}
+
+//every ID identifies with its own key, none with its neighbour's
+static int rounds(unsigned int algo, unsigned char *pbuf, size_t plen,
+	unsigned char **mbuf, size_t *mlen, unsigned char **obuf, size_t *olen){
+	unsigned int i, j;
+	int rc = 0;
+	for(j = 0; j < 4; j++){
+		for(i = 0; i < int_ids; i++){
+			if( identify(algo, j & 1, pbuf, plen, mbuf[i], mlen[i], obuf[i], olen[i]) != 0 ){
+				lerror("Identification %u failed in round %u (algo %u)\n", i, j, algo);
+				rc = 1;
+			}
+			if( identify(algo, j & 1, pbuf, plen, mbuf[i], mlen[i],
+				obuf[(i + 1) % int_ids], olen[(i + 1) % int_ids]) == 0 ){
+				lerror("Identification %u passed with a wrong key (algo %u)\n", i, algo);
+				rc = 1;
+			}
+		}
+	}
+	return rc;
+}
+
+int main(int argc, char *argv[]){
+	unsigned char *mbuf[int_ids], *obuf[int_ids];
+	size_t mlen[int_ids], olen[int_ids];
+	unsigned char *pbuf, *sbuf;
+	size_t plen, slen;
+	struct a25519_vcstat st0, st;
+	unsigned int algos[2] = { A25519_TNC, A25519_SCHNORR };
+	unsigned int a, i, j;
+	pthread_t thr;
+	int rc = 0;
+
+	if(id2_initialize()){
+		lerror("Unable to initialize libsodium\n");
+		return 1;
+	}
+
+	//the last ID is too long to be cached, it still has to identify
+	for(i = 0; i < int_ids; i++){
+		mlen[i] = i == int_ids - 1 ? 200 : 5 + i * 9;
+		mbuf[i] = (unsigned char *)malloc(mlen[i]);
+		for(j = 0; j < mlen[i]; j++) mbuf[i][j] = (unsigned char)('a' + (i + j) % 26);
+	}
+
+	for(a = 0; a < 2; a++){
+		if( a25519_keygen(algos[a], &pbuf, &plen, &sbuf, &slen) != 0 ){
+			lerror("Setup Error (algo %u)\n", algos[a]);
+			return 1;
+		}
+		for(i = 0; i < int_ids; i++){
+			a25519_sig_sign(algos[a], sbuf, slen, mbuf[i], mlen[i], &obuf[i], &olen[i]);
+		}
+
+		//roomy, everything but the long ID is a hit after its first login
+		a25519_vcache(int_cache);
+		a25519_vcache_stat(&st0);
+		rc |= rounds(algos[a], pbuf, plen, mbuf, mlen, obuf, olen);
+		a25519_vcache_stat(&st);
+		printf("algo %u: %llu hits %llu misses %llu inserts, %zu of %zu entries\n", algos[a],
+			st.hits - st0.hits, st.misses - st0.misses, st.inserts - st0.inserts,
+			st.entries, st.capacity);
+		if( st.inserts - st0.inserts != int_ids - 1 || st.entries != int_ids - 1 ||
+			st.hits - st0.hits != 3 * (int_ids - 1) ){
+			lerror("Unexpected cache use (algo %u)\n", algos[a]);
+			rc = 1;
+		}
+
+		//a single set, identities keep pushing each other out
+		a25519_vcache(1);
+		a25519_vcache_stat(&st0);
+		rc |= rounds(algos[a], pbuf, plen, mbuf, mlen, obuf, olen);
+		a25519_vcache_stat(&st);
+		printf("algo %u: %llu evictions, %zu of %zu entries\n", algos[a],
+			st.evictions - st0.evictions, st.entries, st.capacity);
+		if( st.evictions == st0.evictions || st.entries > st.capacity ){
+			lerror("Small cache did not evict (algo %u)\n", algos[a]);
+			rc = 1;
+		}
+
+		//resized (and turned off) while identifications run
+		stop = 0;
+		pthread_create(&thr, NULL, resizer, NULL);
+		rc |= rounds(algos[a], pbuf, plen, mbuf, mlen, obuf, olen);
+		stop = 1;
+		pthread_join(thr, NULL);
+
+		a25519_vcache(0);
+		for(i = 0; i < int_ids; i++) free(obuf[i]);
+		free(pbuf);
+		free(sbuf);
+	}
+
+	for(i = 0; i < int_ids; i++) free(mbuf[i]);
+	return rc;
+}
@@ -0,0 +1,93 @@
+/*
+  Allocation accounting
+
+  id2 project
+  chia_jason96@live.com
+*/
+
+#include "alloccount.h"
+#include "config.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifdef ALLOCCOUNT
+
+static __thread struct acount tl;
+
+void *__real_malloc(size_t sz);
+void *__real_calloc(size_t n, size_t sz);
+void *__real_realloc(void *p, size_t sz);
+void *__real_sodium_malloc(size_t sz);
+void *__real_sodium_allocarray(size_t n, size_t sz);
+//operator new, new[] and their nothrow forms (LP64 mangling)
+void *__real__Znwm(size_t sz);
+void *__real__Znam(size_t sz);
+void *__real__ZnwmRKSt9nothrow_t(size_t sz, const void *nt);
+void *__real__ZnamRKSt9nothrow_t(size_t sz, const void *nt);
+
+static inline void count(size_t sz){
+	tl.calls++;
+	tl.bytes += sz;
+}
+
+void *__wrap_malloc(size_t sz){
+	count(sz);
+	return __real_malloc(sz);
+}
+
+void *__wrap_calloc(size_t n, size_t sz){
+	count(n * sz);
+	return __real_calloc(n, sz);
+}
+
+void *__wrap_realloc(void *p, size_t sz){
+	count(sz);
+	return __real_realloc(p, sz);
+}
+
+void *__wrap__Znwm(size_t sz){
+	count(sz);
+	return __real__Znwm(sz);
+}
+
+void *__wrap__Znam(size_t sz){
+	count(sz);
+	return __real__Znam(sz);
+}
+
+void *__wrap__ZnwmRKSt9nothrow_t(size_t sz, const void *nt){
+	count(sz);
+	return __real__ZnwmRKSt9nothrow_t(sz, nt);
+}
+
+void *__wrap__ZnamRKSt9nothrow_t(size_t sz, const void *nt){
+	count(sz);
+	return __real__ZnamRKSt9nothrow_t(sz, nt);
+}
+
+void *__wrap_sodium_malloc(size_t sz){
+	tl.scalls++;
+	tl.sbytes += sz;
+	return __real_sodium_malloc(sz);
+}
+
+void *__wrap_sodium_allocarray(size_t n, size_t sz){
+	tl.scalls++;
+	tl.sbytes += n * sz;
+	return __real_sodium_allocarray(n, sz);
+}
+
+int ac_read(struct acount *out, int reset){
+	if(out != NULL) *out = tl;
+	if(reset) memset(&tl, 0, sizeof(struct acount));
+	return 0;
+}
+
+#else
+
+int ac_read(struct acount *out, int reset){
+	if(out != NULL) memset(out, 0, sizeof(struct acount));
+	return 1;
+}
+
+#endif
@@ -0,0 +1,36 @@
+/*
+  Allocation accounting
+  with ./configure --enable-alloccount the library is linked with
+  -Wl,--wrap for malloc, calloc, realloc, operator new and
+  sodium_malloc/sodium_allocarray, every allocation the library makes
+  itself is counted against the calling thread (libsodium's and the
+  C++ runtime's own allocations are not seen)
+
+  id2 project
+  chia_jason96@live.com
+*/
+#ifndef _ALLOCCOUNT_H_
+#define _ALLOCCOUNT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+	struct acount{
+		uint64_t calls;		//malloc, calloc, realloc, new
+		uint64_t bytes;
+		uint64_t scalls;	//sodium_malloc, sodium_allocarray
+		uint64_t sbytes;
+	};
+
+	//counts of the calling thread, optionally clearing them afterwards
+	//return 1 if accounting is not compiled in (out is zeroed)
+	int ac_read(struct acount *out, int reset);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
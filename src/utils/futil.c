@@ -17,12 +17,20 @@
 //return NULL on fail
 unsigned char *read_b64(FILE *stream, size_t *length){
 	unsigned char *out; char *read;
-	size_t rlen;
+	size_t rlen, n;
 	read = fileread(stream, &rlen);
+	if(read == NULL) return NULL;
 
-	out = b64_decode(read);
-	//*length = strlen((const char *)out); //dont
-	*length = b64_decoded_size(read);
+	//decoded in one pass, straight into a buffer the size of the worst case
+	out = (unsigned char *)malloc(rlen / 4 * 3 + 3);
+	n = out == NULL ? (size_t)-1 : b64_decode_into(out, rlen / 4 * 3 + 2, read, strlen(read));
+	if(n == (size_t)-1){
+		free(out);
+		free(read);
+		return NULL;
+	}
+	out[n] = '\0';
+	*length = n;
 	debug("b64d sz: %lu from %lu b64 chars\n",*length,rlen);
 	free(read);
 	return out;
@@ -0,0 +1,71 @@
+/*
+  Log-linear (HDR style) latency histogram
+
+  id2 project
+  chia_jason96@live.com
+*/
+
+#include "hdrhist.h"
+#include <string.h>
+
+//values below 2^(HH_SUB+1) are exact, above that each power of 2
+//is split into 2^HH_SUB equal buckets
+static size_t hh_index(uint64_t v){
+	unsigned int msb;
+	if(v < (1ULL << (HH_SUB+1))) return (size_t)v;
+	msb = 63 - (unsigned int)__builtin_clzll(v);
+	return ((size_t)(msb - HH_SUB + 1) << HH_SUB) + (size_t)((v >> (msb - HH_SUB)) - (1ULL << HH_SUB));
+}
+
+//highest value that maps to bucket i
+static uint64_t hh_value(size_t i){
+	unsigned int k;
+	uint64_t sub;
+	if(i < ((size_t)2 << HH_SUB)) return (uint64_t)i;
+	k = (unsigned int)(i >> HH_SUB);
+	sub = (uint64_t)(i & ((1 << HH_SUB) - 1));
+	return (((1ULL << HH_SUB) + sub + 1) << (k - 1)) - 1;
+}
+
+void hh_reset(struct hdrhist *h){
+	memset(h, 0, sizeof(struct hdrhist));
+	h->min = UINT64_MAX;
+}
+
+void hh_record(struct hdrhist *h, uint64_t v){
+	h->cnt[hh_index(v)]++;
+	h->n++;
+	h->sum += (double)v;
+	if(v < h->min) h->min = v;
+	if(v > h->max) h->max = v;
+}
+
+void hh_merge(struct hdrhist *dst, const struct hdrhist *src){
+	size_t i;
+	for(i=0;i<HH_BUCKETS;i++) dst->cnt[i] += src->cnt[i];
+	dst->n += src->n;
+	dst->sum += src->sum;
+	if(src->min < dst->min) dst->min = src->min;
+	if(src->max > dst->max) dst->max = src->max;
+}
+
+uint64_t hh_pct(const struct hdrhist *h, double p){
+	uint64_t rank, seen = 0;
+	size_t i;
+	if(h->n == 0) return 0;
+	if(p >= 100.0) return h->max;
+	rank = (uint64_t)(p / 100.0 * (double)h->n);
+	if(rank >= h->n) rank = h->n - 1;
+	for(i=0;i<HH_BUCKETS;i++){
+		seen += h->cnt[i];
+		if(seen > rank){
+			//never report beyond what was actually seen
+			return hh_value(i) < h->max ? hh_value(i) : h->max;
+		}
+	}
+	return h->max;
+}
+
+double hh_mean(const struct hdrhist *h){
+	return h->n == 0 ? 0.0 : h->sum / (double)h->n;
+}
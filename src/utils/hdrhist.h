@@ -0,0 +1,45 @@
+/*
+  Log-linear (HDR style) latency histogram
+  records 64-bit values with ~1% relative precision in fixed memory,
+  for percentile reporting of the benchmarks
+
+  id2 project
+  chia_jason96@live.com
+*/
+#ifndef _HDRHIST_H_
+#define _HDRHIST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+//sub-buckets per power of 2 (2^HH_SUB), precision is 2^-HH_SUB
+#define HH_SUB 7
+#define HH_BUCKETS ((64 - HH_SUB + 1) << HH_SUB)
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+	struct hdrhist{
+		uint64_t cnt[HH_BUCKETS];
+		uint64_t n;	//values recorded
+		uint64_t min, max;
+		double sum;
+	};
+
+	//clear the histogram
+	void hh_reset(struct hdrhist *h);
+	//record a single value
+	void hh_record(struct hdrhist *h, uint64_t v);
+	//add the values of src into dst
+	void hh_merge(struct hdrhist *dst, const struct hdrhist *src);
+	//value at percentile p (0-100), 0 if empty
+	uint64_t hh_pct(const struct hdrhist *h, double p);
+	//arithmetic mean, 0 if empty
+	double hh_mean(const struct hdrhist *h);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -17,38 +17,39 @@
 #include <stdio.h>
 #include <string.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define B64_SIMD 1
+#include <immintrin.h>
+#endif
+
 /*
  * Thank god for these
  */
 //encoding table
 const char b64chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-//decoding table
-const int b64invs[] = { 62, -1, -1, -1, 63, 52, 53, 54, 55, 56, 57, 58,
-	59, 60, 61, -1, -1, -1, -1, -1, -1, -1, 0, 1, 2, 3, 4, 5,
-	6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
-	21, 22, 23, 24, 25, -1, -1, -1, -1, -1, -1, 26, 27, 28,
-	29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42,
-	43, 44, 45, 46, 47, 48, 49, 50, 51 };
+//decoding table, -1 for anything outside the alphabet
+static const signed char b64dec[256] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+	52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+	-1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+	15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+	-1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+	41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
 
-/*
- * This is used to generate the inversion table
- * for speed, we will use the lookup instead of generating one
- * for every decode
- */
-//
-/*
-void b64_generate_decode_table()
-{
-	int    inv[80];
-	size_t i;
-
-	memset(inv, -1, sizeof(inv));
-	for (i=0; i<sizeof(b64chars)-1; i++) {
-		inv[b64chars[i]-43] = i;
-	}
-}
-*/
+//kernel in use, B64_SIMD_* (-1 until first use)
+static int b64level = -1;
 
 //compute b64 size based on input size of byte arr
 //wrap -- how many characters after to insert a line wrap (\n)
@@ -76,10 +77,11 @@ size_t b64_decoded_size(const char *in){
 	size_t i;
 	size_t ret;
 	size_t len = 0;
-	size_t ilen = strlen(in);
+	size_t ilen;
 
 	if (in == NULL)
 		return 0;
+	ilen = strlen(in);
 
 	//calculate length of string WITHOUT newline
 	for(i=0;i < ilen ;i++){
@@ -102,103 +104,290 @@ size_t b64_decoded_size(const char *in){
 	return ret;
 }
 
+/*
+ * vector kernels: whole blocks of 12/24 bytes (SSSE3/AVX2) to 16/32
+ * characters and back, after W. Mula and D. Lemire, "Faster Base64
+ * Encoding and Decoding using AVX2 Instructions". the decoders stop at
+ * the first block holding anything but the alphabet (a line break,
+ * padding, garbage), the scalar code below takes it from there
+ */
+#ifdef B64_SIMD
+
+__attribute__((target("ssse3")))
+static size_t enc_ssse3(char *out, const unsigned char *in, size_t len){
+	const __m128i shift = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+	const __m128i spread = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+	__m128i v, idx, r, lt;
+	size_t i;
+
+	//a block reads 16 bytes for the 12 it encodes
+	for(i = 0; i + 16 <= len; i += 12, out += 16){
+		v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + i)), spread);
+		idx = _mm_or_si128(
+			_mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040)),
+			_mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010)));
+		r = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+		lt = _mm_cmpgt_epi8(_mm_set1_epi8(26), idx);
+		r = _mm_or_si128(r, _mm_and_si128(lt, _mm_set1_epi8(13)));
+		idx = _mm_add_epi8(_mm_shuffle_epi8(shift, r), idx);
+		_mm_storeu_si128((__m128i *)out, idx);
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static size_t enc_avx2(char *out, const unsigned char *in, size_t len){
+	const __m256i shift = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+		'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+	const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+		1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+	__m256i v, idx, r, lt;
+	size_t i;
+
+	//12 bytes into each lane, the second load reads 4 past the block
+	for(i = 0; i + 28 <= len; i += 24, out += 32){
+		v = _mm256_inserti128_si256(_mm256_castsi128_si256(
+			_mm_loadu_si128((const __m128i *)(in + i))),
+			_mm_loadu_si128((const __m128i *)(in + i + 12)), 1);
+		v = _mm256_shuffle_epi8(v, spread);
+		idx = _mm256_or_si256(
+			_mm256_mulhi_epu16(_mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040)),
+			_mm256_mullo_epi16(_mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010)));
+		r = _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+		lt = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), idx);
+		r = _mm256_or_si256(r, _mm256_and_si256(lt, _mm256_set1_epi8(13)));
+		idx = _mm256_add_epi8(_mm256_shuffle_epi8(shift, r), idx);
+		_mm256_storeu_si256((__m256i *)out, idx);
+	}
+	if(len - i >= 16) i += enc_ssse3(out, in + i, len - i);
+	return i;
+}
+
+//decode nblk blocks of 16 characters, return how many were whole alphabet
+__attribute__((target("ssse3")))
+static size_t dec_ssse3(unsigned char *out, const char *in, size_t nblk){
+	const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+		0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+	const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+		0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+		0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	__m128i v, hi, lo, bad, roll;
+	size_t b;
+	int w;
+
+	for(b = 0; b < nblk; b++, in += 16, out += 12){
+		v = _mm_loadu_si128((const __m128i *)in);
+		hi = _mm_and_si128(_mm_srli_epi32(v, 4), _mm_set1_epi8(0x0f));
+		lo = _mm_shuffle_epi8(lut_lo, _mm_and_si128(v, _mm_set1_epi8(0x0f)));
+		bad = _mm_and_si128(lo, _mm_shuffle_epi8(lut_hi, hi));
+		if(_mm_movemask_epi8(_mm_cmpgt_epi8(bad, _mm_setzero_si128())) != 0) break;
+		roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')), hi));
+		v = _mm_add_epi8(v, roll);
+		v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+		v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+		v = _mm_shuffle_epi8(v, pack);
+		_mm_storel_epi64((__m128i *)out, v);
+		w = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+		memcpy(out + 8, &w, 4);
+	}
+	return b;
+}
+
+//blocks of 32 characters, twice what dec_ssse3 counts
+__attribute__((target("avx2")))
+static size_t dec_avx2(unsigned char *out, const char *in, size_t nblk){
+	const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+		0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+		0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+		0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+	const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+		0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+		0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+		0, 0, 0, 0, 0, 0, 0, 0,
+		0, 16, 19, 4, -65, -65, -71, -71,
+		0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+		2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	__m256i v, hi, lo, bad, roll;
+	size_t b;
+
+	for(b = 0; b < nblk; b++, in += 32, out += 24){
+		v = _mm256_loadu_si256((const __m256i *)in);
+		hi = _mm256_and_si256(_mm256_srli_epi32(v, 4), _mm256_set1_epi8(0x0f));
+		lo = _mm256_shuffle_epi8(lut_lo, _mm256_and_si256(v, _mm256_set1_epi8(0x0f)));
+		bad = _mm256_and_si256(lo, _mm256_shuffle_epi8(lut_hi, hi));
+		if(_mm256_movemask_epi8(_mm256_cmpgt_epi8(bad, _mm256_setzero_si256())) != 0) break;
+		roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('/')), hi));
+		v = _mm256_add_epi8(v, roll);
+		v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+		v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+		v = _mm256_shuffle_epi8(v, pack);
+		//12 bytes per lane, gathered into the low 24
+		v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+		_mm_storeu_si128((__m128i *)out, _mm256_castsi256_si128(v));
+		_mm_storel_epi64((__m128i *)(out + 16), _mm256_extracti128_si256(v, 1));
+	}
+	return b;
+}
+
+#endif
+
+int b64_simd(int level){
+	int best = B64_SIMD_NONE;
+#ifdef B64_SIMD
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("ssse3")) best = B64_SIMD_SSSE3;
+	if(__builtin_cpu_supports("avx2")) best = B64_SIMD_AVX2;
+#endif
+	if(level < 0 || level > best) level = best;
+	__atomic_store_n(&b64level, level, __ATOMIC_RELAXED);
+	return level;
+}
+
+static inline int kernel(void){
+	int l = __atomic_load_n(&b64level, __ATOMIC_RELAXED);
+	return l >= 0 ? l : b64_simd(-1);
+}
+
+//encode without line breaks, return characters written
+static size_t enc_raw(char *out, const unsigned char *in, size_t len){
+	size_t i = 0, j;
+	unsigned long v;
+
+#ifdef B64_SIMD
+	switch(kernel()){
+		case B64_SIMD_AVX2: i = enc_avx2(out, in, len); break;
+		case B64_SIMD_SSSE3: i = enc_ssse3(out, in, len); break;
+	}
+#endif
+	for(j = i / 3 * 4; i + 3 <= len; i += 3, j += 4){
+		v = (unsigned long)in[i] << 16 | (unsigned long)in[i+1] << 8 | in[i+2];
+		out[j]   = b64chars[(v >> 18) & 0x3F];
+		out[j+1] = b64chars[(v >> 12) & 0x3F];
+		out[j+2] = b64chars[(v >> 6) & 0x3F];
+		out[j+3] = b64chars[v & 0x3F];
+	}
+	if(i < len){
+		v = (unsigned long)in[i] << 16;
+		if(i + 1 < len) v |= (unsigned long)in[i+1] << 8;
+		out[j]   = b64chars[(v >> 18) & 0x3F];
+		out[j+1] = b64chars[(v >> 12) & 0x3F];
+		out[j+2] = i + 1 < len ? b64chars[(v >> 6) & 0x3F] : '=';
+		out[j+3] = '=';
+		j += 4;
+	}
+	return j;
+}
+
+size_t b64_encode_into(char *out, const unsigned char *in, size_t len, size_t wrap){
+	//lines hold whole groups, as many as fit in wrap or one more
+	size_t line = (wrap + 3) / 4 * 4;
+	size_t raw = (len + 2) / 3 * 4;
+	size_t nl = wrap > 0 && raw > 0 ? (raw - 1) / line : 0;
+	size_t k;
+
+	//encode in one run past where the line breaks go, then slide the
+	//lines down over the gap, each move is to a lower address
+	enc_raw(out + nl, in, len);
+	for(k = 0; k < nl; k++){
+		memmove(out + k * (line + 1), out + nl + k * line, line);
+		out[k * (line + 1) + line] = '\n';
+	}
+	if(nl > 0) memmove(out + nl * (line + 1), out + nl + nl * line, raw - nl * line);
+	return raw + nl;
+}
+
 //encode binary to base64
 //wrap -- how many characters to insert a line wrap (\n) after
 //by default this should be 76 according to RFC2045
 char *b64_encode(const unsigned char *in, size_t len, size_t wrap){
-	char   *out;
-	size_t  elen;
-	size_t  i;
-	size_t  j;
-	size_t  v;
-	size_t  wc = wrap;
+	char *out;
 
 	if (in == NULL || len == 0)
 		return NULL;
 
-	//obtain output size
-	elen = b64_encoded_size(len, wrap);
-	out  = (char *)calloc(elen+1,sizeof(char));
-	//out[elen+1] = '\0';
-	for (i=0, j=0; i<len; i+=3, j+=4) {
-		//line wrap support
-		if( wrap > 0 && wc <= 0 ){
-			out[j++] = '\n';
-			wc = wrap;
-		}
+	out = (char *)calloc(b64_encoded_size(len, wrap) + 1, sizeof(char));
+	if (out == NULL)
+		return NULL;
+	b64_encode_into(out, in, len, wrap);
+	return out;
+}
 
-		//push 3 bytes into an int
-		v = in[i];
-		v = i+1 < len ? v << 8 | in[i+1] : v << 8;
-		v = i+2 < len ? v << 8 | in[i+2] : v << 8;
+size_t b64_decode_into(unsigned char *out, size_t outlen, const char *in, size_t inlen){
+	size_t i = 0, o = 0, n;
+	int q[4], k, pad;
+	signed char v;
 
-		//obtain lookup
-		out[j]   = b64chars[(v >> 18) & 0x3F];
-		out[j+1] = b64chars[(v >> 12) & 0x3F];
-		if (i+1 < len) {
-			out[j+2] = b64chars[(v >> 6) & 0x3F];
-		} else {
-			out[j+2] = '=';
+	for(;;){
+#ifdef B64_SIMD
+		//as many whole blocks as there are, stopping at a line break
+		switch(kernel()){
+			case B64_SIMD_AVX2:
+				n = (inlen - i) / 32 < (outlen - o) / 24 ? (inlen - i) / 32 : (outlen - o) / 24;
+				n = dec_avx2(out + o, in + i, n);
+				i += n * 32; o += n * 24;
+				break;
+			case B64_SIMD_SSSE3:
+				n = (inlen - i) / 16 < (outlen - o) / 12 ? (inlen - i) / 16 : (outlen - o) / 12;
+				n = dec_ssse3(out + o, in + i, n);
+				i += n * 16; o += n * 12;
+				break;
 		}
-		if (i+2 < len) {
-			out[j+3] = b64chars[v & 0x3F];
-		} else {
-			out[j+3] = '=';
+#endif
+		//then a group at a time, back to the blocks after a line break
+		for(n = 0; n < 8; n++){
+			if(i < inlen && in[i] == '\n'){
+				while(i < inlen && in[i] == '\n') i++;
+				break;
+			}
+			for(k = 0, pad = 0; i < inlen && k < 4; i++){
+				if(in[i] == '\n') continue;
+				if(in[i] == '='){ pad = 1; break; }
+				v = b64dec[(unsigned char)in[i]];
+				if(v < 0) return (size_t)-1;
+				q[k++] = v;
+			}
+			//padding ends it, only more of it or line breaks may follow
+			for(; pad && i < inlen; i++) if(in[i] != '=' && in[i] != '\n') return (size_t)-1;
+			if(k == 1) return (size_t)-1;
+			if(k == 0) return o;
+			if(o + (size_t)k - 1 > outlen) return (size_t)-1;
+			out[o++] = (unsigned char)(q[0] << 2 | q[1] >> 4);
+			if(k > 2) out[o++] = (unsigned char)(q[1] << 4 | q[2] >> 2);
+			if(k > 3) out[o++] = (unsigned char)(q[2] << 6 | q[3]);
+			if(k < 4 || i >= inlen) return o;
 		}
-		wc -= 4;
 	}
-	return out;
 }
 
 //decode base64 to binary
 //remember to free the memory once done
-//return 1 upon success and 0 on fail
+//return NULL on fail
 unsigned char *b64_decode(const char *in)
 {
-	size_t outlen = b64_decoded_size(in);
-	unsigned char *out = (unsigned char *)malloc(outlen+1);//include null terminator
-	size_t len;
-	size_t i;
-	size_t j;
-	int    v;
+	unsigned char *out;
+	size_t len, n;
 
 	if (in == NULL)
 		return NULL;
 
 	len = strlen(in);
-	for (i=0; i<len; i++) {
-		if (!b64_isvalidchar(in[i])) {
-			return NULL;
-		}
-	}
-
-	for (i=0, j=0; (i+3)<len; i+=4, j+=3) {
-
-		//skip the newlines
-		if( in[i] == '\n' ){
-			i++;
-			if((i+3) >= len){
-				break;
-			}
-		}
-		v = b64invs[in[i]-43];
-		v = (v << 6) | b64invs[in[i+1]-43];
-		v = in[i+2]=='=' ? v << 6 : (v << 6) | b64invs[in[i+2]-43];
-		v = in[i+3]=='=' ? v << 6 : (v << 6) | b64invs[in[i+3]-43];
-
-		out[j] = (v >> 16) & 0xFF;
-		if (in[i+2] != '=')
-			out[j+1] = (v >> 8) & 0xFF;
-		if (in[i+3] != '=')
-			out[j+2] = v & 0xFF;
-	}
-	/*
-	if(j < outlen && i < len){
-		//probably decode fail
+	out = (unsigned char *)malloc(len / 4 * 3 + 3);//include null terminator
+	if (out == NULL)
+		return NULL;
+	n = b64_decode_into(out, len / 4 * 3 + 2, in, len);
+	if (n == (size_t)-1) {
+		free(out);
 		return NULL;
 	}
-	*/
-
+	out[n] = '\0';
 	return out;
 }
 
@@ -216,31 +405,3 @@ int b64_isvalidchar(char c)
 		return 1;
 	return 0;
 }
-
-/*
- * Test function
- */
-/*
-int main(int argc, char **argv)
-{
-	const char *data = "test to ensure that the decoder works correctly test to ensure that the decoder works correctly test to ensure that the decoder works correctly test to ensure that the decoder works correctly test to ensure that the decoder works correctly";
-	//const char *data = "test to ensure that the decoder works correctly test 321ABCDE";
-	char *enc;
-	char *out;
-
-	printf("enc_in (%lu): %s\n", strlen(data), data);
-	enc = b64_encode((const unsigned char *)data, strlen(data), BASE64_DEFAULT_WRAP);
-	//enc = b64_encode((const unsigned char *)data, strlen(data), 0);
-	printf("enc_out (%lu):\n%s\n", strlen(enc), enc);
-
-	out = (char *)b64_decode(enc);
-	if( out == NULL ){
-		printf("Decode failure\n");
-		return 1;
-	}
-	out[b64_decoded_size(enc)] = '\0'; //for strings
-	printf("dec_ou (%lu,%lu): %s\n", b64_decoded_size(enc),strlen(out), out);
-	free(out);
-	return 0;
-}
-*/
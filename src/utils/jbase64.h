@@ -15,6 +15,11 @@
 
 #define BASE64_DEFAULT_WRAP 76
 
+//kernels for b64_simd
+#define B64_SIMD_NONE	0
+#define B64_SIMD_SSSE3	1
+#define B64_SIMD_AVX2	2
+
 #ifdef __cplusplus
 extern "C"{
 #endif
@@ -41,6 +46,19 @@ char *b64_encode(const unsigned char *in, size_t len, size_t wrap);
 //b64_decoded_size()
 unsigned char *b64_decode(const char *in);
 
+//encode into a buffer of at least b64_encoded_size(len, wrap) bytes,
+//no terminator is written. returns the number of characters written
+size_t b64_encode_into(char *out, const unsigned char *in, size_t len, size_t wrap);
+
+//decode inlen characters into at most outlen bytes, newlines are skipped.
+//returns the number of bytes written, (size_t)-1 on invalid input or if
+//it would not fit
+size_t b64_decode_into(unsigned char *out, size_t outlen, const char *in, size_t inlen);
+
+//pick the kernel, -1 for the best the cpu supports (the default),
+//B64_SIMD_NONE for scalar code. returns the kernel now in use
+int b64_simd(int level);
+
 //check if it is a valid base64 alphabet
 // ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/
 int b64_isvalidchar(char c);
@@ -0,0 +1,272 @@
+/*
+  Key archive conversion
+
+  id2 project
+  chia_jason96@live.com
+*/
+
+#include "kconv.h"
+#include "kstore.h"
+#include "jbase64.h"
+#include "mclock.h"
+#include "debug.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sodium.h>
+
+#define KC_CHUNK (4 << 20)	//archive bytes held at once
+#define KC_MAXTHR 64
+
+//a chunk of whole lines, split into records in place
+struct chunk{
+	char *buf;
+	size_t len;
+	char **id, **key;	//per record, NUL terminated
+	size_t *idlen;
+	unsigned long long *line;	//archive line, for errors
+	size_t n, cap;
+	unsigned char *usk;	//decoded keys, recsz each
+	size_t recsz;
+	int *bad;
+};
+
+struct worker{
+	pthread_t thr;
+	int started;
+	struct chunk *c;
+	size_t from, to;
+};
+
+//decode the keys of records [from, to)
+static void *decode(void *arg){
+	struct worker *w = (struct worker *)arg;
+	struct chunk *c = w->c;
+	size_t i;
+
+	//straight into the record, no key lands on the heap in between
+	for(i = w->from; i < w->to; i++)
+		c->bad[i] = b64_decode_into(c->usk + i * c->recsz, c->recsz,
+			c->key[i], strlen(c->key[i])) != c->recsz;
+	return NULL;
+}
+
+//cut the lines of a chunk into records, 1 on a line without a TAB
+static int split(struct chunk *c, unsigned long long *lineno){
+	char *p = c->buf, *end = c->buf + c->len, *nl, *tab;
+
+	c->n = 0;
+	for(; p < end; p = nl + 1, (*lineno)++){
+		nl = (char *)memchr(p, '\n', (size_t)(end - p));
+		*nl = '\0';
+		if(nl > p && nl[-1] == '\r') nl[-1] = '\0';
+		if(*p == '\0') continue;
+		tab = strchr(p, '\t');
+		if(tab == NULL){
+			lerror("Line %llu is not <ID> TAB <key>\n", *lineno);
+			return 1;
+		}
+		*tab = '\0';
+		if(c->n == c->cap) return 1;
+		c->id[c->n] = p;
+		c->idlen[c->n] = (size_t)(tab - p);
+		c->key[c->n] = tab + 1;
+		c->line[c->n] = *lineno;
+		c->n++;
+	}
+	return 0;
+}
+
+//decode a chunk over the workers, the first range on this thread
+static void decodeall(struct chunk *c, unsigned int threads){
+	struct worker w[KC_MAXTHR];
+	size_t per = (c->n + threads - 1) / threads;
+	unsigned int t, used;
+
+	for(t = 0; t < threads && (size_t)t * per < c->n; t++){
+		w[t].c = c;
+		w[t].from = (size_t)t * per;
+		w[t].to = w[t].from + per < c->n ? w[t].from + per : c->n;
+		w[t].started = t > 0 && pthread_create(&w[t].thr, NULL, decode, &w[t]) == 0;
+		if(t > 0 && !w[t].started) decode(&w[t]);
+	}
+	used = t;
+	if(used > 0) decode(&w[0]);
+	for(t = 1; t < used; t++) if(w[t].started) pthread_join(w[t].thr, NULL);
+}
+
+//records, longest ID and key bytes of the first record (0 - none)
+static int survey(FILE *f, unsigned long long *n, size_t *idmax, size_t *keysz){
+	char buf[1 << 16];
+	size_t r, i, col = 0, idcol = 0, kcol = 0, pad = 0;
+	int intab = 0, first = 1, last = 0;
+
+	*n = 0; *idmax = 0; *keysz = 0;
+	while(!last){
+		r = fread(buf, 1, sizeof(buf), f);
+		//a last line without LF ends as if it had one
+		if(r == 0){ buf[r++] = '\n'; last = 1; }
+		for(i = 0; i < r; i++){
+			if(buf[i] == '\n'){
+				if(col > 0){
+					(*n)++;
+					if(intab == 0) idcol = col;
+					if(idcol > *idmax) *idmax = idcol;
+					if(first && intab){ *keysz = kcol / 4 * 3 - (pad < 3 ? pad : 0); first = 0; }
+				}
+				col = 0; idcol = 0; kcol = 0; pad = 0; intab = 0;
+				continue;
+			}
+			if(buf[i] == '\r') continue;
+			if(buf[i] == '\t' && intab == 0){ intab = 1; idcol = col; }
+			else if(intab){ kcol++; pad = buf[i] == '=' ? pad + 1 : 0; }
+			col++;
+		}
+		if(ferror(f)) return 1;
+	}
+	return 0;
+}
+
+int kconv_import(const char *in, const char *out, unsigned int algo,
+	unsigned int threads, struct kconv_stat *st){
+	struct kstore_writer *w = NULL;
+	struct chunk c;
+	FILE *f;
+	unsigned long long total, lineno = 1;
+	size_t idmax, carry = 0, r, cut, i;
+	uint64_t t0 = mclock_ns();
+	long ncpu;
+	int rc = 0;
+
+	if(st != NULL) memset(st, 0, sizeof(struct kconv_stat));
+	if(threads == 0){
+		ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = ncpu > 0 ? (unsigned int)ncpu : 1;
+	}
+	if(threads > KC_MAXTHR) threads = KC_MAXTHR;
+
+	f = fopen(in, "rb");
+	if(f == NULL){ lerror("Unable to read %s\n", in); return 1; }
+	memset(&c, 0, sizeof(c));
+	if(survey(f, &total, &idmax, &c.recsz) != 0 || c.recsz == 0){
+		lerror("%s holds no keys\n", in);
+		fclose(f); return 1;
+	}
+	rewind(f);
+
+	//every record takes at least 3 bytes (ID, TAB, key)
+	c.cap = KC_CHUNK / 3 + 1;
+	c.buf = (char *)malloc(KC_CHUNK + 1);
+	c.id = (char **)malloc(c.cap * sizeof(char *));
+	c.key = (char **)malloc(c.cap * sizeof(char *));
+	c.idlen = (size_t *)malloc(c.cap * sizeof(size_t));
+	c.line = (unsigned long long *)malloc(c.cap * sizeof(unsigned long long));
+	c.bad = (int *)malloc(c.cap * sizeof(int));
+	c.usk = (unsigned char *)malloc(c.cap * c.recsz);
+	if(c.buf == NULL || c.id == NULL || c.key == NULL || c.idlen == NULL ||
+		c.line == NULL || c.bad == NULL || c.usk == NULL) rc = 1;
+	if(rc == 0){
+		//keys are sized from the first line's base64
+		w = kstore_create(out, algo, c.recsz, idmax, (size_t)total);
+		if(w == NULL) rc = 1;
+	}
+
+	while(rc == 0){
+		r = fread(c.buf + carry, 1, KC_CHUNK - carry, f);
+		if(st != NULL) st->bytes += r;
+		c.len = carry + r;
+		if(c.len == 0) break;
+		//whole lines only, the rest is carried into the next chunk
+		if(r == 0 || feof(f)){
+			if(c.buf[c.len - 1] != '\n') c.buf[c.len++] = '\n';
+			cut = c.len;
+		}else{
+			for(cut = c.len; cut > 0 && c.buf[cut - 1] != '\n'; cut--);
+			if(cut == 0){
+				lerror("Line %llu longer than %d bytes\n", lineno, KC_CHUNK);
+				rc = 1; break;
+			}
+		}
+		carry = c.len - cut;
+		c.len = cut;
+		if(split(&c, &lineno) != 0){ rc = 1; break; }
+		decodeall(&c, threads);
+		for(i = 0; i < c.n && rc == 0; i++){
+			if(c.bad[i]){
+				lerror("Line %llu: key is not %zu bytes of base64\n", c.line[i], c.recsz);
+				rc = 1;
+			}else if(kstore_add(w, (const unsigned char *)c.id[i], c.idlen[i], c.usk + i * c.recsz) != 0){
+				lerror("Line %llu: ID given twice\n", c.line[i]);
+				rc = 1;
+			}
+		}
+		if(st != NULL && rc == 0) st->keys += c.n;
+		memmove(c.buf, c.buf + cut, carry);
+	}
+	fclose(f);
+	if(c.usk != NULL) sodium_memzero(c.usk, c.cap * c.recsz);
+	free(c.buf); free(c.id); free(c.key); free(c.idlen);
+	free(c.line); free(c.bad); free(c.usk);
+	//a store missing any key is removed, not finished into one that opens
+	if(w != NULL && rc != 0) kstore_abort(w);
+	else if(w != NULL && kstore_finish(w) != 0) rc = 1;
+	if(st != NULL) st->seconds = (double)(mclock_ns() - t0) * 1e-9;
+	return rc;
+}
+
+int kconv_export(const char *in, const char *out, struct kconv_stat *st){
+	struct kstore *ks;
+	const unsigned char *key, *id;
+	size_t i, idlen, len;
+	char *enc;
+	FILE *f;
+	uint64_t t0 = mclock_ns();
+	int rc = 0, fd;
+
+	if(st != NULL) memset(st, 0, sizeof(struct kconv_stat));
+	ks = kstore_open(in);
+	if(ks == NULL) return 1;
+	//secret keys, not for other users to read
+	fd = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	f = fd < 0 ? NULL : fdopen(fd, "wb");
+	if(f == NULL){
+		if(fd >= 0) close(fd);
+		lerror("Unable to write %s\n", out);
+		kstore_close(ks); return 1;
+	}
+	//stdio buffers the output, one line buffer is reused for every record
+	len = b64_encoded_size(kstore_recsz(ks), 0);
+	enc = (char *)malloc(len + 1);
+	if(enc == NULL) rc = 1;
+	for(i = 0; rc == 0 && (key = kstore_at(ks, i, &id, &idlen)) != NULL; i++){
+		//the ID column ends at the TAB and the line at LF (a CR before it
+		//is dropped), an ID with any of them would not read back
+		if(memchr(id, '\t', idlen) != NULL || memchr(id, '\n', idlen) != NULL ||
+			memchr(id, '\r', idlen) != NULL){
+			lerror("Record %zu: ID holds a TAB or line break, not archivable\n", i);
+			rc = 1; break;
+		}
+		len = b64_encode_into(enc, key, kstore_recsz(ks), 0);
+		enc[len++] = '\n';
+		if(fwrite(id, 1, idlen, f) != idlen || fputc('\t', f) == EOF ||
+			fwrite(enc, 1, len, f) != len) rc = 1;
+		if(st != NULL){
+			st->keys++;
+			st->bytes += idlen + len + 1;
+		}
+	}
+	if(enc != NULL){
+		sodium_memzero(enc, b64_encoded_size(kstore_recsz(ks), 0) + 1);
+		free(enc);
+	}
+	if(fclose(f) != 0) rc = 1;
+	//nor is a partial archive left to be imported
+	if(rc != 0) unlink(out);
+	kstore_close(ks);
+	if(st != NULL) st->seconds = (double)(mclock_ns() - t0) * 1e-9;
+	return rc;
+}
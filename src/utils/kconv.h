@@ -0,0 +1,43 @@
+/*
+  Key archive conversion
+  streams a base64 key archive into a binary keystore (kstore.h) and
+  back, in bounded memory whatever the archive size. an archive is text,
+  one identity per line:
+    <ID> TAB <user secret key, base64 without line wraps> LF
+  IDs hold no TAB or line break, empty lines are skipped. importing
+  reads the archive twice: once to count and size the store, then a
+  chunk at a time with the keys of a chunk decoded by worker threads
+
+  id2 project
+  chia_jason96@live.com
+*/
+#ifndef _KCONV_H_
+#define _KCONV_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+	struct kconv_stat{
+		unsigned long long keys;	//keys converted
+		unsigned long long bytes;	//archive bytes read or written
+		double seconds;			//wall-clock time taken
+	};
+
+	//archive at in to a new keystore at out for keys of algotype algo
+	//threads 0 picks one per cpu. return 0 on success, else no store is
+	//left at out
+	int kconv_import(const char *in, const char *out, unsigned int algo,
+		unsigned int threads, struct kconv_stat *st);
+
+	//keystore at in to a new archive at out, return 0 on success. a store
+	//with an ID holding a TAB, CR or LF is refused and no archive is left
+	int kconv_export(const char *in, const char *out, struct kconv_stat *st);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -0,0 +1,232 @@
+/*
+  Binary keystore
+
+  id2 project
+  chia_jason96@live.com
+*/
+
+#include "kstore.h"
+#include "debug.h"
+
+#include <sodium.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define KS_HDRSZ 128
+#define KS_ALIGN(v, a) (((v) + (a) - 1) / (a) * (a))
+
+_Static_assert(sizeof(struct kstore_hdr) == KS_HDRSZ, "keystore header layout");
+
+struct kstore{
+	unsigned char *map;
+	size_t size;
+	struct kstore_hdr *h;
+	uint64_t *idx;
+	unsigned char *rec;
+};
+
+struct kstore_writer{
+	struct kstore ks;
+	uint64_t cap;
+	int fd;
+	char *path;	//unlinked on abort
+};
+
+static void layout(struct kstore *ks, unsigned char *map, size_t size){
+	ks->map = map;
+	ks->size = size;
+	ks->h = (struct kstore_hdr *)map;
+	ks->idx = (uint64_t *)(map + ks->h->idxoff);
+	ks->rec = map + ks->h->recoff;
+}
+
+//the record of an ID, else NULL and the empty slot it would go into
+//(nslots when there is none)
+static unsigned char *probe(const struct kstore *ks, const unsigned char *id, size_t idlen, uint64_t *slot){
+	const struct kstore_hdr *h = ks->h;
+	uint64_t hv, s, r, i, n, mask = h->nslots - 1;
+	unsigned char *rec;
+	uint32_t l;
+
+	*slot = h->nslots;
+	if(idlen > h->idmax) return NULL;
+	crypto_shorthash((unsigned char *)&hv, id, idlen, h->hkey);
+	for(i = hv & mask, n = 0; n < h->nslots; i = (i + 1) & mask, n++){
+		s = ks->idx[i];
+		if(s == 0) break;
+		if((s >> 32) != (hv >> 32)) continue;
+		r = (s & 0xffffffffULL) - 1;
+		if(r >= h->count) continue;	//damaged, never followed
+		rec = ks->rec + r * h->stride;
+		memcpy(&l, rec + h->recsz, sizeof(l));
+		if(l == idlen && memcmp(rec + h->recsz + sizeof(l), id, idlen) == 0) return rec;
+	}
+	if(n < h->nslots) *slot = i;
+	return NULL;
+}
+
+struct kstore_writer *kstore_create(const char *path, unsigned int algo,
+	size_t recsz, size_t idmax, size_t count){
+	struct kstore_writer *w;
+	struct kstore_hdr h;
+	unsigned char *map;
+	size_t size;
+
+	if(recsz == 0 || recsz > UINT32_MAX / 4 || idmax > UINT32_MAX / 4 || count >= UINT32_MAX / 2){
+		lerror("Keystore of %zu keys (%zu/%zu bytes) out of range\n", count, recsz, idmax);
+		return NULL;
+	}
+	memset(&h, 0, sizeof(h));
+	h.version = KSTORE_VERSION;
+	h.bom = KSTORE_BOM;
+	h.algo = algo;
+	h.recsz = (uint32_t)recsz;
+	h.idmax = (uint32_t)idmax;
+	h.stride = (uint32_t)KS_ALIGN(recsz + sizeof(uint32_t) + idmax, 8);
+	//at most half full, probes stay short
+	for(h.nslots = 2; h.nslots < 2 * (uint64_t)count; h.nslots *= 2);
+	h.idxoff = KS_HDRSZ;
+	h.recoff = KS_ALIGN(h.idxoff + h.nslots * sizeof(uint64_t), 64);
+	randombytes_buf(h.hkey, sizeof(h.hkey));
+	size = h.recoff + (uint64_t)count * h.stride;
+
+	w = (struct kstore_writer *)malloc(sizeof(struct kstore_writer));
+	if(w == NULL) return NULL;
+	w->path = strdup(path);
+	if(w->path == NULL){ free(w); return NULL; }
+	w->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if(w->fd < 0){
+		lerror("Unable to create %s\n", path);
+		free(w->path); free(w); return NULL;
+	}
+	//the file starts sparse, an all zero index is an empty one
+	if(ftruncate(w->fd, (off_t)size) != 0 ||
+		(map = (unsigned char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, w->fd, 0)) == MAP_FAILED){
+		lerror("Unable to size %s to %zu bytes\n", path, size);
+		close(w->fd); unlink(path);
+		free(w->path); free(w); return NULL;
+	}
+	memcpy(map, &h, sizeof(h));
+	layout(&w->ks, map, size);
+	w->cap = count;
+	return w;
+}
+
+int kstore_add(struct kstore_writer *w, const unsigned char *id, size_t idlen,
+	const unsigned char *usk){
+	struct kstore_hdr *h = w->ks.h;
+	unsigned char *rec;
+	uint64_t slot, hv;
+	uint32_t l = (uint32_t)idlen;
+
+	if(idlen > h->idmax || h->count >= w->cap) return 1;
+	if(probe(&w->ks, id, idlen, &slot) != NULL || slot == h->nslots) return 1;
+
+	rec = w->ks.rec + h->count * h->stride;
+	memcpy(rec, usk, h->recsz);
+	memcpy(rec + h->recsz, &l, sizeof(l));
+	memcpy(rec + h->recsz + sizeof(l), id, idlen);
+	crypto_shorthash((unsigned char *)&hv, id, idlen, h->hkey);
+	w->ks.idx[slot] = (hv & 0xffffffff00000000ULL) | (h->count + 1);
+	h->count++;
+	return 0;
+}
+
+int kstore_finish(struct kstore_writer *w){
+	int rc = 0;
+	//everything else is on disk before the magic that makes it a store
+	if(msync(w->ks.map, w->ks.size, MS_SYNC) != 0) rc = 1;
+	memcpy(w->ks.h->magic, KSTORE_MAGIC, sizeof(w->ks.h->magic));
+	if(msync(w->ks.map, KS_HDRSZ, MS_SYNC) != 0) rc = 1;
+	munmap(w->ks.map, w->ks.size);
+	if(close(w->fd) != 0) rc = 1;
+	free(w->path);
+	free(w);
+	return rc;
+}
+
+void kstore_abort(struct kstore_writer *w){
+	//the magic is never written, and the file goes with it
+	munmap(w->ks.map, w->ks.size);
+	close(w->fd);
+	unlink(w->path);
+	free(w->path);
+	free(w);
+}
+
+struct kstore *kstore_open(const char *path){
+	struct kstore *ks;
+	struct kstore_hdr h;
+	struct stat st;
+	unsigned char *map;
+	size_t size;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if(fd < 0) return NULL;
+	if(fstat(fd, &st) != 0 || (uint64_t)st.st_size < KS_HDRSZ){ close(fd); return NULL; }
+	size = (size_t)st.st_size;
+	map = (unsigned char *)mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED) return NULL;
+	memcpy(&h, map, sizeof(h));
+
+	//every offset a lookup follows is checked once here
+	if(memcmp(h.magic, KSTORE_MAGIC, sizeof(h.magic)) != 0 || h.version != KSTORE_VERSION ||
+		h.bom != KSTORE_BOM || h.recsz == 0 ||
+		h.nslots < 2 || (h.nslots & (h.nslots - 1)) != 0 || h.count >= h.nslots ||
+		h.stride < (uint64_t)h.recsz + sizeof(uint32_t) + h.idmax || h.stride % 8 != 0 ||
+		h.idxoff < KS_HDRSZ || h.idxoff % 8 != 0 || h.idxoff > size ||
+		h.nslots > (size - h.idxoff) / sizeof(uint64_t) ||
+		h.recoff < h.idxoff + h.nslots * sizeof(uint64_t) || h.recoff > size ||
+		h.count > (size - h.recoff) / h.stride){
+		lerror("%s is not a usable keystore\n", path);
+		munmap(map, size);
+		return NULL;
+	}
+	ks = (struct kstore *)malloc(sizeof(struct kstore));
+	if(ks == NULL){ munmap(map, size); return NULL; }
+	layout(ks, map, size);
+	//lookups land anywhere in the file
+	madvise(map, size, MADV_RANDOM);
+	return ks;
+}
+
+const unsigned char *kstore_find(const struct kstore *ks, const unsigned char *id, size_t idlen){
+	uint64_t slot;
+	return probe(ks, id, idlen, &slot);
+}
+
+const unsigned char *kstore_at(const struct kstore *ks, size_t i,
+	const unsigned char **id, size_t *idlen){
+	const unsigned char *rec;
+	uint32_t l;
+	if(i >= ks->h->count) return NULL;
+	rec = ks->rec + i * ks->h->stride;
+	memcpy(&l, rec + ks->h->recsz, sizeof(l));
+	if(id != NULL) *id = rec + ks->h->recsz + sizeof(l);
+	if(idlen != NULL) *idlen = l <= ks->h->idmax ? l : ks->h->idmax;
+	return rec;
+}
+
+unsigned int kstore_algo(const struct kstore *ks){
+	return ks->h->algo;
+}
+
+size_t kstore_recsz(const struct kstore *ks){
+	return ks->h->recsz;
+}
+
+size_t kstore_count(const struct kstore *ks){
+	return ks->h->count;
+}
+
+void kstore_close(struct kstore *ks){
+	if(ks == NULL) return;
+	munmap(ks->map, ks->size);
+	free(ks);
+}
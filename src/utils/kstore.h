@@ -0,0 +1,91 @@
+/*
+  Binary keystore
+  user secret keys of many identities in one file, fixed-size records
+  behind an open addressing index on a keyed hash of the ID. the store
+  is mapped read-only and looked up in constant time without parsing,
+  a key found is a pointer into the mapping (the serialized key, as
+  a25519_sig_sign gives it) valid until the store is closed
+
+  layout (host byte order, a store is refused on a host of the other):
+    header	struct kstore_hdr, 128 bytes
+    index	nslots 64 bit slots, hash tag << 32 | record + 1 (0 - empty)
+    records	from recoff, stride bytes each: key (recsz), ID length
+		(32 bit), ID (up to idmax bytes)
+
+  the files hold secret keys, they are created 0600
+
+  id2 project
+  chia_jason96@live.com
+*/
+#ifndef _KSTORE_H_
+#define _KSTORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define KSTORE_MAGIC "ID2KSTOR"
+#define KSTORE_VERSION 1
+#define KSTORE_BOM 0x01020304u
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+	struct kstore_hdr{
+		char magic[8];		//written last, a store cut short never opens
+		uint32_t version;
+		uint32_t bom;		//KSTORE_BOM
+		uint32_t algo;		//algotype of the keys
+		uint32_t recsz;		//bytes per key, SGNT_SZ of the scheme
+		uint32_t idmax;		//longest ID a record holds
+		uint32_t stride;	//bytes per record
+		uint64_t count;		//records in use
+		uint64_t nslots;	//index slots, a power of 2
+		uint64_t idxoff;
+		uint64_t recoff;
+		unsigned char hkey[16];	//index hash key
+		unsigned char pad[48];
+	};
+
+	struct kstore;
+	struct kstore_writer;
+
+	//a new store at path for up to count keys of recsz bytes, NULL on fail
+	struct kstore_writer *kstore_create(const char *path, unsigned int algo,
+		size_t recsz, size_t idmax, size_t count);
+
+	//add the key usk (recsz bytes) of an ID. return 1 if the ID is too
+	//long, already in or the store is full
+	int kstore_add(struct kstore_writer *w, const unsigned char *id, size_t idlen,
+		const unsigned char *usk);
+
+	//write the header out and close, the writer is freed either way
+	//return 0 if the store is complete on disk
+	int kstore_finish(struct kstore_writer *w);
+
+	//give up a store being written, the file is removed and the writer
+	//freed. nothing of it ever opens as a store
+	void kstore_abort(struct kstore_writer *w);
+
+	//map a store read-only, NULL if it is not one or is damaged
+	struct kstore *kstore_open(const char *path);
+
+	//the key of an ID, NULL if it is not in the store
+	const unsigned char *kstore_find(const struct kstore *ks, const unsigned char *id, size_t idlen);
+
+	//the i-th record, its ID into id and idlen, NULL past the end
+	const unsigned char *kstore_at(const struct kstore *ks, size_t i,
+		const unsigned char **id, size_t *idlen);
+
+	unsigned int kstore_algo(const struct kstore *ks);
+	size_t kstore_recsz(const struct kstore *ks);
+	size_t kstore_count(const struct kstore *ks);
+
+	//unmap, keys found become invalid
+	void kstore_close(struct kstore *ks);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -0,0 +1,42 @@
+/*
+  Monotonic clock helper
+  wall-clock timestamps in nanoseconds, unaffected by time adjustments
+
+  id2 project
+  chia_jason96@live.com
+*/
+#ifndef _MCLOCK_H_
+#define _MCLOCK_H_
+
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MCLOCK_HAVE_CYCLES 1
+#endif
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+//nanoseconds from an arbitrary (fixed) point in the past
+static inline uint64_t mclock_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+//cpu timestamp counter, 0 where there is none (see MCLOCK_HAVE_CYCLES)
+static inline uint64_t mclock_cycles(void){
+#ifdef MCLOCK_HAVE_CYCLES
+	return (uint64_t)__rdtsc();
+#else
+	return 0;
+#endif
+}
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
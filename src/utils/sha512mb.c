@@ -0,0 +1,190 @@
+/*
+  Multi-buffer SHA-512
+
+  id2 project
+  chia_jason96@live.com
+*/
+
+#include "sha512mb.h"
+#include <sodium.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA512MB_SIMD 1
+#endif
+
+#ifdef SHA512MB_SIMD
+
+static const uint64_t K[80] = {
+	0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+	0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+	0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+	0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+	0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+	0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+	0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+	0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+	0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+	0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+	0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+	0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+	0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+	0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+	0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+	0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+	0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+	0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+	0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+	0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+static const uint64_t IV[8] = {
+	0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+	0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+//the message length and padding, 0x80 and the 128 bit length in bits
+//take 17 bytes, so a message fills (len + 17) / 128 blocks rounded up
+static size_t msglen(const struct sha512mb_msg *m){
+	size_t len = 0;
+	unsigned int p;
+	for(p = 0; p < m->nparts; p++) len += m->plen[p];
+	return len;
+}
+
+static size_t nblocks(size_t len){
+	return (len + 17 + 127) / 128;
+}
+
+static uint64_t load64_be(const unsigned char *b){
+	return ((uint64_t)b[0] << 56) | ((uint64_t)b[1] << 48) | ((uint64_t)b[2] << 40) |
+		((uint64_t)b[3] << 32) | ((uint64_t)b[4] << 24) | ((uint64_t)b[5] << 16) |
+		((uint64_t)b[6] << 8) | (uint64_t)b[7];
+}
+
+static void store64_be(unsigned char *b, uint64_t v){
+	int i;
+	for(i = 7; i >= 0; i--){ b[i] = (unsigned char)v; v >>= 8; }
+}
+
+//the b-th block of a message, padded, as big-endian words
+static void block(const struct sha512mb_msg *m, size_t len, size_t b, uint64_t w[16]){
+	unsigned char buf[128];
+	size_t off = b * 128, k, s, d, n;
+	unsigned int p, i;
+
+	memset(buf, 0, sizeof(buf));
+	for(p = 0, k = 0; p < m->nparts; k += m->plen[p], p++){
+		if(k + m->plen[p] <= off || k >= off + 128) continue;
+		s = off > k ? off - k : 0;	//from the part
+		d = k + s - off;		//into the block
+		n = m->plen[p] - s < 128 - d ? m->plen[p] - s : 128 - d;
+		memcpy(buf + d, m->part[p] + s, n);
+	}
+	if(len >= off && len < off + 128) buf[len - off] = 0x80;
+	if(b == nblocks(len) - 1){
+		store64_be(buf + 112, (uint64_t)len >> 61);
+		store64_be(buf + 120, (uint64_t)len << 3);
+	}
+	for(i = 0; i < 16; i++) w[i] = load64_be(buf + 8*i);
+}
+
+//the compression function over T, a gcc vector of 64 bit lanes: scalar
+//operands are broadcast, so the code reads as the one lane version
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+#define S0(x) (ROTR(x, 28) ^ ROTR(x, 34) ^ ROTR(x, 39))
+#define S1(x) (ROTR(x, 14) ^ ROTR(x, 18) ^ ROTR(x, 41))
+#define s0(x) (ROTR(x, 1) ^ ROTR(x, 8) ^ ((x) >> 7))
+#define s1(x) (ROTR(x, 19) ^ ROTR(x, 61) ^ ((x) >> 6))
+#define CH(x, y, z) (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+
+#define SHA512_ROUNDS(T, st, w) do{ \
+	T a = st[0], b = st[1], c = st[2], d = st[3]; \
+	T e = st[4], f = st[5], g = st[6], h = st[7], t1, t2; \
+	int r; \
+	for(r = 0; r < 80; r++){ \
+		if(r >= 16) w[r & 15] += s1(w[(r-2) & 15]) + w[(r-7) & 15] + s0(w[(r-15) & 15]); \
+		t1 = h + S1(e) + CH(e, f, g) + K[r] + w[r & 15]; \
+		t2 = S0(a) + MAJ(a, b, c); \
+		h = g; g = f; f = e; e = d + t1; \
+		d = c; c = b; b = a; a = t1 + t2; \
+	} \
+	st[0] += a; st[1] += b; st[2] += c; st[3] += d; \
+	st[4] += e; st[5] += f; st[6] += g; st[7] += h; \
+}while(0)
+
+//hash up to L messages, lanes whose message ran out of blocks keep
+//their state while the longer ones go on
+#define SHA512_KERNEL(name, T, L, isa) \
+__attribute__((target(isa))) \
+static void name(const struct sha512mb_msg *msg, size_t n){ \
+	T st[8], old[8], w[16]; \
+	uint64_t blk[16]; \
+	size_t len[L], nb[L], maxb = 0, b, l; \
+	int j; \
+	for(l = 0; l < n; l++){ \
+		len[l] = msglen(&msg[l]); \
+		nb[l] = nblocks(len[l]); \
+		if(nb[l] > maxb) maxb = nb[l]; \
+	} \
+	for(j = 0; j < 8; j++) for(l = 0; l < L; l++) st[j][l] = IV[j]; \
+	for(b = 0; b < maxb; b++){ \
+		for(l = 0; l < L; l++){ \
+			if(l < n && b < nb[l]) block(&msg[l], len[l], b, blk); \
+			else memset(blk, 0, sizeof(blk)); \
+			for(j = 0; j < 16; j++) w[j][l] = blk[j]; \
+		} \
+		memcpy(old, st, sizeof(st)); \
+		SHA512_ROUNDS(T, st, w); \
+		for(l = 0; l < n; l++){ \
+			if(b < nb[l]) continue; \
+			for(j = 0; j < 8; j++) st[j][l] = old[j][l]; \
+		} \
+	} \
+	for(l = 0; l < n; l++) \
+		for(j = 0; j < 8; j++) store64_be(msg[l].out + 8*j, st[j][l]); \
+}
+
+typedef uint64_t v4u64 __attribute__((vector_size(32)));
+typedef uint64_t v8u64 __attribute__((vector_size(64)));
+
+SHA512_KERNEL(sha512_x4, v4u64, 4, "avx2")
+SHA512_KERNEL(sha512_x8, v8u64, 8, "avx512f")
+
+#endif
+
+//one message at a time
+static void sha512_x1(const struct sha512mb_msg *m){
+	crypto_hash_sha512_state st;
+	unsigned int p;
+	crypto_hash_sha512_init(&st);
+	for(p = 0; p < m->nparts; p++) crypto_hash_sha512_update(&st, m->part[p], m->plen[p]);
+	crypto_hash_sha512_final(&st, m->out);
+}
+
+unsigned int sha512mb_lanes(void){
+#ifdef SHA512MB_SIMD
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f")) return 8;
+	if(__builtin_cpu_supports("avx2")) return 4;
+#endif
+	return 1;
+}
+
+void sha512mb(const struct sha512mb_msg *msg, size_t n){
+	unsigned int lanes = sha512mb_lanes();
+	size_t i = 0, c;
+
+	while(n - i > 1 && lanes > 1){
+		c = n - i < lanes ? n - i : lanes;
+#ifdef SHA512MB_SIMD
+		//a group that would leave most lanes idle goes to the smaller kernel
+		if(lanes == 8 && c > 4) sha512_x8(msg + i, c);
+		else sha512_x4(msg + i, c);
+#endif
+		i += c;
+	}
+	for(; i < n; i++) sha512_x1(&msg[i]);
+}
@@ -0,0 +1,42 @@
+/*
+  Multi-buffer SHA-512
+  hashes independent messages side by side, one per 64 bit lane of a
+  vector register: 8 at a time with AVX-512, 4 with AVX2, else one by
+  one (libsodium). the kernel is picked at runtime from what the cpu
+  supports, digests are the same as crypto_hash_sha512's
+
+  id2 project
+  chia_jason96@live.com
+*/
+#ifndef _SHA512MB_H_
+#define _SHA512MB_H_
+
+#include <stddef.h>
+
+#define SHA512MB_PARTS 5	//most pieces a message can be given in
+#define SHA512MB_LANES 8	//most messages any kernel hashes at once
+#define SHA512MB_OUTSZ 64
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+	//a message as the concatenation of its parts
+	struct sha512mb_msg{
+		const unsigned char *part[SHA512MB_PARTS];
+		size_t plen[SHA512MB_PARTS];
+		unsigned int nparts;
+		unsigned char *out;	//SHA512MB_OUTSZ bytes
+	};
+
+	//hash n messages, lanes are best used when they are of similar length
+	void sha512mb(const struct sha512mb_msg *msg, size_t n);
+
+	//messages the kernel in use hashes at once
+	unsigned int sha512mb_lanes(void);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
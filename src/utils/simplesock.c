@@ -88,6 +88,21 @@ int sockbind(int sockobj, int portnum){
 	return retval;
 }
 
+int sockbindaddr(int sockobj, const char *bindaddr, int portnum){
+	//bind the created socket to a single local address
+	int retval = -1;
+	struct sockaddr_in remote={0};
+
+	//setup connection params
+	remote.sin_addr.s_addr = inet_addr(bindaddr);
+	remote.sin_family = AF_INET;
+	remote.sin_port = htons(portnum);
+
+	retval = bind(sockobj,(struct sockaddr *)&remote,sizeof(struct sockaddr_in));
+	debug("Socket bound to %s:%d returns %d\n",bindaddr,portnum,retval);
+	return retval;
+}
+
 int sendbuf(int sockobj, char *sendbuffer, size_t buflen){
 	//send via the socket connection
 	uint32_t bleft = buflen;
@@ -97,7 +112,7 @@ int sendbuf(int sockobj, char *sendbuffer, size_t buflen){
 
 	//code enters here when setup is successful
 	while( bleft > 0 ){
-		if(buflen > SEND_BATCH_SIZE) thisbatch = SEND_BATCH_SIZE;
+		if(bleft > SEND_BATCH_SIZE) thisbatch = SEND_BATCH_SIZE;
 		else thisbatch = bleft;
 		sent = send(sockobj, sendbuffer+ptrindex, thisbatch,0);
 		if(sent == -1)break;
@@ -125,7 +140,7 @@ int fixed_recvbuf(int sockobj, char *recvbuffer, size_t buflen){
 	int brecv = 0;
 
 	while( bleft > 0 ){
-		if(buflen > SEND_BATCH_SIZE) thisbatch = SEND_BATCH_SIZE;
+		if(bleft > SEND_BATCH_SIZE) thisbatch = SEND_BATCH_SIZE;
 		else thisbatch = bleft;
 		brecv = recv(sockobj, recvbuffer+ptrindex, thisbatch,0); //here it will block
 		if(brecv <= 0)break;
@@ -29,6 +29,9 @@ int sockconn(int sock,const char *srv,int port); //connect to a socket
 //bind to a port (server)
 int sockbind(int sock,int port); //bind the socket connection
 
+//bind to an address and port (e.g. 127.0.0.1 for local only)
+int sockbindaddr(int sock,const char *addr,int port);
+
 //send a buffer
 int sendbuf(int sock, char *sendbuf, size_t buflen); //send via the socket connection
 
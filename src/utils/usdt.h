@@ -0,0 +1,53 @@
+/*
+  USDT probe points (provider id2), for bpftrace/perf/systemtap
+  compiled in with ./configure --enable-usdt (needs sys/sdt.h), each
+  probe is a single nop until a tracer attaches. list them with
+    readelf -n libid2.so | grep -A2 stapsdt
+
+  sid is the session's socket descriptor, role is USDT_PROVER or
+  USDT_VERIFIER, algo the algotype
+    session__start(algo, sid, role)
+    session__done(algo, sid, role, rc)
+    establish__start(sid, role)		ID string and go-ahead,
+    establish__done(sid, role, rc)	before the scheme is involved
+    move__send(algo, sid, role, len)	a protocol move went out
+    move__recv(algo, sid, role, len)	a protocol move came in
+    crypt__start(algo, sid, role)	scalar multiplications between
+    crypt__done(algo, sid, role)	two moves
+
+  e.g. bpftrace -e 'usdt:./libid2.so:id2:crypt__start { ... }'
+
+  id2 project
+  chia_jason96@live.com
+*/
+#ifndef _USDT_H_
+#define _USDT_H_
+
+#include "config.h"
+
+#define USDT_VERIFIER	0
+#define USDT_PROVER	1
+
+#ifdef USDT
+#include <sys/sdt.h>
+	#define probe_session_start(a, sid, role) DTRACE_PROBE3(id2, session__start, a, sid, role)
+	#define probe_session_done(a, sid, role, rc) DTRACE_PROBE4(id2, session__done, a, sid, role, rc)
+	#define probe_establish_start(sid, role) DTRACE_PROBE2(id2, establish__start, sid, role)
+	#define probe_establish_done(sid, role, rc) DTRACE_PROBE3(id2, establish__done, sid, role, rc)
+	#define probe_move_send(a, sid, role, len) DTRACE_PROBE4(id2, move__send, a, sid, role, len)
+	#define probe_move_recv(a, sid, role, len) DTRACE_PROBE4(id2, move__recv, a, sid, role, len)
+	#define probe_crypt_start(a, sid, role) DTRACE_PROBE3(id2, crypt__start, a, sid, role)
+	#define probe_crypt_done(a, sid, role) DTRACE_PROBE3(id2, crypt__done, a, sid, role)
+#else
+	//dummy defines
+	#define probe_session_start(a, sid, role) ((void)0)
+	#define probe_session_done(a, sid, role, rc) ((void)0)
+	#define probe_establish_start(sid, role) ((void)0)
+	#define probe_establish_done(sid, role, rc) ((void)0)
+	#define probe_move_send(a, sid, role, len) ((void)0)
+	#define probe_move_recv(a, sid, role, len) ((void)0)
+	#define probe_crypt_start(a, sid, role) ((void)0)
+	#define probe_crypt_done(a, sid, role) ((void)0)
+#endif
+
+#endif